@@ -0,0 +1,172 @@
+// aggpar.c
+// Agregação em blocos no pool de threads (ver aggpar.h). Cada argumento vira
+// trechos contíguos de valores (uma coluna, ou o range inteiro quando as
+// colunas são adjacentes), com a posição de cada trecho na sequência. A
+// tarefa b do pool_run calcula o parcial das posições
+// [b * AGGPAR_BLOCK, (b + 1) * AGGPAR_BLOCK) com os kernels de kernels.c;
+// a combinação final é sequencial, porque os blocos são poucos.
+
+#include <math.h>
+#include <stdlib.h>
+#include "aggpar.h"
+#include "kernels.h"
+#include "pool.h"
+
+static int64_t MinValues = 0;    // aggpar_set_min; 0: ainda não resolvido
+
+void aggpar_set_min(int64_t n) {
+    MinValues = n > 0 ? n : 0;
+}
+
+int64_t aggpar_min(void) {
+    if (MinValues) return MinValues;
+    const char *e = getenv("LANGCELL_AGG_PAR_MIN");
+    long long n = e ? atoll(e) : 0;
+    return n > 0 ? n : AGGPAR_MIN_DEFAULT;
+}
+
+int aggpar_supports(int fn) {
+    return fn != AGG_COUNT && fn != AGG_MEDIAN && fn != AGG_PERCENTILE;
+}
+
+// Trecho contíguo da sequência de valores
+typedef struct {
+    const double *ptr;
+    int64_t       len;
+    int64_t       start;    // posição do primeiro valor na sequência
+} Seg;
+
+// Parcial de um bloco: soma, mínimo, máximo ou produto em a; no VAR/STDEV,
+// a média em a e a soma dos quadrados dos desvios em b (Welford)
+typedef struct {
+    int64_t n;
+    double  a, b;
+} Partial;
+
+typedef struct {
+    int          fn;
+    const Seg   *segs;
+    int64_t      nsegs;
+    int64_t      count;
+    Partial     *parts;
+} BlockJob;
+
+// x = x seguido de y. No VAR/STDEV, a fórmula de Chan para juntar duas
+// médias e somas de quadrados.
+static void merge(int fn, Partial *x, const Partial *y) {
+    if (y->n == 0) return;
+    if (x->n == 0) {
+        *x = *y;
+        return;
+    }
+    int64_t n = x->n + y->n;
+    switch (fn) {
+      case AGG_MIN:     if (y->a < x->a) x->a = y->a; break;
+      case AGG_MAX:     if (y->a > x->a) x->a = y->a; break;
+      case AGG_PRODUCT: x->a *= y->a; break;
+      case AGG_VAR:
+      case AGG_STDEV: {
+        double d = y->a - x->a;
+        x->a += d * (double)y->n / (double)n;
+        x->b += y->b + d * d * ((double)x->n * (double)y->n / (double)n);
+        break;
+      }
+      default:          x->a += y->a; break;
+    }
+    x->n = n;
+}
+
+// parcial de v[0, n), n >= 1
+static Partial fold(int fn, const double *v, int64_t n) {
+    const AggKernels *k = kernels_best();
+    Partial p = { n, 0.0, 0.0 };
+    switch (fn) {
+      case AGG_MIN: p.a = k->min(v, n); break;
+      case AGG_MAX: p.a = k->max(v, n); break;
+      case AGG_PRODUCT:
+        p.a = 1.0;
+        for (int64_t i = 0; i < n; ++i) p.a *= v[i];
+        break;
+      case AGG_VAR:
+      case AGG_STDEV: {
+        // Welford sobre os valores deslocados pelo primeiro, como em stats.c
+        double shift = v[0], mean = 0.0;
+        for (int64_t i = 0; i < n; ++i) {
+            double x = v[i] - shift, d = x - mean;
+            mean += d / (double)(i + 1);
+            p.b  += d * (x - mean);
+        }
+        p.a = mean + shift;
+        break;
+      }
+      default: p.a = k->sum(v, n); break;
+    }
+    return p;
+}
+
+static void block_task(void *ctx, int64_t b) {
+    BlockJob *j  = ctx;
+    int64_t   lo = b * AGGPAR_BLOCK;
+    int64_t   hi = lo + AGGPAR_BLOCK < j->count ? lo + AGGPAR_BLOCK : j->count;
+
+    // último trecho que começa até lo
+    int64_t s = 0, e = j->nsegs - 1;
+    while (s < e) {
+        int64_t m = (s + e + 1) / 2;
+        if (j->segs[m].start <= lo) s = m;
+        else                        e = m - 1;
+    }
+
+    Partial p = { 0, 0.0, 0.0 };
+    for (; s < j->nsegs && j->segs[s].start < hi; ++s) {
+        const Seg *g  = &j->segs[s];
+        int64_t from  = lo > g->start ? lo : g->start;
+        int64_t to    = hi < g->start + g->len ? hi : g->start + g->len;
+        if (to <= from) continue;
+        Partial q = fold(j->fn, g->ptr + (from - g->start), to - from);
+        merge(j->fn, &p, &q);
+    }
+    j->parts[b] = p;
+}
+
+double aggpar_run(int fn, int64_t nargs, const AggArg *args, int64_t count) {
+    int64_t maxsegs = 0;
+    for (int64_t a = 0; a < nargs; ++a)
+        if (args[a].rows > 0 && args[a].cols > 0) maxsegs += args[a].cols;
+    int64_t  nblocks = (count + AGGPAR_BLOCK - 1) / AGGPAR_BLOCK;
+    Seg     *segs    = malloc((maxsegs ? maxsegs : 1) * sizeof *segs);
+    Partial *parts   = malloc((nblocks ? nblocks : 1) * sizeof *parts);
+    if (!segs || !parts) exit(1);
+
+    int64_t nsegs = 0, pos = 0;
+    for (int64_t a = 0; a < nargs; ++a) {
+        const AggArg *g = &args[a];
+        int64_t rows = g->rows, cols = g->cols;
+        if (rows <= 0 || cols <= 0) continue;
+        if (cols > 1 && g->stride == rows) {
+            rows *= cols;
+            cols  = 1;
+        }
+        for (int64_t c = 0; c < cols; ++c, pos += rows)
+            segs[nsegs++] = (Seg){ g->ptr + c * g->stride, rows, pos };
+    }
+
+    BlockJob job = { fn, segs, nsegs, count, parts };
+    pool_run(block_task, &job, nblocks);
+
+    // árvore fixa: (0,1) (2,3) ..., depois (0,2) (4,6) ..., e assim por diante
+    for (int64_t w = 1; w < nblocks; w *= 2)
+        for (int64_t i = 0; i + w < nblocks; i += 2 * w)
+            merge(fn, &parts[i], &parts[i + w]);
+    Partial r = nblocks ? parts[0] : (Partial){ 0, 0.0, 0.0 };
+    free(segs);
+    free(parts);
+
+    if (r.n == 0) return 0.0;
+    switch (fn) {
+      case AGG_AVERAGE: return r.a / (double)r.n;
+      case AGG_VAR:     return r.n > 1 ? r.b / (double)(r.n - 1) : 0.0;
+      case AGG_STDEV:   return r.n > 1 ? sqrt(r.b / (double)(r.n - 1)) : 0.0;
+      default:          return r.a;
+    }
+}
@@ -0,0 +1,38 @@
+// aggpar.h
+// Agregação em blocos dos ranges muito grandes, calculada no pool de threads
+// de pool.c. A sequência de valores de uma chamada (argumentos em ordem, cada
+// um coluna a coluna) é cortada em blocos de AGGPAR_BLOCK valores em
+// posições fixas; cada bloco vira um parcial, e os parciais se combinam em
+// árvore (vizinhos aos pares, depois pares de pares). Nem os blocos nem a
+// ordem da combinação dependem de quantas threads há: o resultado é o mesmo
+// bit a bit com 1 ou N threads, e entre uma execução e outra.
+#ifndef LANGCELL_AGGPAR_H
+#define LANGCELL_AGGPAR_H
+
+#include <stdint.h>
+#include "runtime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AGGPAR_BLOCK       (1 << 15)   // valores por bloco (256 KiB)
+#define AGGPAR_MIN_DEFAULT (1 << 20)   // mínimo de valores para usar blocos
+
+// Mínimo de valores de uma chamada para a agregação em blocos. 0 volta ao
+// padrão: LANGCELL_AGG_PAR_MIN, se definida, senão AGGPAR_MIN_DEFAULT
+void    aggpar_set_min(int64_t n);
+int64_t aggpar_min(void);
+
+// fn tem parcial associativo: SUM, AVERAGE, MIN, MAX, PRODUCT, VAR, STDEV
+// (MEDIAN e PERCENTILE ficam na seleção de stats.c)
+int aggpar_supports(int fn);
+
+// fn sobre os args, que somam count valores
+double aggpar_run(int fn, int64_t nargs, const AggArg *args, int64_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_AGGPAR_H
@@ -1,20 +1,100 @@
 // ast.c
 #include "ast.h"
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
+// ——— Arena ———————————————————————————————————————————————————————————————
+// Lista de blocos; só o bloco mais recente recebe novas alocações. Pedidos
+// maiores que ArenaBlock ganham um bloco do tamanho exato.
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *prev;
+    size_t             used, cap;
+    max_align_t        data[];
+} ArenaBlock;
+
+static const size_t ArenaBlockSize = 64 * 1024;
+static ArenaBlock  *arena = NULL;
+
+// Nós criados desde o último ast_release (--stats)
+static int64_t NStmts = 0, NExprs = 0;
+
+void *ast_alloc(size_t size) {
+    const size_t align = sizeof(max_align_t);
+    size = (size + align - 1) & ~(align - 1);
+    if (!arena || arena->cap - arena->used < size) {
+        size_t cap = size > ArenaBlockSize ? size : ArenaBlockSize;
+        ArenaBlock *b = malloc(sizeof *b + cap);
+        if (!b) exit(1);
+        b->prev = arena;
+        b->used = 0;
+        b->cap  = cap;
+        arena   = b;
+    }
+    void *p = (char *)arena->data + arena->used;
+    arena->used += size;
+    return p;
+}
+
+char *ast_strndup(const char *s, size_t n) {
+    char *p = ast_alloc(n + 1);
+    memcpy(p, s, n);
+    p[n] = '\0';
+    return p;
+}
+
+char *ast_strdup(const char *s) {
+    return ast_strndup(s, strlen(s));
+}
+
+void ast_release(void) {
+    while (arena) {
+        ArenaBlock *prev = arena->prev;
+        free(arena);
+        arena = prev;
+    }
+    NStmts = NExprs = 0;
+}
+
+AstMark ast_mark(void) {
+    AstMark m = { arena, arena ? arena->used : 0 };
+    return m;
+}
+
+void ast_release_to(AstMark m) {
+    while (arena && arena != m.block) {
+        ArenaBlock *prev = arena->prev;
+        free(arena);
+        arena = prev;
+    }
+    if (arena) arena->used = m.used;
+}
+
+AstStreamFn ast_stream = NULL;
+
+void ast_node_counts(int64_t *stmts, int64_t *exprs) {
+    *stmts = NStmts;
+    *exprs = NExprs;
+}
+
 // Helpers internos
 static Expr *new_expr(void) {
-    Expr *e = malloc(sizeof *e);
-    if (!e) exit(1);
+    Expr *e = ast_alloc(sizeof *e);
+    NExprs++;
+    e->slot = -1;
+    e->type = TYPE_FLOAT;
     e->next = NULL;
     return e;
 }
 
 static Stmt *new_stmt(void) {
-    Stmt *s = malloc(sizeof *s);
-    if (!s) exit(1);
-    s->next = NULL;
+    Stmt *s = ast_alloc(sizeof *s);
+    NStmts++;
+    s->reads   = NULL;
+    s->n_reads = 0;
+    s->line    = 0;
+    s->next    = NULL;
     return s;
 }
 
@@ -68,8 +148,9 @@ Expr *make_unary_expr(UnaryOp op, Expr *sub) {
 Expr *make_call_expr(const char *fname, Expr *args) {
     Expr *e = new_expr();
     e->kind         = EXPR_CALL;
-    e->call.fname   = strdup(fname);
+    e->call.fname   = ast_strdup(fname);
     e->call.args    = args;
+    e->call.fn      = -1;
     return e;
 }
 
@@ -78,6 +159,11 @@ Expr *make_range_expr(char *start, char *end) {
     e->kind = EXPR_RANGE;
     e->range.start_cell = start;
     e->range.end_cell   = end;
+    e->range.slot       = -1;
+    e->range.rows       = 0;
+    e->range.cols       = 0;
+    e->range.indexed    = 0;
+    e->range.index      = NULL;
     return e;
 }
 
@@ -88,6 +174,8 @@ Stmt *make_assign_stmt(char *cell, Expr *expr) {
     s->kind = STMT_ASSIGN;
     s->assign.cell = cell;
     s->assign.expr = expr;
+    s->assign.slot = -1;
+    s->assign.type = TYPE_FLOAT;
     return s;
 }
 
@@ -104,6 +192,8 @@ Stmt *make_while_stmt(Expr *cond, Stmt *body) {
     s->kind        = STMT_WHILE;
     s->whiles.cond = cond;
     s->whiles.body = body;
+    s->whiles.backedges = 0;
+    s->whiles.tier      = NULL;
     return s;
 }
 
@@ -120,20 +210,41 @@ Stmt *make_export_stmt(char *filename) {
     return s;
 }
 
+Stmt *make_import_stmt(char *filename, char *cell) {
+    Stmt *s = new_stmt();
+    s->kind         = STMT_IMPORT;
+    s->imp.filename = filename;
+    s->imp.cell     = cell;
+    s->imp.col      = s->imp.row = 0;
+    return s;
+}
+
+Stmt *make_save_stmt(char *filename) {
+    Stmt *s = new_stmt();
+    s->kind         = STMT_SAVE;
+    s->exp.filename = filename;
+    return s;
+}
+
+Stmt *make_load_stmt(char *filename) {
+    Stmt *s = new_stmt();
+    s->kind         = STMT_LOAD;
+    s->exp.filename = filename;
+    return s;
+}
+
 // Append em listas
 
-Expr *expr_append(Expr *list, Expr *e) {
-    if (!list) return e;
-    Expr *it = list;
-    while (it->next) it = it->next;
-    it->next = e;
+ExprList expr_list_append(ExprList list, Expr *e) {
+    if (!list.head) list.head = e;
+    else            list.tail->next = e;
+    list.tail = e;
     return list;
 }
 
-Stmt *stmt_append(Stmt *list, Stmt *s) {
-    if (!list) return s;
-    Stmt *it = list;
-    while (it->next) it = it->next;
-    it->next = s;
+StmtList stmt_list_append(StmtList list, Stmt *s) {
+    if (!list.head) list.head = s;
+    else            list.tail->next = s;
+    list.tail = s;
     return list;
 }
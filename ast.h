@@ -3,6 +3,11 @@
 #define LANGCELL_AST_H
 
 #include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef enum {
     TYPE_INT,
@@ -59,13 +64,21 @@ typedef struct Expr {
         struct {               // EXPR_CALL
             char      *fname;
             struct Expr *args;    // lista encadeada em .next
+            int        fn;        // AggFn resolvido pela sema (-1: nenhum)
         } call;
 
         struct {               // EXPR_RANGE
             char *start_cell;
             char *end_cell;
+            int64_t slot;      // canto superior esquerdo (resolvido pela sema)
+            int64_t rows, cols;
+            int     indexed;   // único argumento de uma agregação repetida
+                               // (num WHILE) sobre um range grande (sema)
+            void   *index;     // RangeIndex do interpretador, ou NULL
         } range;
     };
+    int64_t slot;           // EXPR_CELL: índice no grid (resolvido pela sema)
+    Type    type;           // tipo estático (sema): TYPE_INT vira aritmética i64
     struct Expr *next;      // para listas (expression_list)
 } Expr;
 
@@ -75,7 +88,10 @@ typedef enum {
     STMT_IF,
     STMT_WHILE,
     STMT_TABLE,
-    STMT_EXPORT
+    STMT_EXPORT,
+    STMT_IMPORT,
+    STMT_SAVE,
+    STMT_LOAD
 } StmtKind;
 
 typedef struct Stmt {
@@ -84,6 +100,8 @@ typedef struct Stmt {
         struct {                // STMT_ASSIGN
             char *cell;
             Expr *expr;
+            int64_t slot;       // índice no grid (resolvido pela sema)
+            Type type;          // tipo da célula no programa (sema)
         } assign;
         struct {                // STMT_IF
             Expr *cond;
@@ -92,11 +110,23 @@ typedef struct Stmt {
         struct {                // STMT_WHILE
             Expr *cond;
             struct Stmt *body;
+            int64_t backedges;  // iterações interpretadas (modo tiered)
+            void   *tier;       // estado do tier JIT (interp.c), ou NULL
         } whiles;
-        struct {                // STMT_EXPORT
+        struct {                // STMT_EXPORT, STMT_SAVE, STMT_LOAD
             char *filename;
         } exp;
+        struct {                // STMT_IMPORT
+            char *filename;
+            char *cell;         // canto superior esquerdo (AT)
+            int64_t col, row;   // coordenadas de 'cell' (resolvidas pela sema)
+        } imp;
     };
+    // EXPR_CELL e EXPR_RANGE lidos pela expressão do ASSIGN ou pela condição
+    // do IF/WHILE (preenchido pela sema; base do grafo de dependências)
+    Expr   **reads;
+    int64_t  n_reads;
+    int      line;          // linha do fonte onde o statement começa
     struct Stmt *next;      // sequência
 } Stmt;
 
@@ -116,9 +146,43 @@ Stmt *make_if_stmt(Expr *cond, Stmt *then_br);
 Stmt *make_while_stmt(Expr *cond, Stmt *body);
 Stmt *make_table_stmt(void);
 Stmt *make_export_stmt(char *filename);
-
-// Funções de append
-Expr *expr_append(Expr *list, Expr *e);
-Stmt *stmt_append(Stmt *list, Stmt *s);
+Stmt *make_import_stmt(char *filename, char *cell);
+Stmt *make_save_stmt(char *filename);
+Stmt *make_load_stmt(char *filename);
+
+// Listas em construção no parser: guardam o último nó, então cada append é
+// O(1) e montar um programa de N statements é linear
+typedef struct { Expr *head, *tail; } ExprList;
+typedef struct { Stmt *head, *tail; } StmtList;
+
+ExprList expr_list_append(ExprList list, Expr *e);
+StmtList stmt_list_append(StmtList list, Stmt *s);
+
+// Arena da AST: nós e strings (células, textos, nomes de função) são
+// alocados em blocos grandes e liberados todos juntos por ast_release.
+// Nenhum ponteiro da AST é válido depois de ast_release.
+void *ast_alloc(size_t size);
+char *ast_strndup(const char *s, size_t n);
+char *ast_strdup(const char *s);
+void  ast_release(void);
+
+// Ponto da arena: ast_release_to libera tudo o que foi alocado depois dele
+typedef struct { void *block; size_t used; } AstMark;
+AstMark ast_mark(void);
+void    ast_release_to(AstMark m);
+
+// Modo streaming: com ast_stream definido, o parser entrega cada statement
+// de topo assim que o reduz, em vez de acumulá-lo em program_root. 'quiet'
+// é 1 quando o parser ainda não leu nenhum token depois do statement (nada
+// dele está na arena). Um retorno != 0 interrompe o parse.
+typedef int (*AstStreamFn)(Stmt *s, int quiet);
+extern AstStreamFn ast_stream;
+
+// Quantos Stmt e Expr o parser criou (para --stats)
+void  ast_node_counts(int64_t *stmts, int64_t *exprs);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif // LANGCELL_AST_H
@@ -0,0 +1,248 @@
+// bench/bench.c
+// Benchmark de ponta a ponta (make bench): gera cada carga com bench/gen,
+// roda ./langcell --stats=json em cada engine e fica, para cada fase, com
+// o menor tempo entre as rodadas. O resultado vai para um JSON com uma
+// linha por (carga, engine), fácil de comparar com diff; se existir um
+// baseline, mostra a razão atual/baseline de cada fase.
+//
+//   ./bench/bench [-r RODADAS] [-s ESCALA] [-o results.json] [-b baseline.json]
+//
+// make bench-baseline copia o resultado atual para bench/baseline.json.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+typedef struct {
+    const char *kind;
+    long        n;
+} Workload;
+
+static const Workload Workloads[] = {
+    { "straight", 20000   },
+    { "while",    1000000 },
+    { "range",    100000  },
+    { "text",     10000   },
+    { "chain",    20000   },
+};
+#define NWORKLOADS (int)(sizeof Workloads / sizeof *Workloads)
+
+static const char *const Engines[] = { "interp", "vm", "jit" };
+#define NENGINES (int)(sizeof Engines / sizeof *Engines)
+
+// Fases escritas por --stats=json, mais o tempo total do processo
+static const char *const Phases[] = {
+    "parse", "sema", "init", "irgen", "optimize", "finalize", "run", "wall"
+};
+#define NPHASES (int)(sizeof Phases / sizeof *Phases)
+
+typedef struct {
+    char   kind[16], engine[16];
+    long   n;
+    double t[NPHASES];
+    long   maxrss_kb;
+} Result;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Valor numérico de "key": numa linha JSON; 0 se não estiver lá
+static double json_num(const char *line, const char *key) {
+    char pat[32];
+    snprintf(pat, sizeof pat, "\"%s\":", key);
+    const char *p = strstr(line, pat);
+    return p ? strtod(p + strlen(pat), NULL) : 0.0;
+}
+
+static void json_str(const char *line, const char *key, char *out, size_t n) {
+    char pat[32];
+    snprintf(pat, sizeof pat, "\"%s\":\"", key);
+    const char *p = strstr(line, pat);
+    size_t k = 0;
+    if (p)
+        for (p += strlen(pat); *p && *p != '"' && k + 1 < n; ++p) out[k++] = *p;
+    out[k] = '\0';
+}
+
+// Roda o langcell com o programa em 'src' e lê a linha do --stats=json
+static int run_once(const char *engine, const char *src, Result *r) {
+    int err[2];
+    if (pipe(err) != 0) return -1;
+    double t0 = now();
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        char opt[32];
+        snprintf(opt, sizeof opt, "--engine=%s", engine);
+        int in  = open(src, O_RDONLY);
+        int out = open("/dev/null", O_WRONLY);
+        if (in < 0 || out < 0) _exit(127);
+        dup2(in, 0);
+        dup2(out, 1);
+        dup2(err[1], 2);
+        close(err[0]);
+        execl("./langcell", "langcell", opt, "--no-cache", "--stats=json",
+              (char *)NULL);
+        _exit(127);
+    }
+    close(err[1]);
+
+    char   buf[65536];
+    size_t len = 0;
+    ssize_t k;
+    while ((k = read(err[0], buf + len, sizeof buf - 1 - len)) > 0)
+        if ((len += (size_t)k) == sizeof buf - 1) len = 0;   // só a cauda importa
+    buf[len] = '\0';
+    close(err[0]);
+
+    int status;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) < 0) return -1;
+    double wall = now() - t0;
+    const char *line = strstr(buf, "{\"engine\"");
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !line) {
+        fprintf(stderr, "falhou: %s --engine=%s\n%s", src, engine, buf);
+        return -1;
+    }
+    for (int p = 0; p < NPHASES - 1; ++p) r->t[p] = json_num(line, Phases[p]);
+    r->t[NPHASES - 1] = wall;
+    r->maxrss_kb = ru.ru_maxrss;
+    return 0;
+}
+
+static void write_result(FILE *f, const Result *r, int last) {
+    fprintf(f, "  {\"workload\":\"%s\",\"n\":%ld,\"engine\":\"%s\"",
+            r->kind, r->n, r->engine);
+    for (int p = 0; p < NPHASES; ++p) fprintf(f, ",\"%s\":%.6f", Phases[p], r->t[p]);
+    fprintf(f, ",\"maxrss_kb\":%ld}%s\n", r->maxrss_kb, last ? "" : ",");
+}
+
+// Linhas {"workload":...} de um results.json anterior
+static int load_results(const char *path, Result *out, int max) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    char line[1024];
+    int n = 0;
+    while (n < max && fgets(line, sizeof line, f)) {
+        if (!strstr(line, "\"workload\"")) continue;
+        Result *r = &out[n++];
+        json_str(line, "workload", r->kind, sizeof r->kind);
+        json_str(line, "engine", r->engine, sizeof r->engine);
+        r->n = (long)json_num(line, "n");
+        for (int p = 0; p < NPHASES; ++p) r->t[p] = json_num(line, Phases[p]);
+        r->maxrss_kb = (long)json_num(line, "maxrss_kb");
+    }
+    fclose(f);
+    return n;
+}
+
+static void compare(const Result *cur, int ncur, const Result *base, int nbase) {
+    printf("\natual / baseline (fases com mais de 1 ms):\n");
+    printf("%-9s %-7s", "carga", "engine");
+    for (int p = 0; p < NPHASES; ++p) printf(" %8s", Phases[p]);
+    printf("\n");
+    for (int i = 0; i < ncur; ++i) {
+        const Result *b = NULL;
+        for (int j = 0; j < nbase && !b; ++j)
+            if (!strcmp(base[j].kind, cur[i].kind) &&
+                !strcmp(base[j].engine, cur[i].engine) && base[j].n == cur[i].n)
+                b = &base[j];
+        printf("%-9s %-7s", cur[i].kind, cur[i].engine);
+        for (int p = 0; p < NPHASES; ++p) {
+            if (b && b->t[p] > 1e-3 && cur[i].t[p] > 1e-3)
+                printf(" %7.2fx", cur[i].t[p] / b->t[p]);
+            else
+                printf(" %8s", "-");
+        }
+        printf("%s\n", b ? "" : "  (sem baseline)");
+    }
+}
+
+int main(int argc, char **argv) {
+    int         runs     = 3;
+    double      scale    = 1.0;
+    const char *out_path = "bench/results.json";
+    const char *base     = "bench/baseline.json";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if      (!strcmp(argv[i], "-r")) runs     = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "-s")) scale    = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "-o")) out_path = argv[i + 1];
+        else if (!strcmp(argv[i], "-b")) base     = argv[i + 1];
+    }
+    if (runs < 1) runs = 1;
+
+    char src[] = "/tmp/langcell-bench-XXXXXX";
+    int fd = mkstemp(src);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    Result results[NWORKLOADS * NENGINES];
+    int nres = 0, rc = 0;
+    printf("%-9s %-7s %9s %9s %9s %9s %9s\n",
+           "carga", "engine", "parse", "sema", "codegen", "run", "total");
+    for (int w = 0; w < NWORKLOADS; ++w) {
+        long n = (long)(Workloads[w].n * scale);
+        char cmd[256];
+        snprintf(cmd, sizeof cmd, "./bench/gen %s %ld > %s", Workloads[w].kind, n, src);
+        if (system(cmd) != 0) {
+            fprintf(stderr, "falhou: %s\n", cmd);
+            rc = 1;
+            break;
+        }
+        for (int e = 0; e < NENGINES; ++e) {
+            Result *best = &results[nres];
+            memset(best, 0, sizeof *best);
+            snprintf(best->kind, sizeof best->kind, "%s", Workloads[w].kind);
+            snprintf(best->engine, sizeof best->engine, "%s", Engines[e]);
+            best->n = n;
+            int ok = 1;
+            for (int k = 0; k < runs && ok; ++k) {
+                Result r;
+                if (run_once(Engines[e], src, &r) != 0) {
+                    ok = 0;
+                    break;
+                }
+                for (int p = 0; p < NPHASES; ++p)
+                    if (k == 0 || r.t[p] < best->t[p]) best->t[p] = r.t[p];
+                if (r.maxrss_kb > best->maxrss_kb) best->maxrss_kb = r.maxrss_kb;
+            }
+            if (!ok) {
+                rc = 1;
+                continue;
+            }
+            nres++;
+            printf("%-9s %-7s %9.4f %9.4f %9.4f %9.4f %9.4f\n", best->kind,
+                   best->engine, best->t[0], best->t[1],
+                   best->t[2] + best->t[3] + best->t[4] + best->t[5],
+                   best->t[6], best->t[7]);
+        }
+    }
+    unlink(src);
+
+    FILE *f = fopen(out_path, "w");
+    if (!f) {
+        perror(out_path);
+        return 1;
+    }
+    fprintf(f, "{\n\"runs\": %d,\n\"scale\": %g,\n\"results\": [\n", runs, scale);
+    for (int i = 0; i < nres; ++i) write_result(f, &results[i], i == nres - 1);
+    fprintf(f, "]\n}\n");
+    fclose(f);
+    printf("\nresultados em %s\n", out_path);
+
+    Result baseline[NWORKLOADS * NENGINES * 4];
+    int nbase = load_results(base, baseline, (int)(sizeof baseline / sizeof *baseline));
+    if (nbase > 0) compare(results, nres, baseline, nbase);
+    return rc;
+}
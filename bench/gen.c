@@ -0,0 +1,118 @@
+// bench/gen.c
+// Gerador das cargas sintéticas de make bench: escreve em stdout um
+// programa LangCell do tipo pedido, com tamanho n. A saída depende só de
+// (tipo, n, semente), então a mesma carga pode ser refeita em outra máquina.
+//
+//   ./bench/gen straight|while|range|text|chain N [SEMENTE] > carga.lc
+//
+//   straight  N atribuições em linha reta, cada uma lendo células anteriores
+//   while     três WHILE aninhados com ~N iterações no total
+//   range     uma coluna de N células e 64 agregações sobre ela
+//   text      N células de texto seguidas de TABLE
+//   chain     expressões longas (200 termos) somando N termos no total
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned long long Seed = 42;
+
+// LCG de 64 bits: mesma sequência em qualquer libc
+static unsigned rnd(unsigned n) {
+    Seed = Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (unsigned)(Seed >> 33) % n;
+}
+
+// Célula i de uma grade com 1000 linhas por coluna: A1..A1000, B1..
+static const char *cell(long i) {
+    static char buf[4][16];
+    static int  k = 0;
+    char *b = buf[k++ & 3];
+    long  col = i / 1000, row = i % 1000 + 1;
+    char  tmp[8];
+    int   n = 0;
+    do { tmp[n++] = (char)('A' + col % 26); col = col / 26 - 1; } while (col >= 0);
+    int j = 0;
+    while (n > 0) b[j++] = tmp[--n];
+    sprintf(b + j, "%ld", row);
+    return b;
+}
+
+static const char Ops[] = "+-*/";
+
+static void gen_straight(long n) {
+    printf("%s = 7;\n", cell(0));
+    for (long i = 1; i < n; ++i) {
+        long back = i > 7 ? 7 : i;
+        printf("%s = %s %c %u.5 %c %s;\n", cell(i), cell(i - 1),
+               Ops[rnd(4)], rnd(9) + 1, Ops[rnd(2)], cell(i - back));
+    }
+}
+
+static void gen_while(long n) {
+    long inner = 100, mid = 100;
+    long outer = n / (inner * mid);
+    if (outer < 1) outer = 1;
+    printf("A1 = 0;\nB1 = 0;\nC1 = 0;\nD1 = 0;\n");
+    printf("WHILE A1 < %ld {\n", outer);
+    printf("  A1 = A1 + 1;\n  B1 = 0;\n");
+    printf("  WHILE B1 < %ld {\n", mid);
+    printf("    B1 = B1 + 1;\n    C1 = 0;\n");
+    printf("    WHILE C1 < %ld {\n", inner);
+    printf("      C1 = C1 + 1;\n");
+    printf("      D1 = D1 + A1 * 0.5 - B1 / 3 + C1;\n");
+    printf("      IF D1 > 1000000 THEN { D1 = D1 - 1000000; }\n");
+    printf("    }\n  }\n}\n");
+}
+
+static void gen_range(long n) {
+    static const char *aggs[] = { "SUM", "AVERAGE", "MIN", "MAX" };
+    printf("A1 = 1;\nA%ld = 2;\nB1 = 3;\nB%ld = 4;\n", n, n);
+    for (int k = 1; k <= 64; ++k) {
+        if (k % 2) printf("C%d = %s(A1:A%ld) + %d;\n", k, aggs[rnd(4)], n, k);
+        else       printf("C%d = %s(A1:B%ld, C%d);\n", k, aggs[rnd(4)], n, k - 1);
+    }
+}
+
+static void gen_text(long n) {
+    for (long i = 0; i < n; ++i)
+        printf("%s = \"linha %ld, item %u\";\n", cell(i), i, rnd(100000));
+    printf("TABLE;\n");
+}
+
+static void gen_chain(long n) {
+    const int terms = 200;
+    printf("A1 = 1.5;\n");
+    long stmts = n / terms;
+    if (stmts < 1) stmts = 1;
+    for (long s = 1; s <= stmts; ++s) {
+        const char *prev = s > 1 ? cell(s - 1 + 1000) : "A1";
+        printf("%s = %s", cell(s + 1000), prev);
+        for (int t = 1; t < terms; ++t) {
+            if (rnd(3) == 0) printf(" %c %s", Ops[rnd(2)], prev);
+            else             printf(" %c %u.25", Ops[rnd(4)], rnd(9) + 1);
+        }
+        printf(";\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "uso: %s straight|while|range|text|chain N [SEMENTE]\n", argv[0]);
+        return 1;
+    }
+    long n = atol(argv[2]);
+    if (argc > 3) Seed = strtoull(argv[3], NULL, 10);
+    if (n < 1) n = 1;
+
+    if      (strcmp(argv[1], "straight") == 0) gen_straight(n);
+    else if (strcmp(argv[1], "while") == 0)    gen_while(n);
+    else if (strcmp(argv[1], "range") == 0)    gen_range(n);
+    else if (strcmp(argv[1], "text") == 0)     gen_text(n);
+    else if (strcmp(argv[1], "chain") == 0)    gen_chain(n);
+    else {
+        fprintf(stderr, "tipo de carga desconhecido: %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
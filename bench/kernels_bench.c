@@ -0,0 +1,65 @@
+// bench/kernels_bench.c
+// Micro-benchmark dos kernels de agregação: mede GB/s de SUM/MIN/MAX para
+// cada variante suportada pela CPU, ao lado do laço escalar original.
+//
+//   make bench-kernels            (ou ./bench/kernels_bench [n_doubles...])
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../kernels.h"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// evita que o compilador descarte os resultados
+static volatile double sink;
+
+static double bench(double (*f)(const double *, int64_t),
+                    const double *v, int64_t n) {
+    // repete até ~0.2s de medição e fica com a melhor rodada
+    int64_t reps = 1;
+    double best = 1e30;
+    for (;;) {
+        double t0 = now();
+        for (int64_t r = 0; r < reps; ++r) sink = f(v, n);
+        double dt = now() - t0;
+        if (dt / reps < best) best = dt / reps;
+        if (dt > 0.2) break;
+        reps *= 2;
+    }
+    return (double)n * sizeof(double) / best / 1e9;
+}
+
+int main(int argc, char **argv) {
+    int64_t sizes_default[] = { 4096, 262144, 16777216 };
+    int      nsizes = 3;
+    int64_t *sizes  = sizes_default;
+    if (argc > 1) {
+        nsizes = argc - 1;
+        sizes  = malloc(nsizes * sizeof *sizes);
+        for (int i = 0; i < nsizes; ++i) sizes[i] = atoll(argv[i + 1]);
+    }
+
+    printf("melhor variante: %s\n", kernels_isa_name(kernels_best_isa()));
+    printf("%-10s %-8s %10s %10s %10s\n", "n", "isa", "sum GB/s", "min GB/s", "max GB/s");
+    for (int s = 0; s < nsizes; ++s) {
+        int64_t n = sizes[s];
+        double *v = malloc(n * sizeof *v);
+        srand(42);
+        for (int64_t i = 0; i < n; ++i) v[i] = rand() / (double)RAND_MAX;
+
+        for (int isa = 0; isa < ISA_COUNT; ++isa) {
+            const AggKernels *k = kernels_for((KernelIsa)isa);
+            if (!k) continue;
+            printf("%-10lld %-8s %10.2f %10.2f %10.2f\n", (long long)n,
+                   kernels_isa_name((KernelIsa)isa),
+                   bench(k->sum, v, n), bench(k->min, v, n), bench(k->max, v, n));
+        }
+        free(v);
+    }
+    return 0;
+}
@@ -0,0 +1,424 @@
+// cells.c
+// Nomes de células, layout do grid (column-major) e armazenamento em runtime.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cells.h"
+
+int cell_parse(const char *name, int64_t *col, int64_t *row) {
+    const char *p = name;
+    int64_t c = 0;
+    int letters = 0;
+    while (*p >= 'A' && *p <= 'Z') {
+        if (++letters > 10) return -1;   // evita overflow
+        c = c * 26 + (*p - 'A' + 1);
+        p++;
+    }
+    if (letters == 0 || *p < '0' || *p > '9') return -1;
+    int64_t r = 0;
+    while (*p >= '0' && *p <= '9') {
+        if (r > (INT64_MAX - 9) / 10) return -1;
+        r = r * 10 + (*p - '0');
+        p++;
+    }
+    if (*p) return -1;
+    *col = c - 1;
+    *row = r;
+    return 0;
+}
+
+void cell_format(int64_t col, int64_t row, char *buf, size_t n) {
+    char letters[16];
+    int k = 0;
+    for (int64_t c = col + 1; c > 0 && k < 15; c = (c - 1) / 26)
+        letters[k++] = (char)('A' + (c - 1) % 26);
+    char tmp[16];
+    for (int i = 0; i < k; ++i) tmp[i] = letters[k - 1 - i];
+    tmp[k] = '\0';
+    snprintf(buf, n, "%s%lld", tmp, (long long)row);
+}
+
+void layout_init(CellLayout *L) {
+    L->col0 = L->row0 = 0;
+    L->ncols = L->nrows = 0;
+    L->colspan = L->rowspan = NULL;
+    L->ncolspan = L->nrowspan = 0;
+}
+
+void layout_add(CellLayout *L, int64_t col, int64_t row) {
+    if (L->ncols == 0) {
+        L->col0 = col;  L->row0 = row;
+        L->ncols = 1;   L->nrows = 1;
+        return;
+    }
+    int64_t c1 = L->col0 + L->ncols - 1;
+    int64_t r1 = L->row0 + L->nrows - 1;
+    if (col < L->col0) L->col0 = col;
+    if (row < L->row0) L->row0 = row;
+    if (col > c1) c1 = col;
+    if (row > r1) r1 = row;
+    L->ncols = c1 - L->col0 + 1;
+    L->nrows = r1 - L->row0 + 1;
+}
+
+// ——— células citadas pelo programa ————————————————————————————————————————
+// Cada célula ou range vira um retângulo [c0, c1] x [r0, r1]
+
+typedef void (*RectFn)(void *ctx, int64_t c0, int64_t r0, int64_t c1, int64_t r1);
+
+static void walk_name(const char *name, RectFn fn, void *ctx) {
+    int64_t c, r;
+    if (cell_parse(name, &c, &r) == 0) fn(ctx, c, r, c, r);
+}
+
+static void walk_expr(Expr *e, RectFn fn, void *ctx) {
+    switch (e->kind) {
+      case EXPR_CELL:
+        walk_name(e->sval, fn, ctx);
+        break;
+      case EXPR_RANGE: {
+        int64_t sc, sr, ec, er;
+        if (cell_parse(e->range.start_cell, &sc, &sr) == 0 &&
+            cell_parse(e->range.end_cell, &ec, &er) == 0)
+            fn(ctx, sc < ec ? sc : ec, sr < er ? sr : er,
+                    sc < ec ? ec : sc, sr < er ? er : sr);
+        break;
+      }
+      case EXPR_BINARY:
+        walk_expr(e->bin.left, fn, ctx);
+        walk_expr(e->bin.right, fn, ctx);
+        break;
+      case EXPR_UNARY:
+        walk_expr(e->un.sub, fn, ctx);
+        break;
+      case EXPR_CALL:
+        for (Expr *arg = e->call.args; arg; arg = arg->next)
+            walk_expr(arg, fn, ctx);
+        break;
+      default:
+        break;
+    }
+}
+
+static void walk_program(Stmt *s, RectFn fn, void *ctx) {
+    for (; s; s = s->next) {
+        switch (s->kind) {
+          case STMT_ASSIGN:
+            walk_name(s->assign.cell, fn, ctx);
+            walk_expr(s->assign.expr, fn, ctx);
+            break;
+          case STMT_IF:
+            walk_expr(s->ifs.cond, fn, ctx);
+            walk_program(s->ifs.then_branch, fn, ctx);
+            break;
+          case STMT_WHILE:
+            walk_expr(s->whiles.cond, fn, ctx);
+            walk_program(s->whiles.body, fn, ctx);
+            break;
+          case STMT_IMPORT:
+            walk_name(s->imp.cell, fn, ctx);
+            break;
+          case STMT_TABLE:
+          case STMT_EXPORT:
+          case STMT_SAVE:
+          case STMT_LOAD:
+            break;
+        }
+    }
+}
+
+static void add_rect(void *ctx, int64_t c0, int64_t r0, int64_t c1, int64_t r1) {
+    layout_add(ctx, c0, r0);
+    layout_add(ctx, c1, r1);
+}
+
+void layout_add_program(CellLayout *L, Stmt *s) {
+    walk_program(s, add_rect, L);
+}
+
+// ——— eixos compactados ——————————————————————————————————————————————————————
+
+static void layout_oom(void) {
+    fprintf(stderr, "langcell: memória insuficiente para o layout\n");
+    exit(1);
+}
+
+typedef struct {
+    LayoutSpan *s;
+    int64_t     n, cap;
+} SpanList;
+
+typedef struct {
+    SpanList cols, rows;
+} Spans;
+
+static void span_push(SpanList *l, int64_t first, int64_t last) {
+    if (l->n == l->cap) {
+        l->cap = l->cap ? 2 * l->cap : 64;
+        l->s = realloc(l->s, (size_t)l->cap * sizeof *l->s);
+        if (!l->s) layout_oom();
+    }
+    l->s[l->n++] = (LayoutSpan){ first, last - first + 1, 0 };
+}
+
+static void span_rect(void *ctx, int64_t c0, int64_t r0, int64_t c1, int64_t r1) {
+    Spans *sp = ctx;
+    span_push(&sp->cols, c0, c1);
+    span_push(&sp->rows, r0, r1);
+}
+
+static int span_cmp(const void *a, const void *b) {
+    int64_t x = ((const LayoutSpan *)a)->first, y = ((const LayoutSpan *)b)->first;
+    return (x > y) - (x < y);
+}
+
+// Ordena e junta faixas que se tocam; retorna o total de posições
+static int64_t span_merge(SpanList *l) {
+    qsort(l->s, (size_t)l->n, sizeof *l->s, span_cmp);
+    int64_t k = 0, at = 0;
+    for (int64_t i = 0; i < l->n; ++i) {
+        LayoutSpan *p = k ? &l->s[k - 1] : NULL;
+        if (p && l->s[i].first <= p->first + p->len) {
+            int64_t end = l->s[i].first + l->s[i].len;
+            if (end > p->first + p->len) {
+                at += end - (p->first + p->len);
+                p->len = end - p->first;
+            }
+            continue;
+        }
+        l->s[k] = l->s[i];
+        l->s[k].at = at;
+        at += l->s[k].len;
+        k++;
+    }
+    l->n = k;
+    return at;
+}
+
+// Eixo de um layout como faixas: as suas, ou o retângulo inteiro
+static void span_axis(SpanList *l, const LayoutSpan *s, int64_t n,
+                      int64_t first, int64_t len) {
+    if (!s) {
+        if (len > 0) span_push(l, first, first + len - 1);
+        return;
+    }
+    for (int64_t i = 0; i < n; ++i) span_push(l, s[i].first, s[i].first + s[i].len - 1);
+}
+
+// Layout que cobre as faixas de sp: o retângulo em volta delas, ou as
+// próprias faixas se o retângulo for grande e elas ocuparem menos da
+// metade dele. sp passa a ser de L (ou é liberado).
+static int spans_layout(CellLayout *L, Spans *sp) {
+    CellLayout C;
+    layout_init(&C);
+    C.ncols    = span_merge(&sp->cols);
+    C.nrows    = span_merge(&sp->rows);
+    C.colspan  = sp->cols.s;
+    C.rowspan  = sp->rows.s;
+    C.ncolspan = sp->cols.n;
+    C.nrowspan = sp->rows.n;
+    layout_init(L);
+    if (C.ncolspan == 0 || C.nrowspan == 0) {
+        free(sp->cols.s);
+        free(sp->rows.s);
+        return 0;
+    }
+    const LayoutSpan *lc = &C.colspan[C.ncolspan - 1], *lr = &C.rowspan[C.nrowspan - 1];
+    C.col0   = C.colspan[0].first;
+    C.row0   = C.rowspan[0].first;
+    L->col0  = C.col0;
+    L->row0  = C.row0;
+    L->ncols = lc->first + lc->len - C.col0;
+    L->nrows = lr->first + lr->len - C.row0;
+
+    int64_t dense = layout_ncells(L), compact = layout_ncells(&C);
+    if ((dense >= 0 && dense <= LAYOUT_DENSE_MAX) || compact < 0 ||
+        (dense >= 0 && compact > dense / 2)) {
+        free(sp->cols.s);
+        free(sp->rows.s);
+        return dense < 0 ? -1 : 0;
+    }
+    *L = C;
+    return 0;
+}
+
+int layout_compact(CellLayout *L, Stmt *program) {
+    int64_t dense = layout_ncells(L);
+    if (dense >= 0 && dense <= LAYOUT_DENSE_MAX) return 0;
+    Spans sp = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+    walk_program(program, span_rect, &sp);
+    return spans_layout(L, &sp);
+}
+
+int layout_cover(CellLayout *out, const CellLayout *base, Stmt *program,
+                 const CellLayout *extra) {
+    Spans sp = { { NULL, 0, 0 }, { NULL, 0, 0 } };
+    if (base->ncols && base->nrows) {
+        span_axis(&sp.cols, base->colspan, base->ncolspan, base->col0, base->ncols);
+        span_axis(&sp.rows, base->rowspan, base->nrowspan, base->row0, base->nrows);
+    }
+    walk_program(program, span_rect, &sp);
+    if (extra->ncols && extra->nrows) {
+        span_axis(&sp.cols, extra->colspan, extra->ncolspan, extra->col0, extra->ncols);
+        span_axis(&sp.rows, extra->rowspan, extra->nrowspan, extra->row0, extra->nrows);
+    }
+    return spans_layout(out, &sp);
+}
+
+// Cópia das n faixas de s (NULL continua NULL)
+static const LayoutSpan *spans_dup(const LayoutSpan *s, int64_t n) {
+    if (!s) return NULL;
+    LayoutSpan *d = malloc((size_t)n * sizeof *d);
+    if (!d) layout_oom();
+    memcpy(d, s, (size_t)n * sizeof *d);
+    return d;
+}
+
+void layout_copy(CellLayout *dst, const CellLayout *src) {
+    *dst = *src;
+    dst->colspan = spans_dup(src->colspan, src->ncolspan);
+    dst->rowspan = spans_dup(src->rowspan, src->nrowspan);
+}
+
+void layout_free(CellLayout *L) {
+    free((void *)L->colspan);
+    free((void *)L->rowspan);
+    layout_init(L);
+}
+
+int64_t layout_ncells(const CellLayout *L) {
+    int64_t n;
+    if (L->ncols < 0 || L->nrows < 0 ||
+        __builtin_mul_overflow(L->ncols, L->nrows, &n) || n > LAYOUT_MAX_CELLS)
+        return -1;
+    return n;
+}
+
+int64_t layout_span_pos(const LayoutSpan *s, int64_t n, int64_t i) {
+    int64_t lo = 0, hi = n;          // última faixa com first <= i
+    while (hi - lo > 1) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (s[mid].first <= i) lo = mid;
+        else                   hi = mid;
+    }
+    if (n == 0 || i < s[lo].first || i >= s[lo].first + s[lo].len) return -1;
+    return s[lo].at + (i - s[lo].first);
+}
+
+// Índice (coluna ou linha) da posição p de um eixo compactado
+static int64_t span_index(const LayoutSpan *s, int64_t n, int64_t p) {
+    int64_t lo = 0, hi = n;          // última faixa com at <= p
+    while (hi - lo > 1) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (s[mid].at <= p) lo = mid;
+        else                hi = mid;
+    }
+    return s[lo].first + (p - s[lo].at);
+}
+
+int64_t layout_slot(const CellLayout *L, int64_t col, int64_t row) {
+    return layout_find(L, col, row);
+}
+
+void layout_coords(const CellLayout *L, int64_t slot,
+                   int64_t *col, int64_t *row) {
+    int64_t c = slot / L->nrows, r = slot % L->nrows;
+    *col = L->colspan ? span_index(L->colspan, L->ncolspan, c) : L->col0 + c;
+    *row = L->rowspan ? span_index(L->rowspan, L->nrowspan, r) : L->row0 + r;
+}
+
+void layout_name(const CellLayout *L, int64_t slot, char *buf, size_t n) {
+    int64_t col, row;
+    layout_coords(L, slot, &col, &row);
+    cell_format(col, row, buf, n);
+}
+
+// Faixas de um eixo; um eixo denso vira uma faixa só, em *one
+static const LayoutSpan *axis_spans(const LayoutSpan *spans, int64_t nspan,
+                                    int64_t first, int64_t len,
+                                    LayoutSpan *one, int64_t *n) {
+    if (spans) {
+        *n = nspan;
+        return spans;
+    }
+    *one = (LayoutSpan){ first, len, 0 };
+    *n = len > 0;
+    return one;
+}
+
+// Linhas seguidas presentes nos dois grids, por posição em cada eixo
+typedef struct {
+    int64_t from, to, n;
+} RowRun;
+
+void layout_runs(const CellLayout *from, const CellLayout *to,
+                 LayoutRunFn fn, void *ctx) {
+    LayoutSpan fone, tone;
+    int64_t nf, nt;
+    const LayoutSpan *fr = axis_spans(from->rowspan, from->nrowspan,
+                                      from->row0, from->nrows, &fone, &nf);
+    const LayoutSpan *tr = axis_spans(to->rowspan, to->nrowspan,
+                                      to->row0, to->nrows, &tone, &nt);
+
+    // linhas em comum: as mesmas para todas as colunas
+    RowRun *runs = malloc((size_t)(nf + nt + 1) * sizeof *runs);
+    if (!runs) layout_oom();
+    int64_t nruns = 0;
+    for (int64_t i = 0, j = 0; i < nf && j < nt; ) {
+        int64_t lo = fr[i].first > tr[j].first ? fr[i].first : tr[j].first;
+        int64_t fe = fr[i].first + fr[i].len, te = tr[j].first + tr[j].len;
+        int64_t hi = fe < te ? fe : te;
+        if (lo < hi)
+            runs[nruns++] = (RowRun){ fr[i].at + (lo - fr[i].first),
+                                      tr[j].at + (lo - tr[j].first), hi - lo };
+        if (fe <= te) ++i;
+        else          ++j;
+    }
+
+    for (int64_t fc = 0; nruns && fc < from->ncols; ++fc) {
+        int64_t col, row;
+        layout_coords(from, fc * from->nrows, &col, &row);
+        int64_t tc = to->colspan ? layout_span_pos(to->colspan, to->ncolspan, col)
+                                 : col - to->col0;
+        if (tc < 0 || tc >= to->ncols) continue;
+        for (int64_t k = 0; k < nruns; ++k)
+            fn(ctx, fc * from->nrows + runs[k].from,
+                    tc * to->nrows + runs[k].to, runs[k].n);
+    }
+    free(runs);
+}
+
+CellStore *cells_alloc(int64_t ncells) {
+    if (ncells < 0) {       // layout que a sema deveria ter recusado
+        fprintf(stderr, "langcell: grid grande demais\n");
+        exit(1);
+    }
+    // programa sem células: ainda um slot, para que ponteiros nunca sejam NULL
+    size_t n = ncells > 0 ? (size_t)ncells : 1;
+    CellStore *st = malloc(sizeof *st);
+    if (st) {
+        st->num    = calloc(n, sizeof *st->num);
+        st->text   = calloc(n, sizeof *st->text);
+        st->ival   = calloc(n, sizeof *st->ival);
+        st->kind   = calloc(n, sizeof *st->kind);     // V_INT 0 em todo slot
+        st->assigned = calloc(n, sizeof *st->assigned);
+        st->ncells = ncells;
+    }
+    if (!st || !st->num || !st->text || !st->ival || !st->kind || !st->assigned) {
+        fprintf(stderr, "langcell: memória insuficiente para %lld células\n",
+                (long long)ncells);
+        exit(1);
+    }
+    return st;
+}
+
+void cells_free(CellStore *st) {
+    if (!st) return;
+    free(st->num);
+    free((void *)st->text);
+    free(st->ival);
+    free(st->kind);
+    free(st->assigned);
+    free(st);
+}
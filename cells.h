@@ -0,0 +1,130 @@
+// cells.h
+#ifndef LANGCELL_CELLS_H
+#define LANGCELL_CELLS_H
+
+#include <stdint.h>
+#include "ast.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Converte um nome de célula ("B7", "AA12") em coluna e linha.
+// Colunas são bijetivas em base 26: A=0, Z=25, AA=26, ZZ=701, AAA=702...
+// Retorna 0 em caso de sucesso, -1 se o nome for inválido.
+int  cell_parse(const char *name, int64_t *col, int64_t *row);
+
+// Operação inversa: escreve o nome de (col,row) em buf
+void cell_format(int64_t col, int64_t row, char *buf, size_t n);
+
+// Retângulo que cobre todas as células referenciadas pelo programa.
+// As células ficam num vetor denso em column-major:
+//   slot = (col - col0) * nrows + (row - row0)
+// de forma que uma coluna de um range (A1:A100) é contígua na memória.
+//
+// Um programa esparso (A1 e ZZZZ200000) teria um retângulo enorme e quase
+// vazio: nele cada eixo é compactado em faixas, só com as colunas e linhas
+// usadas, e col0/ncols passam a valer para as posições do eixo compactado:
+//   slot = pos(col) * nrows + pos(row)
+// Um range entra inteiro numa faixa, então continua com colunas a nrows
+// slots de distância e linhas contíguas.
+typedef struct {
+    int64_t first;   // primeira coluna (ou linha) da faixa
+    int64_t len;     // colunas (ou linhas) na faixa
+    int64_t at;      // posição de 'first' no eixo compactado
+} LayoutSpan;
+
+typedef struct {
+    int64_t col0, row0;
+    int64_t ncols, nrows;
+    // faixas de cada eixo em ordem crescente, ou NULL se o eixo é denso
+    // (col0 .. col0 + ncols - 1)
+    const LayoutSpan *colspan, *rowspan;
+    int64_t           ncolspan, nrowspan;
+} CellLayout;
+
+// Limite de ncols * nrows: acima dele (ou se a conta estoura) o programa
+// é recusado com "grid grande demais"
+#define LAYOUT_MAX_CELLS  ((int64_t)1 << 40)
+// Retângulos maiores que isso são compactados quando as faixas usadas
+// ocupam menos da metade deles
+#define LAYOUT_DENSE_MAX  ((int64_t)1 << 22)
+
+void    layout_init(CellLayout *L);
+void    layout_add(CellLayout *L, int64_t col, int64_t row);
+void    layout_add_program(CellLayout *L, Stmt *program);
+// Compacta os eixos de L (já com layout_add_program) se o retângulo for
+// grande e esparso; retorna -1 se nem assim o grid cabe em LAYOUT_MAX_CELLS
+int     layout_compact(CellLayout *L, Stmt *program);
+// Modo streaming: out cobre base e extra (as faixas de cada um, ou o
+// retângulo) e as células de program, compactado como em layout_compact.
+// Retorna -1 se não cabe em LAYOUT_MAX_CELLS.
+int     layout_cover(CellLayout *out, const CellLayout *base, Stmt *program,
+                     const CellLayout *extra);
+// Cópia com faixas próprias, liberadas por layout_free
+void    layout_copy(CellLayout *dst, const CellLayout *src);
+void    layout_free(CellLayout *L);
+// ncols * nrows, ou -1 se passa de LAYOUT_MAX_CELLS
+int64_t layout_ncells(const CellLayout *L);
+int64_t layout_slot(const CellLayout *L, int64_t col, int64_t row);
+void    layout_coords(const CellLayout *L, int64_t slot,
+                      int64_t *col, int64_t *row);
+// nome canônico ("B7") do slot
+void    layout_name(const CellLayout *L, int64_t slot, char *buf, size_t n);
+// Posição de um índice num eixo compactado, ou -1 se fora das faixas
+int64_t layout_span_pos(const LayoutSpan *s, int64_t n, int64_t i);
+
+// Slot de (col, row), ou -1 se a célula não está no grid
+static inline int64_t layout_find(const CellLayout *L, int64_t col, int64_t row) {
+    int64_t c = L->colspan ? layout_span_pos(L->colspan, L->ncolspan, col)
+                           : col - L->col0;
+    int64_t r = L->rowspan ? layout_span_pos(L->rowspan, L->nrowspan, row)
+                           : row - L->row0;
+    if (c < 0 || c >= L->ncols || r < 0 || r >= L->nrows) return -1;
+    return c * L->nrows + r;
+}
+
+// Uma coluna (linha) além da última do grid
+static inline int64_t layout_col_end(const CellLayout *L) {
+    if (!L->colspan) return L->col0 + L->ncols;
+    const LayoutSpan *s = &L->colspan[L->ncolspan - 1];
+    return s->first + s->len;
+}
+
+static inline int64_t layout_row_end(const CellLayout *L) {
+    if (!L->rowspan) return L->row0 + L->nrows;
+    const LayoutSpan *s = &L->rowspan[L->nrowspan - 1];
+    return s->first + s->len;
+}
+
+// Trechos comuns a dois layouts: fn(ctx, de, para, n) para cada sequência
+// de n células de uma mesma coluna, em linhas seguidas nos dois grids
+// (slots de..de+n-1 em 'from', para..para+n-1 em 'to')
+typedef void (*LayoutRunFn)(void *ctx, int64_t from, int64_t to, int64_t n);
+void    layout_runs(const CellLayout *from, const CellLayout *to,
+                    LayoutRunFn fn, void *ctx);
+
+// Tipo de valor de uma célula (coluna kind do ValueStore e do CellStore)
+typedef enum { V_INT, V_FLOAT, V_TEXT } ValueKind;
+
+// Armazenamento das células em runtime: um double, um texto, um inteiro,
+// um ValueKind e uma marca de atribuição por slot. Célula V_INT vale ival
+// (num guarda o mesmo valor arredondado, para ranges e agregações); as
+// demais valem num. TABLE/EXPORT/SAVE listam as células com assigned != 0.
+typedef struct CellStore {
+    double         *num;
+    const char    **text;
+    int64_t        *ival;
+    unsigned char  *kind;
+    unsigned char  *assigned;
+    int64_t         ncells;
+} CellStore;
+
+CellStore *cells_alloc(int64_t ncells);
+void       cells_free(CellStore *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_CELLS_H
@@ -0,0 +1,124 @@
+#!/bin/sh
+# check.sh
+# Testes de comportamento (make check). Cada testN.lc que tem um testN.out ao
+# lado roda no ./langcell, e a saída (stdout e stderr juntos) precisa bater
+# com o .out, sem contar a ordem das linhas: o TABLE do JIT sai na ordem do
+# grid e o dos outros motores na ordem das atribuições.
+#
+# Cada linha "// check: <opções>" do teste é uma execução com essas opções;
+# sem nenhuma, o teste roda no JIT, num executável do --emit-exe, no
+# interpretador, na VM e no tiered. Os testes rodam num diretório temporário
+# com cópias dos test*.lc, test*.csv e test*.rc (edições do --recalc), para
+# que EXPORT/IMPORT/SAVE/LOAD e --recalc usem caminhos relativos sem sujar o
+# repositório.
+#
+# "// check: --emit-exe <opções>" compila o teste com as opções num
+# executável ligado com o liblcrt.a (ao lado do ./langcell) e roda o
+# executável: a saída tem que ser a mesma do JIT.
+#
+# "// check: !corrompe DIR" não roda o langcell: sobrescreve com lixo os
+# objetos do cache do JIT em DIR (no diretório temporário), para as
+# execuções seguintes do teste com --cache-dir=DIR.
+#
+# "// check: --serve <opções>" sobe um langcell --serve com as opções e
+# manda, numa conexão, o teste inteiro como SHEET, um RUN por linha
+# "// run: <entradas>", o teste de novo como EVAL e, por fim, o SHEET outra
+# vez (substituindo a planilha) com o primeiro RUN (protocolo em server.h).
+# A saída são as respostas JSON, com os tempos trocados por "_".
+
+LC=$(pwd)/langcell
+DEFAULT_RUNS='--no-cache
+--emit-exe
+--engine=interp
+--engine=vm
+--engine=tiered --tier-threshold=1'
+
+# Cliente do --serve: socket, arquivo do teste
+SERVE_CLIENT='
+use IO::Socket::UNIX;
+my ($path, $file) = @ARGV;
+open(my $in, "<:raw", $file) or die "$file: $!\n";
+my $src = do { local $/; <$in> };
+my @runs = $src =~ m{^// run: *(.*?)\s*$}mg;
+my $s = IO::Socket::UNIX->new(Peer => $path) or die "$path: $!\n";
+binmode $s;
+print $s "SHEET t " . length($src) . "\n" . $src;
+print $s "RUN t $_\n" for @runs;
+print $s "EVAL " . length($src) . "\n" . $src;
+print $s "SHEET t " . length($src) . "\n" . $src;
+print $s "RUN t $runs[0]\n" if @runs;
+shutdown($s, 1);
+print while <$s>;
+'
+
+# serve_run <teste> <opções>: saída em $TMP/got
+serve_run() {
+    sock=$TMP/lc.sock
+    rm -f "$sock"
+    # shellcheck disable=SC2086
+    (cd "$TMP" && exec "$LC" $2 --serve "$sock") > "$TMP/server.log" 2>&1 &
+    pid=$!
+    i=0
+    while [ ! -S "$sock" ] && [ $i -lt 100 ]; do
+        sleep 0.1
+        i=$((i + 1))
+    done
+    perl -e "$SERVE_CLIENT" "$sock" "$1.lc" 2>&1 |
+        sed -e 's/"us":[0-9.e+-]*/"us":_/' \
+            -e 's/"compile_us":[0-9.e+-]*/"compile_us":_/' > "$TMP/got"
+    kill "$pid" 2>/dev/null
+    wait "$pid" 2>/dev/null
+}
+
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+cp test*.lc "$TMP"
+cp test*.csv "$TMP" 2>/dev/null
+cp test*.rc "$TMP" 2>/dev/null
+
+fails=0
+total=0
+for out in test*.out; do
+    t=${out%.out}
+    runs=$(sed -n 's|^// check: *||p' "$t.lc")
+    [ -n "$runs" ] || runs=$DEFAULT_RUNS
+    sort "$out" > "$TMP/expected"
+    while IFS= read -r opts; do
+        case $opts in
+          '!corrompe '*)
+            for o in "$TMP/${opts#!corrompe }"/lc-*.o; do
+                [ -f "$o" ] && echo "objeto corrompido" > "$o"
+            done
+            continue
+            ;;
+        esac
+        total=$((total + 1))
+        case $opts in
+          --serve*)
+            serve_run "$t" "${opts#--serve}"
+            ;;
+          --emit-exe*)
+            # shellcheck disable=SC2086
+            (cd "$TMP" && "$LC" ${opts#--emit-exe} --emit-exe exe < "$t.lc" > got 2>&1 &&
+             ./exe > got 2>&1)
+            rm -f "$TMP/exe"
+            ;;
+          *)
+            # shellcheck disable=SC2086
+            (cd "$TMP" && "$LC" $opts < "$t.lc" > got 2>&1)
+            ;;
+        esac
+        if sort "$TMP/got" | cmp -s - "$TMP/expected"; then
+            echo "ok    $t $opts"
+        else
+            echo "FALHA $t $opts"
+            sort "$TMP/got" | diff "$TMP/expected" - | sed 's/^/      /'
+            fails=$((fails + 1))
+        fi
+    done <<EOF
+$runs
+EOF
+done
+
+echo "$((total - fails))/$total execuções ok"
+[ "$fails" -eq 0 ]
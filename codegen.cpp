@@ -1,10 +1,17 @@
 #include "codegen.h"
 #include "ast.h"
+#include "cells.h"
+#include "runtime.h"
+#include "sema.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 
@@ -14,145 +21,527 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/MCJIT.h"
 #include "llvm/ExecutionEngine/GenericValue.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/OptimizationLevel.h"
+#include "llvm/Analysis/LoopAnalysisManager.h"
+#include "llvm/Analysis/CGSCCPassManager.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/xxhash.h"
+#include "llvm/Support/Program.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Config/llvm-config.h"
 
 using namespace llvm;
 
-// Declare apenas uma vez, aqui:
-static std::map<std::string, GlobalVariable*> CellMap;
-static std::map<std::string, GlobalVariable*> TextMap;
+// Layout do grid do programa (resolvido pela sema, ver cells.h)
+static CellLayout TheLayout;
 
 
-// Helpers do runtime (implementados em interp.c) para funções de agregação e export
-extern "C" double sum_helper(int n, double *vals);
-extern "C" double avg_helper(int n, double *vals);
-extern "C" double min_helper(int n, double *vals);
-extern "C" double max_helper(int n, double *vals);
-extern "C" void export_csv(const char *filename,
-                           int n_cells, const char **names, double *values);
+// ——— globals —————————————————————————————————————————————————————————————
+// O contexto é um ThreadSafeContext para poder ser entregue ao ORC junto do
+// módulo; o MCJIT usa o mesmo LLVMContext por baixo.
+static orc::ThreadSafeContext          TheTSCtx;
+static LLVMContext                    *TheContext          = nullptr;
+static std::unique_ptr<Module>         TheModule;
+static Module                         *TheModuleRaw        = nullptr;
+static unsigned                        ModuleId            = 0;   // muda a cada módulo novo
+static std::unique_ptr<IRBuilder<>>    Builder;
+static ExecutionEngine                *TheExecutionEngine  = nullptr;
+static std::unique_ptr<orc::LLLazyJIT> TheLazyJIT;
 
+// Motor escolhido na linha de comando (ver set_jit_options)
+static JitEngine JitKind        = JIT_MCJIT;
+static unsigned  CompileThreads = 0;
+static int       OptLevel       = 2;   // -O0 .. -O3
 
-// ——— globals —————————————————————————————————————————————————————————————
-static LLVMContext           TheContext;
-static Module               *TheModuleRaw        = nullptr;
-static IRBuilder<>           Builder(TheContext);
-static ExecutionEngine      *TheExecutionEngine  = nullptr;
-static FunctionCallee        PrintfFunc;
-
-// ——— recupera/cria GlobalVariable para 'name' ——————————————————————————————
-static GlobalVariable* getCellGV(const std::string &name) {
-    auto it = CellMap.find(name);
-    if (it != CellMap.end()) return it->second;
-
-    // Desambigua Type do LLVM
-    llvm::Type *dblTy = llvm::Type::getDoubleTy(TheContext);
-    auto *GV = new GlobalVariable(
-        *TheModuleRaw,
-        dblTy,
-        false,
-        GlobalValue::ExternalLinkage,
-        ConstantFP::get(dblTy, 0.0),
-        name
+// --emit-ir / --emit-asm (set_emit_listing)
+static bool EmitIR  = false;
+static bool EmitAsm = false;
+
+// --profile (set_profile): buildModule numera os statements do programa e
+// cria lc_prof com três contadores por ponto (ver LcProfSite em runtime.h).
+// ProfCounters fica nulo com o perfil desligado, e nada é instrumentado.
+static ProfileMode              Profile = PROFILE_OFF;
+static std::vector<std::string> SourceLines;
+static std::map<Stmt*, int64_t> ProfSite;
+static GlobalVariable          *ProfCounters = nullptr;
+
+// Cache de objetos em disco (set_object_cache): CacheKey identifica o
+// programa compilado, vazio quando o cache está desligado
+static std::unique_ptr<ObjectCache> TheObjectCache;
+static std::string                  CacheKey;
+
+// Quantos statements de topo vão para cada função lc_chunk_N. Com o ORC
+// cada chunk só é compilado na primeira chamada, então o primeiro statement
+// roda depois de compilar apenas o primeiro chunk, não o programa inteiro.
+static const int StmtsPerChunk = 64;
+
+// Prefixo dos símbolos externos gerados por buildModule (lc_main,
+// lc_chunk_N, lc_task_N); o modo --serve usa um prefixo por planilha, já
+// que todos os módulos ficam no mesmo motor
+static std::string SymPrefix = "lc";
+
+// Modo --parallel (ver emitParallel): statements independentes viram tarefas
+// executadas no pool de threads de pool.c
+static bool      Parallel    = false;
+static const int MinTaskCost = 4096;   // custo mínimo estimado por tarefa
+
+// Colunas do CellStore (double *num, i8 **text, i64 *ival, i8 *kind,
+// i8 *assigned) na função sendo gerada: todo acesso a célula é um GEP com
+// offset constante sobre esses ponteiros. Toda atribuição marca assigned,
+// que TABLE/EXPORT/SAVE percorrem.
+static llvm::Value *CurNum      = nullptr;
+static llvm::Value *CurText     = nullptr;
+static llvm::Value *CurIval     = nullptr;
+static llvm::Value *CurKind     = nullptr;
+static llvm::Value *CurAssigned = nullptr;
+
+// Laços compilados pelo modo tiered (jit_compile_loop) seguem a semântica
+// do interpretador: valor-verdade é (int)x != 0 e '!=' é verdadeiro para NaN
+static bool InterpSemantics = false;
+
+// Células promovidas pelo WHILE sendo gerado (ver promoteLoopCells): slot →
+// alloca que substitui num[slot] dentro do laço
+static std::map<int64_t, AllocaInst*> Promoted;
+
+// ——— endereço de num[slot] da célula 'name' ——————————————————————————————
+static llvm::Value* getCellPtr(const std::string &name, int64_t slot) {
+    auto it = Promoted.find(slot);
+    if (it != Promoted.end()) return it->second;
+    llvm::Type *dblTy = llvm::Type::getDoubleTy(*TheContext);
+    return Builder->CreateConstInBoundsGEP1_64(dblTy, CurNum, slot, name);
+}
+
+static llvm::Value* getCellTextPtr(const std::string &name, int64_t slot) {
+  llvm::Type *i8ptr = llvm::PointerType::get( llvm::Type::getInt8Ty(*TheContext), 0 );
+  return Builder->CreateConstInBoundsGEP1_64(i8ptr, CurText, slot, name + "_txt");
+}
+
+// Tipos dos parâmetros (num, text, ival, kind, assigned) de lc_main, dos
+// chunks e das tarefas, e os valores correspondentes na função sendo gerada
+static std::vector<llvm::Type*> cellParamTypes() {
+  llvm::Type *i8 = llvm::Type::getInt8Ty(*TheContext);
+  return { PointerType::get(llvm::Type::getDoubleTy(*TheContext), 0),
+           PointerType::get(PointerType::get(i8, 0), 0),
+           PointerType::get(llvm::Type::getInt64Ty(*TheContext), 0),
+           PointerType::get(i8, 0),
+           PointerType::get(i8, 0) };
+}
+
+static std::vector<llvm::Value*> cellArgs() {
+  return { CurNum, CurText, CurIval, CurKind, CurAssigned };
+}
+
+// Passa a gerar código sobre as colunas recebidas por F
+static void setCellArgs(Function *F) {
+  CurNum      = F->getArg(0);
+  CurText     = F->getArg(1);
+  CurIval     = F->getArg(2);
+  CurKind     = F->getArg(3);
+  CurAssigned = F->getArg(4);
+  CurNum->setName("num");
+  CurText->setName("text");
+  CurIval->setName("ival");
+  CurKind->setName("kind");
+  CurAssigned->setName("assigned");
+}
+
+// alloca no bloco de entrada da função, para não crescer a pilha dentro
+// de laços
+static AllocaInst* createEntryAlloca(llvm::Type *Ty, const char *name) {
+    Function *F = Builder->GetInsertBlock()->getParent();
+    IRBuilder<> Tmp(&F->getEntryBlock(), F->getEntryBlock().begin());
+    return Tmp.CreateAlloca(Ty, nullptr, name);
+}
+
+// Atributos das funções de runtime declaradas no módulo: nenhuma lança
+// exceção. Nenhuma é readonly/willreturn: até o agg_helper aloca memória,
+// usa o pool de threads e espera os workers (aggpar.c, stats.c)
+static FunctionCallee runtimeFn(FunctionCallee fc) {
+    if (auto *F = dyn_cast<Function>(fc.getCallee()))
+        F->addFnAttr(Attribute::NoUnwind);
+    return fc;
+}
+
+// struct AggArg de runtime.h: { double*, i64 rows, i64 cols, i64 stride },
+// uma vez por contexto (o --serve com ORC cria um por planilha)
+static StructType* aggArgTy() {
+    if (StructType *Ty = StructType::getTypeByName(*TheContext, "struct.AggArg"))
+        return Ty;
+    llvm::Type *i64 = llvm::Type::getInt64Ty(*TheContext);
+    return StructType::create(
+      *TheContext,
+      { llvm::PointerType::get(llvm::Type::getDoubleTy(*TheContext), 0),
+        i64, i64, i64 },
+      "struct.AggArg"
     );
-    CellMap[name] = GV;
-    return GV;
-}
-
-static GlobalVariable* getCellTextGV(const std::string &name) {
-  auto it = TextMap.find(name);
-  if (it != TextMap.end()) return it->second;
-  // i8* type
-  llvm::Type *i8ptr = llvm::PointerType::get( llvm::Type::getInt8Ty(TheContext), 0 );
-  auto *GV = new GlobalVariable(
-    *TheModuleRaw,
-    i8ptr,
-    false,
-    GlobalValue::ExternalLinkage,
-    llvm::ConstantPointerNull::get(static_cast<llvm::PointerType*>(i8ptr)),
-    name + "_txt"
-  );
-  TextMap[name] = GV;
-  return GV;
 }
 
+// ——— ranges indexados (rangeidx.h) ———————————————————————————————————————
+// Cada range com Expr.range.indexed ganha um RangeIndex* global no módulo,
+// nulo até a primeira consulta (lc_rindex_query o cria). As escritas em
+// células cobertas fora de allocas avisam a árvore com rindex_set, e IMPORT
+// e LOAD a descartam. Ficam de fora os laços do tiered (o interpretador
+// invalida o índice depois deles) e o --parallel, em que tarefas
+// concorrentes escreveriam na mesma árvore.
+struct IndexedRange {
+  int64_t slot, rows, cols;
+  GlobalVariable *G;
+};
+static std::vector<IndexedRange> RangeIndexes;
+
+static llvm::Type* i8PtrTy() {
+    return llvm::PointerType::get(llvm::Type::getInt8Ty(*TheContext), 0);
+}
+
+static void collectIndexesExpr(Expr *e) {
+  switch (e->kind) {
+    case EXPR_UNARY:  collectIndexesExpr(e->un.sub); break;
+    case EXPR_BINARY:
+      collectIndexesExpr(e->bin.left);
+      collectIndexesExpr(e->bin.right);
+      break;
+    case EXPR_CALL:
+      for (Expr *arg = e->call.args; arg; arg = arg->next) {
+        if (arg->kind != EXPR_RANGE) { collectIndexesExpr(arg); continue; }
+        if (!arg->range.indexed) continue;
+        bool seen = false;
+        for (const IndexedRange &R : RangeIndexes)
+          seen = seen || (R.slot == arg->range.slot && R.rows == arg->range.rows &&
+                          R.cols == arg->range.cols);
+        if (seen) continue;
+        auto *G = new GlobalVariable(*TheModuleRaw, i8PtrTy(), false,
+                                     GlobalValue::InternalLinkage,
+                                     ConstantPointerNull::get(
+                                       cast<PointerType>(i8PtrTy())),
+                                     "lc_rindex");
+        RangeIndexes.push_back({ arg->range.slot, arg->range.rows,
+                                 arg->range.cols, G });
+      }
+      break;
+    default: break;
+  }
+}
+
+static void collectIndexes(Stmt *s) {
+  for (; s; s = s->next) {
+    switch (s->kind) {
+      case STMT_ASSIGN: collectIndexesExpr(s->assign.expr); break;
+      case STMT_IF:
+        collectIndexesExpr(s->ifs.cond);
+        collectIndexes(s->ifs.then_branch);
+        break;
+      case STMT_WHILE:
+        collectIndexesExpr(s->whiles.cond);
+        collectIndexes(s->whiles.body);
+        break;
+      default: break;
+    }
+  }
+}
+
+static GlobalVariable* findIndex(const Expr *r) {
+  for (const IndexedRange &R : RangeIndexes)
+    if (R.slot == r->range.slot && R.rows == r->range.rows && R.cols == r->range.cols)
+      return R.G;
+  return nullptr;
+}
+
+// num[slot] passou a valer v (double): atualiza as árvores que o cobrem
+static void indexSet(int64_t slot, Value *v) {
+  int64_t nrows = TheLayout.nrows;
+  for (const IndexedRange &R : RangeIndexes) {
+    int64_t dc = slot / nrows - R.slot / nrows;
+    int64_t dr = slot % nrows - R.slot % nrows;
+    if (dc < 0 || dc >= R.cols || dr < 0 || dr >= R.rows) continue;
+    auto setFn = runtimeFn(TheModuleRaw->getOrInsertFunction(
+      "rindex_set",
+      FunctionType::get(llvm::Type::getVoidTy(*TheContext),
+                        { i8PtrTy(), llvm::Type::getInt64Ty(*TheContext),
+                          llvm::Type::getDoubleTy(*TheContext) }, false)));
+    Builder->CreateCall(setFn, {
+      Builder->CreateLoad(i8PtrTy(), R.G, "rindex"),
+      ConstantInt::get(llvm::Type::getInt64Ty(*TheContext), slot), v });
+  }
+}
+
+// o grid mudou por fora do código gerado: todas as árvores se remontam
+static void indexInvalidate() {
+  for (const IndexedRange &R : RangeIndexes) {
+    auto invFn = runtimeFn(TheModuleRaw->getOrInsertFunction(
+      "rindex_invalidate",
+      FunctionType::get(llvm::Type::getVoidTy(*TheContext), { i8PtrTy() }, false)));
+    Builder->CreateCall(invFn, { Builder->CreateLoad(i8PtrTy(), R.G, "rindex") });
+  }
+}
+
+// ——— células e expressões inteiras ——————————————————————————————————————
+// Expressões TYPE_INT (inferidas pela sema) são geradas em i64: soma,
+// subtração, multiplicação e negação pelos intrínsecos *.with.overflow,
+// comparações com icmp. A divisão é sempre em double, então não há divisão
+// inteira (nem trap por zero) no código gerado. No grid a célula inteira
+// fica exata em ival[], com kind V_INT (num[] guarda o valor arredondado,
+// para ranges e agregações), e dentro de um WHILE fica num registrador i64
+// (promoteLoopCells); o modo tiered também. Células de tipo misto (com
+// atribuições inteiras e double) são feitas em double: só elas, fora de
+// ±2^53, diferem do interpretador.
+//
+// Cada estouro (e cada leitura de uma célula inteira que já não é V_INT)
+// soma seu bit a IntOverflow. Se algum deu 1, a expressão é refeita em
+// double (DoublePath) e vale o que valeria sem a inferência de inteiros,
+// como o V_FLOAT do interpretador; o resultado vai para o grid como double. Uma
+// célula promovida para i64 não tem onde guardá-lo: o laço então grava as
+// células de volta e continua, a partir do statement que estourou, numa
+// cópia gerada em double (ver codegenSlowLoop).
+static Value *IntOverflow = nullptr;
+static bool   DoublePath  = false;
+
+// Início de cada statement na cópia em double do WHILE de fora, e as
+// células que o laço rápido grava de volta antes de saltar para ela
+static std::map<const Stmt*, BasicBlock*> SlowEntry;
+static std::vector<int64_t>               LoopWriteBack;
+
+static bool isInt(const Expr *e) {
+    return !DoublePath && e->type == TYPE_INT;
+}
+
+static void noteOverflow(Value *bit) {
+    IntOverflow = IntOverflow ? Builder->CreateOr(IntOverflow, bit, "ovf") : bit;
+}
+
+// desvio para o caminho raro de um estouro
+static MDNode* unlikelyBranch() {
+    return MDBuilder(*TheContext).createBranchWeights(1, 1 << 20);
+}
+
+// l op r em i64, com o bit de estouro em IntOverflow
+static Value* checkedOp(Intrinsic::ID id, Value *L, Value *R, const char *name) {
+    Value *res = Builder->CreateBinaryIntrinsic(id, L, R, nullptr, name);
+    noteOverflow(Builder->CreateExtractValue(res, 1));
+    return Builder->CreateExtractValue(res, 0, name);
+}
+
+static Value* asDouble(Value *v) {
+    if (!v->getType()->isIntegerTy()) return v;
+    return Builder->CreateSIToFP(v, llvm::Type::getDoubleTy(*TheContext), "int2dbl");
+}
+
+// double → i64. Um valor fora de (-2^63, 2^63), ou NaN, conta como estouro;
+// a conversão satura, então nem ele gera poison
+static Value* asInt64(Value *v) {
+    if (v->getType()->isIntegerTy()) return v;
+    llvm::Type *i64 = llvm::Type::getInt64Ty(*TheContext);
+    Value *mag  = Builder->CreateUnaryIntrinsic(Intrinsic::fabs, v);
+    Value *fits = Builder->CreateFCmpOLT(
+      mag, ConstantFP::get(v->getType(), 9223372036854775808.0), "fits");
+    noteOverflow(Builder->CreateNot(fits));
+    return Builder->CreateIntrinsic(Intrinsic::fptosi_sat, { i64, v->getType() },
+                                    { v }, nullptr, "dbl2int");
+}
+
+static Value* kindConst(ValueKind k) {
+    return ConstantInt::get(llvm::Type::getInt8Ty(*TheContext), k);
+}
+
+static Value* kindPtr(int64_t slot) {
+    llvm::Type *i8 = llvm::Type::getInt8Ty(*TheContext);
+    return Builder->CreateConstInBoundsGEP1_64(i8, CurKind, slot, "kindp");
+}
+
+static Value* ivalPtr(int64_t slot) {
+    llvm::Type *i64 = llvm::Type::getInt64Ty(*TheContext);
+    return Builder->CreateConstInBoundsGEP1_64(i64, CurIval, slot, "ivalp");
+}
+
+// Lê/grava a célula no tipo pedido; o slot pode estar nas colunas do grid
+// ou promovido para uma alloca double ou i64
+static Value* loadCell(const std::string &name, int64_t slot, bool asInt) {
+    llvm::Value *ptr = getCellPtr(name, slot);
+    if (auto *A = dyn_cast<AllocaInst>(ptr)) {
+        Value *v = Builder->CreateLoad(A->getAllocatedType(), A, name);
+        return asInt ? asInt64(v) : asDouble(v);
+    }
+    if (!asInt) return Builder->CreateLoad(llvm::Type::getDoubleTy(*TheContext), ptr, name);
+    Value *kind = Builder->CreateLoad(llvm::Type::getInt8Ty(*TheContext), kindPtr(slot), "kind");
+    noteOverflow(Builder->CreateICmpNE(kind, kindConst(V_INT), "notint"));
+    return Builder->CreateLoad(llvm::Type::getInt64Ty(*TheContext), ivalPtr(slot), name);
+}
+
+// v (i64 ou double) nas colunas do slot, com o ValueKind 'kind' (nullptr:
+// mantém o de kind[]). No tiered um double que o interpretador teria como
+// V_INT também vai para ival, saturado.
+static void storeColumns(int64_t slot, Value *v, Value *kind) {
+    llvm::Type *dblTy = llvm::Type::getDoubleTy(*TheContext);
+    Value *d = asDouble(v);
+    Builder->CreateStore(d, Builder->CreateConstInBoundsGEP1_64(dblTy, CurNum, slot));
+    if (v->getType()->isIntegerTy())
+        Builder->CreateStore(v, ivalPtr(slot));
+    else if (InterpSemantics)
+        Builder->CreateStore(Builder->CreateIntrinsic(
+          Intrinsic::fptosi_sat, { llvm::Type::getInt64Ty(*TheContext), dblTy }, { d }),
+          ivalPtr(slot));
+    if (kind) Builder->CreateStore(kind, kindPtr(slot));
+    indexSet(slot, d);
+}
+
+// Grava v na célula: i64 vira V_INT, double V_FLOAT, ou 'kind' se dado.
+// Numa célula promovida só a alloca muda (o writeBack grava as colunas),
+// salvo o kind[] do tiered, que nenhuma alloca guarda.
+static void storeCell(const std::string &name, int64_t slot, Value *v,
+                      Value *kind = nullptr) {
+    llvm::Value *ptr = getCellPtr(name, slot);
+    if (!kind) kind = kindConst(v->getType()->isIntegerTy() ? V_INT : V_FLOAT);
+    if (auto *A = dyn_cast<AllocaInst>(ptr)) {
+        bool intSlot = A->getAllocatedType()->isIntegerTy();
+        Builder->CreateStore(intSlot ? asInt64(v) : asDouble(v), A);
+        if (InterpSemantics) Builder->CreateStore(kind, kindPtr(slot));
+        return;
+    }
+    storeColumns(slot, v, kind);
+}
+
+// resultado 0/1 de comparações e lógicos, no tipo de e
+static Value* fromBool(Value *b, const Expr *e) {
+    if (isInt(e))
+        return Builder->CreateZExt(b, llvm::Type::getInt64Ty(*TheContext), "bool2int");
+    return Builder->CreateUIToFP(b, llvm::Type::getDoubleTy(*TheContext), "bool2dbl");
+}
+
+// valor-verdade de um double ou i64 como i1
+static Value* codegenTruth(Value *v, const char *name) {
+    if (v->getType()->isIntegerTy())
+        return Builder->CreateICmpNE(v, ConstantInt::get(v->getType(), 0), name);
+    if (InterpSemantics) {
+        llvm::Type *i32 = llvm::Type::getInt32Ty(*TheContext);
+        Value *iv = Builder->CreateIntrinsic(
+          Intrinsic::fptosi_sat, { i32, v->getType() }, { v });
+        return Builder->CreateICmpNE(iv, ConstantInt::get(i32, 0), name);
+    }
+    return Builder->CreateFCmpONE(
+      v, ConstantFP::get(*TheContext, APFloat(0.0)), name);
+}
 
 // ——— gera IR para expressões ——————————————————————————————————————————
 static Value* codegenExpr(Expr *e) {
     switch (e->kind) {
       case EXPR_INT:
+        if (isInt(e))
+          return ConstantInt::get(llvm::Type::getInt64Ty(*TheContext), e->ival, true);
         return ConstantFP::get(
-          llvm::Type::getDoubleTy(TheContext),
+          llvm::Type::getDoubleTy(*TheContext),
           (double)e->ival
         );
       case EXPR_FLOAT:
         return ConstantFP::get(
-          llvm::Type::getDoubleTy(TheContext),
+          llvm::Type::getDoubleTy(*TheContext),
           e->fval
         );
-      case EXPR_CELL: {
-        GlobalVariable *GV = getCellGV(e->sval);
-        return Builder.CreateLoad(
-          GV->getValueType(),
-          GV,
-          e->sval
-        );
+      case EXPR_CELL:
+        return loadCell(e->sval, e->slot, isInt(e));
+      case EXPR_UNARY: {
+        Value *sub = codegenExpr(e->un.sub);
+        if (e->un.op == OP_NEG)
+          return sub->getType()->isIntegerTy()
+                   ? checkedOp(Intrinsic::ssub_with_overflow,
+                               ConstantInt::get(sub->getType(), 0), sub, "negtmp")
+                   : Builder->CreateFNeg(sub, "negtmp");
+        // OP_NOT
+        Value *t = codegenTruth(sub, "nottruth");
+        return fromBool(Builder->CreateNot(t, "nottmp"), e);
       }
       case EXPR_BINARY: {
-        llvm::Type *dblTy = llvm::Type::getDoubleTy(TheContext);
+        llvm::Type *dblTy = llvm::Type::getDoubleTy(*TheContext);
         Value *L = codegenExpr(e->bin.left);
         Value *R = codegenExpr(e->bin.right);
         Value *res = nullptr;
+
+        // i64 só com os dois lados inteiros (e nunca na divisão); um lado
+        // inteiro com o outro double é convertido
+        bool ints = L->getType()->isIntegerTy() && R->getType()->isIntegerTy() &&
+                    e->bin.op != OP_DIV;
+        if (!ints && e->bin.op != OP_AND && e->bin.op != OP_OR) {
+          L = asDouble(L);
+          R = asDouble(R);
+        }
       
         switch (e->bin.op) {
           // aritmética
-          case OP_ADD: res = Builder.CreateFAdd(L, R, "addtmp"); break;
-          case OP_SUB: res = Builder.CreateFSub(L, R, "subtmp"); break;
-          case OP_MUL: res = Builder.CreateFMul(L, R, "multmp"); break;
-          case OP_DIV: res = Builder.CreateFDiv(L, R, "divtmp"); break;
+          case OP_ADD:
+            res = ints ? checkedOp(Intrinsic::sadd_with_overflow, L, R, "addtmp")
+                       : Builder->CreateFAdd(L, R, "addtmp");
+            break;
+          case OP_SUB:
+            res = ints ? checkedOp(Intrinsic::ssub_with_overflow, L, R, "subtmp")
+                       : Builder->CreateFSub(L, R, "subtmp");
+            break;
+          case OP_MUL:
+            res = ints ? checkedOp(Intrinsic::smul_with_overflow, L, R, "multmp")
+                       : Builder->CreateFMul(L, R, "multmp");
+            break;
+          case OP_DIV: res = Builder->CreateFDiv(L, R, "divtmp"); break;
       
-          // comparadores → produzem i1, convertemos para double (1.0 / 0.0)
-          case OP_GT: {
-            Value *cmp = Builder.CreateFCmpOGT(L, R, "gtcmp");
-            res = Builder.CreateUIToFP(cmp, dblTy, "bool2dbl");
-          } break;
-          case OP_LT: {
-            Value *cmp = Builder.CreateFCmpOLT(L, R, "ltcmp");
-            res = Builder.CreateUIToFP(cmp, dblTy, "bool2dbl");
-          } break;
-          case OP_GE: {
-            Value *cmp = Builder.CreateFCmpOGE(L, R, "gecmp");
-            res = Builder.CreateUIToFP(cmp, dblTy, "bool2dbl");
-          } break;
-          case OP_LE: {
-            Value *cmp = Builder.CreateFCmpOLE(L, R, "lecmp");
-            res = Builder.CreateUIToFP(cmp, dblTy, "bool2dbl");
-          } break;
-          case OP_EQ: {
-            Value *cmp = Builder.CreateFCmpOEQ(L, R, "eqcmp");
-            res = Builder.CreateUIToFP(cmp, dblTy, "bool2dbl");
-          } break;
+          // comparadores → produzem i1, convertemos para 1/0 no tipo de e
+          case OP_GT:
+            res = fromBool(ints ? Builder->CreateICmpSGT(L, R, "gtcmp")
+                                : Builder->CreateFCmpOGT(L, R, "gtcmp"), e);
+            break;
+          case OP_LT:
+            res = fromBool(ints ? Builder->CreateICmpSLT(L, R, "ltcmp")
+                                : Builder->CreateFCmpOLT(L, R, "ltcmp"), e);
+            break;
+          case OP_GE:
+            res = fromBool(ints ? Builder->CreateICmpSGE(L, R, "gecmp")
+                                : Builder->CreateFCmpOGE(L, R, "gecmp"), e);
+            break;
+          case OP_LE:
+            res = fromBool(ints ? Builder->CreateICmpSLE(L, R, "lecmp")
+                                : Builder->CreateFCmpOLE(L, R, "lecmp"), e);
+            break;
+          case OP_EQ:
+            res = fromBool(ints ? Builder->CreateICmpEQ(L, R, "eqcmp")
+                                : Builder->CreateFCmpOEQ(L, R, "eqcmp"), e);
+            break;
           case OP_NE: {
-            Value *cmp = Builder.CreateFCmpONE(L, R, "necmp");
-            res = Builder.CreateUIToFP(cmp, dblTy, "bool2dbl");
+            Value *cmp = ints            ? Builder->CreateICmpNE(L, R, "necmp")
+                       : InterpSemantics ? Builder->CreateFCmpUNE(L, R, "necmp")
+                                         : Builder->CreateFCmpONE(L, R, "necmp");
+            res = fromBool(cmp, e);
           } break;
       
           // lógicos → interpretamos 0/!=0
           case OP_AND: {
-            Value *l1 = Builder.CreateFCmpONE(L, ConstantFP::get(dblTy, 0.0), "l1");
-            Value *r1 = Builder.CreateFCmpONE(R, ConstantFP::get(dblTy, 0.0), "r1");
-            Value *andv = Builder.CreateAnd(l1, r1, "andtmp");
-            res = Builder.CreateUIToFP(andv, dblTy, "bool2dbl");
+            Value *l1 = codegenTruth(L, "l1");
+            Value *r1 = codegenTruth(R, "r1");
+            res = fromBool(Builder->CreateAnd(l1, r1, "andtmp"), e);
           } break;
           case OP_OR: {
-            Value *l1 = Builder.CreateFCmpONE(L, ConstantFP::get(dblTy, 0.0), "l1");
-            Value *r1 = Builder.CreateFCmpONE(R, ConstantFP::get(dblTy, 0.0), "r1");
-            Value *orv = Builder.CreateOr(l1, r1, "ortmp");
-            res = Builder.CreateUIToFP(orv, dblTy, "bool2dbl");
+            Value *l1 = codegenTruth(L, "l1");
+            Value *r1 = codegenTruth(R, "r1");
+            res = fromBool(Builder->CreateOr(l1, r1, "ortmp"), e);
           } break;
       
           default:
@@ -165,295 +554,1256 @@ static Value* codegenExpr(Expr *e) {
       
       case EXPR_TEXT: {
         // literal: criamos um GlobalStringPtr para o conteúdo
-        llvm::Value *str = Builder.CreateGlobalStringPtr(
+        llvm::Value *str = Builder->CreateGlobalStringPtr(
           e->sval,
           "strlit"
         );
         return str;  // é um i8*
       }      
       case EXPR_CALL: {
-        // só cobrimos SUM, AVERAGE, MIN, MAX
-        llvm::Type *dblTy = llvm::Type::getDoubleTy(TheContext);
-        const std::string fname = e->call.fname;
-        if (fname=="SUM" || fname=="AVERAGE" || fname=="MIN" || fname=="MAX") {
-            // --- 1) conta quantos elementos irá empacotar em array ---
-            int total = 0;
-            for (Expr *arg = e->call.args; arg; arg = arg->next) {
-                if (arg->kind==EXPR_RANGE) {
-                    // A1:B2 => colA..colB e rowA..rowB
-                    char sc = arg->range.start_cell[0], ec = arg->range.end_cell[0];
-                    int  sr = atoi(arg->range.start_cell+1),
-                         er = atoi(arg->range.end_cell+1);
-                    total += (ec - sc + 1) * (er - sr + 1);
-                } else {
-                    total += 1;
-                }
-            }
-    
-            // --- 2) alloca array de double [total] no stack ---
-            ArrayType *arrTy = ArrayType::get(dblTy, total);
-            Value *arrAlloca = Builder.CreateAlloca(arrTy, nullptr, "argarr");
-    
-            // --- 3) preenche o array ---
-            int idx = 0;
-            for (Expr *arg = e->call.args; arg; arg = arg->next) {
-                if (arg->kind==EXPR_RANGE) {
-                    char sc = arg->range.start_cell[0], ec = arg->range.end_cell[0];
-                    int  sr = atoi(arg->range.start_cell+1),
-                         er = atoi(arg->range.end_cell+1);
-                    for (char c = sc; c <= ec; ++c) {
-                      for (int r = sr; r <= er; ++r) {
-                        // nome da célula
-                        char cell[16];
-                        snprintf(cell, sizeof cell, "%c%d", c, r);
-                        // load do GlobalVariable
-                        GlobalVariable *GV = getCellGV(cell);
-                        Value *val = Builder.CreateLoad(dblTy, GV);
-                        // GEP para arrAlloca[idx]
-                        Value *ptr = Builder.CreateConstGEP2_32(arrTy, arrAlloca, 0, idx);
-                        Builder.CreateStore(val, ptr);
-                        idx++;
-                      }
-                    }
-                } else {
-                    // expr individual
-                    Value *val = codegenExpr(arg);
-                    Value *ptr = Builder.CreateConstGEP2_32(arrTy, arrAlloca, 0, idx++);
-                    Builder.CreateStore(val, ptr);
-                }
+        // qualquer função do registro (AggFn resolvido pela sema)
+        llvm::Type *dblTy = llvm::Type::getDoubleTy(*TheContext);
+        llvm::Type *i64   = llvm::Type::getInt64Ty(*TheContext);
+        int fn = e->call.fn;
+        if (fn < 0) return ConstantFP::get(dblTy, 0.0);   // fallback (retorna 0)
+
+        // range indexado: a árvore responde sem percorrer o range
+        const Expr *r = e->call.args;
+        if (GlobalVariable *G = r->kind == EXPR_RANGE && r->range.indexed && !r->next
+                                  ? findIndex(r) : nullptr) {
+            auto queryFn = runtimeFn(TheModuleRaw->getOrInsertFunction(
+              "lc_rindex_query",
+              FunctionType::get(dblTy, { PointerType::get(i8PtrTy(), 0),
+                                         llvm::Type::getInt32Ty(*TheContext),
+                                         CurNum->getType(), i64, i64, i64, i64 },
+                                false)));
+            return Builder->CreateCall(queryFn, {
+              G, ConstantInt::get(llvm::Type::getInt32Ty(*TheContext), fn), CurNum,
+              ConstantInt::get(i64, r->range.slot), ConstantInt::get(i64, r->range.rows),
+              ConstantInt::get(i64, r->range.cols), ConstantInt::get(i64, TheLayout.nrows) },
+              "rindexq");
+        }
+
+        // --- 1) um AggArg por argumento: o tamanho do IR não depende do
+        //        tamanho dos ranges ---
+        int nargs = 0;
+        for (Expr *arg = e->call.args; arg; arg = arg->next) nargs++;
+        ArrayType *arrTy = ArrayType::get(aggArgTy(), nargs);
+        AllocaInst *argArr = createEntryAlloca(arrTy, "aggargs");
+
+        // os descritores de range não mudam: são preenchidos uma vez, na
+        // entrada da função, e dentro de um laço sobra só a chamada
+        IRBuilder<> Entry(argArr->getParent(), std::next(argArr->getIterator()));
+        int idx = 0;
+        for (Expr *arg = e->call.args; arg; arg = arg->next, ++idx) {
+            Value *ptr;
+            int64_t rows = 1, cols = 1, stride = 1;
+            IRBuilder<> &B = arg->kind == EXPR_RANGE ? Entry : *Builder;
+            if (arg->kind == EXPR_RANGE) {
+                // A1:C3 => bloco de 3 colunas, cada uma contígua no grid
+                rows   = arg->range.rows;
+                cols   = arg->range.cols;
+                stride = TheLayout.nrows;
+                ptr = B.CreateConstInBoundsGEP1_64(
+                        dblTy, CurNum, arg->range.slot, "rangeptr");
+            } else {
+                // expr individual: vai para um double na pilha
+                Value *val = asDouble(codegenExpr(arg));
+                Value *tmp = createEntryAlloca(dblTy, "aggval");
+                B.CreateStore(val, tmp);
+                ptr = tmp;
             }
-    
-            // --- 4) chama o helper sum_helper/avg_helper/... ---
-            // escolhe o nome correto do helper em C
-            std::string helperName;
-            if      (fname == "SUM")     helperName = "sum_helper";
-            else if (fname == "AVERAGE") helperName = "avg_helper";
-            else if (fname == "MIN")     helperName = "min_helper";
-            else if (fname == "MAX")     helperName = "max_helper";
-
-            // declara a função com o nome certo
-            llvm::FunctionCallee helper = TheModuleRaw->getOrInsertFunction(
-              helperName, 
-              llvm::FunctionType::get(
-                dblTy,
-                { llvm::Type::getInt32Ty(TheContext),
-                  llvm::PointerType::get(dblTy, 0) },
-                false
-              )
-            );
-
-            Value *countV = ConstantInt::get(
-                              IntegerType::getInt32Ty(TheContext),
-                              total
-                            );
-            // ptr do array: &arrAlloca[0]
-            Value *dataPtr = Builder.CreateConstGEP2_32(arrTy, arrAlloca, 0, 0);
-            return Builder.CreateCall(helper, { countV, dataPtr }, "callagg");
+            Value *slot = B.CreateConstGEP2_32(arrTy, argArr, 0, idx);
+            B.CreateStore(ptr, B.CreateStructGEP(aggArgTy(), slot, 0));
+            B.CreateStore(ConstantInt::get(i64, rows),
+                          B.CreateStructGEP(aggArgTy(), slot, 1));
+            B.CreateStore(ConstantInt::get(i64, cols),
+                          B.CreateStructGEP(aggArgTy(), slot, 2));
+            B.CreateStore(ConstantInt::get(i64, stride),
+                          B.CreateStructGEP(aggArgTy(), slot, 3));
         }
-    
-        // Para outras chamadas caia no fallback (retorna 0)
-        return ConstantFP::get(dblTy, 0.0);
+
+        // --- 2) chama agg_helper(fn, nargs, args) ---
+        // o agg_helper não guarda os descritores depois de voltar
+        llvm::FunctionCallee helper = runtimeFn(TheModuleRaw->getOrInsertFunction(
+          "agg_helper",
+          llvm::FunctionType::get(
+            dblTy,
+            { llvm::Type::getInt32Ty(*TheContext), i64,
+              llvm::PointerType::get(aggArgTy(), 0) },
+            false
+          )
+        ));
+        if (auto *HF = dyn_cast<Function>(helper.getCallee()))
+          HF->addParamAttr(2, Attribute::NoCapture);
+        Value *dataPtr = Builder->CreateConstGEP2_32(arrTy, argArr, 0, 0);
+        return Builder->CreateCall(
+          helper,
+          { ConstantInt::get(llvm::Type::getInt32Ty(*TheContext), fn),
+            ConstantInt::get(i64, nargs),
+            dataPtr },
+          "callagg");
     }
     
       default:
         return ConstantFP::get(
-          llvm::Type::getDoubleTy(TheContext),
+          llvm::Type::getDoubleTy(*TheContext),
           0.0
         );
     }
 }
 
-// ——— gera IR para atribuições, IF, WHILE e EXPORT ———————————————————————————
+// ValueKind (i8) que o interpretador daria ao resultado de e: agregações e
+// divisão são V_FLOAT, comparações e lógicos V_INT, +, - e * são V_INT só
+// com os dois operandos V_INT; uma célula inteira mantém o tipo guardado e
+// as demais são lidas como V_FLOAT (value_float)
+static Value* codegenKind(Expr *e) {
+    llvm::Type *i8 = llvm::Type::getInt8Ty(*TheContext);
+    switch (e->kind) {
+      case EXPR_FLOAT:
+      case EXPR_CALL:
+        return ConstantInt::get(i8, V_FLOAT);
+      case EXPR_CELL:
+        if (e->type != TYPE_INT) return ConstantInt::get(i8, V_FLOAT);
+        return Builder->CreateLoad(i8, kindPtr(e->slot), "kind");
+      case EXPR_UNARY:
+        if (e->un.op == OP_NEG) return codegenKind(e->un.sub);
+        return ConstantInt::get(i8, V_INT);
+      case EXPR_BINARY:
+        switch (e->bin.op) {
+          case OP_ADD: case OP_SUB: case OP_MUL: {
+            Value *l = Builder->CreateICmpEQ(codegenKind(e->bin.left),
+                                             ConstantInt::get(i8, V_INT));
+            Value *r = Builder->CreateICmpEQ(codegenKind(e->bin.right),
+                                             ConstantInt::get(i8, V_INT));
+            return Builder->CreateSelect(Builder->CreateAnd(l, r),
+                                         ConstantInt::get(i8, V_INT),
+                                         ConstantInt::get(i8, V_FLOAT), "kind");
+          }
+          case OP_DIV:
+            return ConstantInt::get(i8, V_FLOAT);
+          default:
+            return ConstantInt::get(i8, V_INT);
+        }
+      default:
+        return ConstantInt::get(i8, V_INT);
+    }
+}
+
+// Raiz de uma expressão numérica (atribuição, condição): com aritmética
+// i64 que estourou, um desvio improvável refaz a expressão inteira em
+// double e o resultado passa a ser double. BB termina no bloco de junção.
+// Com 'store', cada caminho entrega o próprio resultado a ele (o i64 exato
+// ou o double) e não há resultado comum: retorna nullptr.
+static Value* codegenChecked(Expr *e, BasicBlock *&BB,
+                             function_ref<void(Value*)> store = nullptr) {
+    IntOverflow = nullptr;
+    Value *v   = codegenExpr(e);
+    Value *ovf = IntOverflow;
+    IntOverflow = nullptr;
+    if (!ovf) {
+        if (!store) return v;
+        store(v);
+        return nullptr;
+    }
+
+    Function   *F      = Builder->GetInsertBlock()->getParent();
+    if (!store) v = asDouble(v);
+    BasicBlock *fastBB = Builder->GetInsertBlock();
+    BasicBlock *dblBB  = BasicBlock::Create(*TheContext, "ovf.dbl",  F);
+    BasicBlock *contBB = BasicBlock::Create(*TheContext, "ovf.cont", F);
+    BasicBlock *okBB   = store ? BasicBlock::Create(*TheContext, "ovf.ok", F) : contBB;
+    Builder->CreateCondBr(ovf, dblBB, okBB, unlikelyBranch());
+    if (store) {
+        Builder->SetInsertPoint(okBB);
+        store(v);
+        Builder->CreateBr(contBB);
+    }
+
+    Builder->SetInsertPoint(dblBB);
+    bool saved = DoublePath;
+    DoublePath = true;
+    Value *d = codegenExpr(e);
+    if (store) store(d);
+    DoublePath = saved;
+    dblBB = Builder->GetInsertBlock();
+    Builder->CreateBr(contBB);
+
+    Builder->SetInsertPoint(contBB);
+    BB = contBB;
+    if (store) return nullptr;
+    PHINode *phi = Builder->CreatePHI(v->getType(), 2, "ovf.val");
+    phi->addIncoming(v, fastBB);
+    phi->addIncoming(d, dblBB);
+    return phi;
+}
+
+// ValueKind da atribuição de e (valor v, double) no tiered: o V_INT que não
+// cabe em 64 bits é o V_FLOAT do estouro no interpretador
+static Value* assignKind(Expr *e, Value *v) {
+    llvm::Type *i8 = llvm::Type::getInt8Ty(*TheContext);
+    Value *kind = codegenKind(e);
+    Value *mag  = Builder->CreateUnaryIntrinsic(Intrinsic::fabs, v);
+    Value *big  = Builder->CreateFCmpUGE(
+      mag, ConstantFP::get(v->getType(), 9223372036854775808.0), "big");
+    Value *ovf  = Builder->CreateAnd(
+      Builder->CreateICmpEQ(kind, ConstantInt::get(i8, V_INT)), big);
+    return Builder->CreateSelect(ovf, ConstantInt::get(i8, V_FLOAT), kind, "kind");
+}
+
+static llvm::Type* i64Ty() {
+    return llvm::Type::getInt64Ty(*TheContext);
+}
+
+// Faixas de um eixo compactado do layout (LayoutSpan[n] em cells.h), ou
+// um ponteiro nulo para eixo denso
+static llvm::Constant* spanTable(const LayoutSpan *spans, int64_t n, const char *name) {
+  PointerType *ptrTy = PointerType::get(IntegerType::getInt8Ty(*TheContext), 0);
+  if (!spans) return ConstantPointerNull::get(ptrTy);
+  ArrayType *spanTy = ArrayType::get(i64Ty(), 3);
+  std::vector<Constant*> elems;
+  for (int64_t i = 0; i < n; ++i)
+    elems.push_back(ConstantArray::get(spanTy, std::vector<Constant*>{
+        ConstantInt::get(i64Ty(), spans[i].first), ConstantInt::get(i64Ty(), spans[i].len),
+        ConstantInt::get(i64Ty(), spans[i].at) }));
+  ArrayType *tableTy = ArrayType::get(spanTy, n);
+  return ConstantExpr::getBitCast(
+      new GlobalVariable(*TheModuleRaw, tableTy, true, GlobalValue::PrivateLinkage,
+                         ConstantArray::get(tableTy, elems), name), ptrTy);
+}
+
+// O CellLayout do programa (cells.h), uma constante por módulo, para
+// IMPORT/SAVE/LOAD acharem as células em num[]
+static llvm::Constant* gridTable() {
+  static GlobalVariable *grid = nullptr;
+  static unsigned gridOf = 0;
+  if (gridOf != ModuleId) {
+    PointerType *ptrTy = PointerType::get(IntegerType::getInt8Ty(*TheContext), 0);
+    StructType *gridTy = StructType::get(*TheContext,
+        { i64Ty(), i64Ty(), i64Ty(), i64Ty(), ptrTy, ptrTy, i64Ty(), i64Ty() });
+    grid = new GlobalVariable(
+      *TheModuleRaw, gridTy, true, GlobalValue::PrivateLinkage,
+      ConstantStruct::get(gridTy, {
+        ConstantInt::get(i64Ty(), TheLayout.col0), ConstantInt::get(i64Ty(), TheLayout.row0),
+        ConstantInt::get(i64Ty(), TheLayout.ncols), ConstantInt::get(i64Ty(), TheLayout.nrows),
+        spanTable(TheLayout.colspan, TheLayout.ncolspan, "grid.cols"),
+        spanTable(TheLayout.rowspan, TheLayout.nrowspan, "grid.rows"),
+        ConstantInt::get(i64Ty(), TheLayout.ncolspan), ConstantInt::get(i64Ty(), TheLayout.nrowspan) }),
+      "grid");
+    gridOf = ModuleId;
+  }
+  return grid;
+}
+
+// void lc_table(grid, colunas) e i32 lc_export(arquivo, grid, colunas)
+static FunctionCallee lcTableFn() {
+    std::vector<llvm::Type*> params = cellParamTypes();
+    params.insert(params.begin(), gridTable()->getType());
+    return runtimeFn(TheModuleRaw->getOrInsertFunction(
+        "lc_table",
+        FunctionType::get(llvm::Type::getVoidTy(*TheContext), params, false)));
+}
+
+static FunctionCallee lcExportFn() {
+    auto *i8ptr = llvm::PointerType::get(llvm::Type::getInt8Ty(*TheContext), 0);
+    std::vector<llvm::Type*> params = cellParamTypes();
+    params.insert(params.begin(), { i8ptr, gridTable()->getType() });
+    return runtimeFn(TheModuleRaw->getOrInsertFunction(
+        "lc_export",
+        FunctionType::get(IntegerType::getInt32Ty(*TheContext), params, false)));
+}
+
+// if (failed) exit(1): erro de E/S encerra o programa, como no interpretador
+static void exitIfFailed(llvm::Value *failed, Function *F, BasicBlock *&BB) {
+    auto exitFn = TheModuleRaw->getOrInsertFunction(
+        "exit",
+        FunctionType::get(llvm::Type::getVoidTy(*TheContext),
+                          { IntegerType::getInt32Ty(*TheContext) }, false));
+    BasicBlock *failBB = BasicBlock::Create(*TheContext, "io.fail", F);
+    BasicBlock *okBB   = BasicBlock::Create(*TheContext, "io.ok", F);
+    Builder->CreateCondBr(failed, failBB, okBB);
+    Builder->SetInsertPoint(failBB);
+    Builder->CreateCall(exitFn, { Builder->getInt32(1) });
+    Builder->CreateUnreachable();
+    Builder->SetInsertPoint(okBB);
+    BB = okBB;
+}
+
+// ——— contadores do --profile ——————————————————————————————————————————————
+// lc_prof[3 * site + k] += v. Os incrementos não são atômicos: no modo
+// paralelo cada statement roda numa única tarefa.
+static void profAdd(int64_t site, int k, Value *v) {
+  Value *p = Builder->CreateConstInBoundsGEP2_64(
+    ProfCounters->getValueType(), ProfCounters, 0, 3 * site + k);
+  Builder->CreateStore(Builder->CreateAdd(Builder->CreateLoad(i64Ty(), p), v), p);
+}
+
+static Value* readCycles(IRBuilder<> &B) {
+  return B.CreateCall(Intrinsic::getDeclaration(TheModuleRaw,
+                                                Intrinsic::readcyclecounter));
+}
+
+// ——— gera IR para atribuições, IF, WHILE e E/S ——————————————————————————————
+// ——— promoção de células em laços ————————————————————————————————————————
+// Células citadas por nome num WHILE, as atribuídas e as inteiras; ranges
+// lidos e se há E/S, que lê ou escreve o grid inteiro
+struct LoopCells {
+  std::map<int64_t, std::string> named;
+  std::set<int64_t>              assigned;
+  std::set<int64_t>              ints;
+  std::vector<Expr*>             ranges;
+  bool                           io = false;
+};
+
+static void collectLoopCells(Stmt *s, LoopCells &C);
+
+static void collectListCells(Stmt *s, LoopCells &C) {
+  for (; s; s = s->next) collectLoopCells(s, C);
+}
+
+static void collectLoopCells(Stmt *s, LoopCells &C) {
+  for (int64_t i = 0; i < s->n_reads; ++i) {
+    Expr *r = s->reads[i];
+    if (r->kind != EXPR_CELL) {
+      C.ranges.push_back(r);
+      continue;
+    }
+    C.named.emplace(r->slot, r->sval);
+    if (isInt(r)) C.ints.insert(r->slot);
+  }
+  switch (s->kind) {
+    case STMT_ASSIGN:
+      if (s->assign.expr->kind != EXPR_TEXT) {
+        C.named.emplace(s->assign.slot, s->assign.cell);
+        C.assigned.insert(s->assign.slot);
+        if (s->assign.type == TYPE_INT) C.ints.insert(s->assign.slot);
+      }
+      break;
+    case STMT_IF:    collectListCells(s->ifs.then_branch, C); break;
+    case STMT_WHILE: collectListCells(s->whiles.body, C);     break;
+    case STMT_TABLE: break;   // o TABLE do JIT sai no fim do lc_main
+    default:         C.io = true;
+  }
+}
+
+static bool rangeCovers(const Expr *r, int64_t slot) {
+  int64_t nrows = TheLayout.nrows;
+  int64_t dc = slot / nrows - r->range.slot / nrows;
+  int64_t dr = slot % nrows - r->range.slot % nrows;
+  return dc >= 0 && dc < r->range.cols && dr >= 0 && dr < r->range.rows;
+}
+
+// Antes de um WHILE de fora: as células do laço passam a viver em allocas,
+// carregadas de num[] aqui e gravadas de volta (as atribuídas) pelo
+// writeBack na saída; células inteiras ganham uma alloca i64 (se alguma
+// já não cabe em i64, o laço começa pela cópia em double). O SROA as
+// transforma em registradores, e o laço não
+// faz mais uma ida à memória por leitura/escrita. Ficam em num[] as células
+// cobertas por um range lido no laço (agg_helper lê o grid direto), e laços
+// com EXPORT/IMPORT/SAVE/LOAD não são promovidos. Retorna as células a
+// gravar de volta.
+static std::vector<int64_t> promoteLoopCells(Stmt *loop) {
+  std::vector<int64_t> writeBack;
+  if (!Promoted.empty() || DoublePath || OptLevel == 0)   // -O0: sem SROA
+    return writeBack;
+  LoopCells C;
+  collectLoopCells(loop, C);
+  if (C.io) return writeBack;
+
+  for (auto &pr : C.named) {
+    int64_t slot = pr.first;
+    bool covered = false;
+    for (Expr *r : C.ranges) covered = covered || rangeCovers(r, slot);
+    if (covered) continue;
+    Value *v = loadCell(pr.second, slot, C.ints.count(slot) > 0);
+    AllocaInst *A = createEntryAlloca(v->getType(), pr.second.c_str());
+    Builder->CreateStore(v, A);
+    Promoted[slot] = A;
+    if (C.assigned.count(slot)) writeBack.push_back(slot);
+  }
+  return writeBack;
+}
+
+static void codegenStmt(Stmt *s, Function *F, BasicBlock *&BB);
+
 static void codegenStmtList(Stmt *s, Function *F, BasicBlock *&BB) {
-  for (; s; s = s->next) {
-    Builder.SetInsertPoint(BB);
-
-    // ASSIGN
-    if (s->kind == STMT_ASSIGN) {
-      if (s->assign.expr->kind == EXPR_TEXT) {
-        // só texto
-        auto *GVtxt = getCellTextGV(s->assign.cell);
-        Value  *txt  = codegenExpr(s->assign.expr);
-        Builder.CreateStore(txt, GVtxt);
+  for (; s; s = s->next) codegenStmt(s, F, BB);
+}
+
+// células promovidas e atribuídas voltam para as colunas do grid: as i64
+// como V_INT, as double como V_FLOAT (no tiered o kind[] já foi gravado a
+// cada atribuição)
+static void writeBackCells(const std::vector<int64_t> &slots) {
+  for (int64_t slot : slots) {
+    AllocaInst *A = Promoted[slot];
+    Value *v = Builder->CreateLoad(A->getAllocatedType(), A);
+    Value *kind = v->getType()->isIntegerTy() ? kindConst(V_INT)
+                : InterpSemantics             ? nullptr
+                                              : kindConst(V_FLOAT);
+    storeColumns(slot, v, kind);
+  }
+}
+
+// Cópia em double do WHILE de fora 'loop', sobre num[] e sem promoção, em
+// blocos à parte: só se entra nela pelos saltos de SlowEntry. Retorna o
+// bloco em que ela termina.
+static BasicBlock* codegenSlowLoop(Stmt *loop, Function *F) {
+  std::map<int64_t, AllocaInst*> fast;
+  fast.swap(Promoted);
+  DoublePath = true;
+  BasicBlock *BB = BasicBlock::Create(*TheContext, "slow", F);
+  codegenStmt(loop, F, BB);
+  DoublePath = false;
+  Promoted.swap(fast);
+  return BB;
+}
+
+// Atribuição a uma célula promovida para i64: se a expressão estourou, as
+// células voltam para num[] e a execução segue na cópia em double, a
+// partir deste mesmo statement (que o --profile então não conta duas vezes)
+static void deoptIfOverflow(Value *ovf, Stmt *s, Function *F, BasicBlock *&BB) {
+  BasicBlock *deoptBB = BasicBlock::Create(*TheContext, "deopt", F);
+  BasicBlock *okBB    = BasicBlock::Create(*TheContext, "ovf.ok", F);
+  Builder->CreateCondBr(ovf, deoptBB, okBB, unlikelyBranch());
+  Builder->SetInsertPoint(deoptBB);
+  writeBackCells(LoopWriteBack);
+  auto site = ProfSite.find(s);
+  if (ProfCounters && site != ProfSite.end())
+    profAdd(site->second, 0, Builder->getInt64(-1));
+  Builder->CreateBr(SlowEntry.at(s));
+  Builder->SetInsertPoint(okBB);
+  BB = okBB;
+}
+
+static void codegenStmt(Stmt *s, Function *F, BasicBlock *&BB) {
+  Builder->SetInsertPoint(BB);
+
+  // na cópia em double de um laço, cada statement começa num bloco próprio
+  if (DoublePath) {
+    BasicBlock *entry = BasicBlock::Create(*TheContext, "slow.stmt", F);
+    Builder->CreateBr(entry);
+    Builder->SetInsertPoint(entry);
+    BB = entry;
+    SlowEntry[s] = entry;
+  }
+
+  // --profile: conta a execução e lê o contador de ciclos na entrada (não
+  // na cópia em double, em que se entra no meio de um IF ou WHILE)
+  int64_t site = -1;
+  Value  *t0   = nullptr;
+  if (ProfCounters) {
+    auto it = ProfSite.find(s);
+    if (it != ProfSite.end()) {
+      site = it->second;
+      profAdd(site, 0, Builder->getInt64(1));
+      if (Profile == PROFILE_CYCLES && !DoublePath) t0 = readCycles(*Builder);
+    }
+  }
+
+  // ASSIGN
+  if (s->kind == STMT_ASSIGN) {
+    if (s->assign.expr->kind == EXPR_TEXT) {
+      // só texto: num vale 0 e kind V_TEXT, como no store_put
+      Value  *txt  = codegenExpr(s->assign.expr);
+      Builder->CreateStore(txt, getCellTextPtr(s->assign.cell, s->assign.slot));
+      storeColumns(s->assign.slot, ConstantFP::get(*TheContext, APFloat(0.0)),
+                   kindConst(V_TEXT));
+    } else {
+      // só numérico
+      auto  it     = Promoted.find(s->assign.slot);
+      bool  intDst = it != Promoted.end() &&
+                     it->second->getAllocatedType()->isIntegerTy();
+      if (intDst) {
+        IntOverflow = nullptr;
+        Value *val = codegenExpr(s->assign.expr);
+        if (Value *ovf = IntOverflow) {
+          IntOverflow = nullptr;
+          deoptIfOverflow(ovf, s, F, BB);
+        }
+        storeCell(s->assign.cell, s->assign.slot, val);
       } else {
-        // só numérico
-        auto *GVnum = getCellGV(s->assign.cell);
-        Value  *val  = codegenExpr(s->assign.expr);
-        Builder.CreateStore(val, GVnum);
+        // só a célula inteira guarda i64; uma de tipo misto fica em double
+        // (V_FLOAT), como quando é promovida, em todos os motores. No tiered
+        // o double de uma célula inteira leva o ValueKind do interpretador.
+        bool intCell = s->assign.type == TYPE_INT;
+        codegenChecked(s->assign.expr, BB, [&](Value *val) {
+          if (!intCell) val = asDouble(val);
+          Value *kind = InterpSemantics && intCell && !val->getType()->isIntegerTy()
+                          ? assignKind(s->assign.expr, val) : nullptr;
+          storeCell(s->assign.cell, s->assign.slot, val, kind);
+        });
       }
+    }
+    llvm::Type *i8 = llvm::Type::getInt8Ty(*TheContext);
+    Builder->CreateStore(ConstantInt::get(i8, 1),
+      Builder->CreateConstInBoundsGEP1_64(i8, CurAssigned, s->assign.slot));
 
-    // IF
-    } else if (s->kind == STMT_IF) {
-      Value *condV = codegenExpr(s->ifs.cond);
-      Value *cmp   = Builder.CreateFCmpONE(
-        condV,
-        ConstantFP::get(TheContext, APFloat(0.0)),
-        "ifcond"
-      );
-      BasicBlock *thenBB = BasicBlock::Create(TheContext, "then",   F);
-      BasicBlock *contBB = BasicBlock::Create(TheContext, "ifcont", F);
-      Builder.CreateCondBr(cmp, thenBB, contBB);
-
-      Builder.SetInsertPoint(thenBB);
-      codegenStmtList(s->ifs.then_branch, F, thenBB);
-      Builder.CreateBr(contBB);
-
-      Builder.SetInsertPoint(contBB);
-      BB = contBB;
-
-    // WHILE
-    } else if (s->kind == STMT_WHILE) {
-      BasicBlock *condBB = BasicBlock::Create(TheContext, "while.cond", F);
-      BasicBlock *bodyBB = BasicBlock::Create(TheContext, "while.body", F);
-      BasicBlock *endBB  = BasicBlock::Create(TheContext, "while.end",  F);
-      Builder.CreateBr(condBB);
-
-      // condição
-      Builder.SetInsertPoint(condBB);
-      Value *condV2 = codegenExpr(s->whiles.cond);
-      Value *cmp2   = Builder.CreateFCmpONE(
-        condV2,
-        ConstantFP::get(TheContext, APFloat(0.0)),
-        "whilecond"
-      );
-      Builder.CreateCondBr(cmp2, bodyBB, endBB);
-
-      // corpo
-      Builder.SetInsertPoint(bodyBB);
-      codegenStmtList(s->whiles.body, F, bodyBB);
-      Builder.CreateBr(condBB);
-
-      // fim
-      Builder.SetInsertPoint(endBB);
-      BB = endBB;
-
-    // EXPORT
-    } else if (s->kind == STMT_EXPORT) {
-      // tipos comuns
-      llvm::Type *dblTy = llvm::Type::getDoubleTy(TheContext);
-      auto *i8ptr       = llvm::PointerType::get(llvm::Type::getInt8Ty(TheContext), 0);
-      auto *FILEptr     = llvm::PointerType::get(llvm::StructType::create(TheContext, "struct._IO_FILE"), 0);
-
-      // fopen(filename, "w")
-      Value *fname = Builder.CreateGlobalStringPtr(s->exp.filename, "fname");
-      Value *mode  = Builder.CreateGlobalStringPtr("w", "mode");
-      auto fopenFn = TheModuleRaw->getOrInsertFunction(
-        "fopen",
-        FunctionType::get(FILEptr, { i8ptr, i8ptr }, false)
-      );
-      Value *file = Builder.CreateCall(fopenFn, { fname, mode }, "f");
-
-      // declara fprintf e fclose
-      auto fprintfFn = TheModuleRaw->getOrInsertFunction(
-        "fprintf",
-        FunctionType::get(
-          IntegerType::getInt32Ty(TheContext),
-          { FILEptr, i8ptr },
-          true // varargs
-        )
-      );
-      auto fcloseFn = TheModuleRaw->getOrInsertFunction(
-        "fclose",
-        FunctionType::get(IntegerType::getInt32Ty(TheContext), { FILEptr }, false)
-      );
-
-      // formatos
-      Value *fmtNum = Builder.CreateGlobalStringPtr("%s,%g\n", "fmtNum");
-      Value *fmtTxt = Builder.CreateGlobalStringPtr("%s,%s\n", "fmtTxt");
-
-      // escreve numéricos
-      for (auto &pr : CellMap) {
-        Value *nm = Builder.CreateGlobalStringPtr(pr.first, "nm");
-        Value *v  = Builder.CreateLoad(dblTy, pr.second);
-        Builder.CreateCall(fprintfFn, { file, fmtNum, nm, v });
-      }
-      // escreve textos
-      for (auto &pr : TextMap) {
-        Value *nm  = Builder.CreateGlobalStringPtr(pr.first, "nm");
-        GlobalVariable *GVtxt = pr.second;
-        Value *txt = Builder.CreateLoad(i8ptr, GVtxt);
-        Builder.CreateCall(fprintfFn, { file, fmtTxt, nm, txt });
-      }
-      // fecha
-      Builder.CreateCall(fcloseFn, { file });
+  // IF
+  } else if (s->kind == STMT_IF) {
+    Value *condV = codegenChecked(s->ifs.cond, BB);
+    Value *cmp   = codegenTruth(condV, "ifcond");
+    BasicBlock *thenBB = BasicBlock::Create(*TheContext, "then",   F);
+    BasicBlock *contBB = BasicBlock::Create(*TheContext, "ifcont", F);
+    Builder->CreateCondBr(cmp, thenBB, contBB);
+
+    Builder->SetInsertPoint(thenBB);
+    if (site >= 0) profAdd(site, 2, Builder->getInt64(1));
+    codegenStmtList(s->ifs.then_branch, F, thenBB);
+    Builder->CreateBr(contBB);
+
+    Builder->SetInsertPoint(contBB);
+    BB = contBB;
+
+  // WHILE
+  } else if (s->kind == STMT_WHILE) {
+    bool outer = Promoted.empty() && !DoublePath;
+    IntOverflow = nullptr;
+    std::vector<int64_t> writeBack = promoteLoopCells(s);
+    Value *loadOvf = IntOverflow;   // célula inteira que já não cabia em i64
+    IntOverflow = nullptr;
+
+    // com alguma célula em i64, o laço ganha a cópia em double
+    BasicBlock *slowEnd = nullptr;
+    bool        anyInt  = false;
+    for (auto &pr : Promoted)
+      anyInt = anyInt || pr.second->getAllocatedType()->isIntegerTy();
+    if (outer && anyInt) {
+      BasicBlock *here = Builder->GetInsertBlock();
+      slowEnd = codegenSlowLoop(s, F);
+      Builder->SetInsertPoint(here);
+      LoopWriteBack = writeBack;
+    }
+
+    BasicBlock *condBB = BasicBlock::Create(*TheContext, "while.cond", F);
+    BasicBlock *bodyBB = BasicBlock::Create(*TheContext, "while.body", F);
+    BasicBlock *endBB  = BasicBlock::Create(*TheContext, "while.end",  F);
+    if (loadOvf)
+      Builder->CreateCondBr(loadOvf, SlowEntry.at(s), condBB, unlikelyBranch());
+    else
+      Builder->CreateBr(condBB);
+
+    // condição
+    Builder->SetInsertPoint(condBB);
+    BasicBlock *condEnd = condBB;
+    Value *condV2 = codegenChecked(s->whiles.cond, condEnd);
+    Value *cmp2   = codegenTruth(condV2, "whilecond");
+    Builder->CreateCondBr(cmp2, bodyBB, endBB);
+
+    // corpo
+    Builder->SetInsertPoint(bodyBB);
+    if (site >= 0) profAdd(site, 2, Builder->getInt64(1));
+    codegenStmtList(s->whiles.body, F, bodyBB);
+    Builder->CreateBr(condBB);
+
+    // fim: células promovidas voltam para num[], e a cópia em double
+    // termina no mesmo ponto
+    Builder->SetInsertPoint(endBB);
+    if (outer) {
+      writeBackCells(writeBack);
+      Promoted.clear();
     }
+    if (slowEnd) {
+      BasicBlock *joinBB = BasicBlock::Create(*TheContext, "while.join", F);
+      Builder->CreateBr(joinBB);
+      Builder->SetInsertPoint(slowEnd);
+      Builder->CreateBr(joinBB);
+      Builder->SetInsertPoint(joinBB);
+      endBB = joinBB;
+      SlowEntry.clear();
+      LoopWriteBack.clear();
+    }
+    BB = endBB;
+
+  // EXPORT
+  } else if (s->kind == STMT_EXPORT) {
+    // lc_export(arquivo, grid, colunas)
+    std::vector<Value*> args = cellArgs();
+    args.insert(args.begin(), { Builder->CreateGlobalStringPtr(s->exp.filename, "fname"),
+                                gridTable() });
+    Value *failed = Builder->CreateCall(lcExportFn(), args);
+    exitIfFailed(Builder->CreateICmpNE(failed, Builder->getInt32(0)), F, BB);
+
+  // IMPORT
+  } else if (s->kind == STMT_IMPORT) {
+    // import_csv(fname, col, row, grid, num, kind, assigned, NULL, NULL)
+    // grava direto no num, como V_FLOAT; arquivo ilegível encerra o
+    // programa, como no interpretador
+    llvm::Type *i64   = llvm::Type::getInt64Ty(*TheContext);
+    auto *i8ptr       = llvm::PointerType::get(llvm::Type::getInt8Ty(*TheContext), 0);
+    auto importFn = runtimeFn(TheModuleRaw->getOrInsertFunction(
+      "import_csv",
+      FunctionType::get(i64, { i8ptr, i64, i64, gridTable()->getType(), CurNum->getType(),
+                               CurKind->getType(), CurAssigned->getType(), i8ptr, i8ptr },
+                        false)));
+    Value *fname = Builder->CreateGlobalStringPtr(s->imp.filename, "fname");
+    Value *null  = ConstantPointerNull::get(i8ptr);
+    Value *n = Builder->CreateCall(importFn, {
+      fname, ConstantInt::get(i64, s->imp.col), ConstantInt::get(i64, s->imp.row),
+      gridTable(), CurNum, CurKind, CurAssigned, null, null });
+
+    exitIfFailed(Builder->CreateICmpSLT(n, ConstantInt::get(i64, 0)), F, BB);
+    indexInvalidate();
+
+  // SAVE / LOAD
+  } else if (s->kind == STMT_SAVE || s->kind == STMT_LOAD) {
+    // lc_save(arquivo, grid, colunas) ou lc_load(arquivo, grid, colunas)
+    auto *i8ptr = llvm::PointerType::get(llvm::Type::getInt8Ty(*TheContext), 0);
+    std::vector<llvm::Type*> params = cellParamTypes();
+    params.insert(params.begin(), { i8ptr, gridTable()->getType() });
+    std::vector<Value*> args = cellArgs();
+    args.insert(args.begin(), { Builder->CreateGlobalStringPtr(s->exp.filename, "fname"),
+                                gridTable() });
+    auto ioFn = runtimeFn(TheModuleRaw->getOrInsertFunction(
+      s->kind == STMT_SAVE ? "lc_save" : "lc_load",
+      FunctionType::get(IntegerType::getInt32Ty(*TheContext), params, false)));
+    Value *failed = Builder->CreateCall(ioFn, args);
+    exitIfFailed(Builder->CreateICmpNE(failed, Builder->getInt32(0)), F, BB);
+    if (s->kind == STMT_LOAD) indexInvalidate();
+  }
+
+  // ciclos do statement, incluindo os de dentro de IF/WHILE
+  if (t0) {
+    Builder->SetInsertPoint(BB);
+    profAdd(site, 1, Builder->CreateSub(readCycles(*Builder), t0));
   }
 }
 
+// ——— escolhe o motor JIT ——————————————————————————————————————————————
+void set_jit_options(JitEngine engine, unsigned compile_threads) {
+  JitKind        = engine;
+  CompileThreads = compile_threads;
+}
 
-// ——— inicializa LLVM + MCJIT ——————————————————————————————————————————
-void init_llvm(const char *module_name) {
+void set_parallel(int on) {
+  Parallel = on != 0;
+}
+
+void set_profile(ProfileMode mode, const char *source, size_t len) {
+  Profile = mode;
+  SourceLines.clear();
+  for (size_t i = 0; source && i < len; ) {
+    size_t end = i;
+    while (end < len && source[end] != '\n') ++end;
+    size_t b = i, e = end;
+    while (b < e && (source[b] == ' ' || source[b] == '\t')) ++b;
+    while (e > b && (source[e - 1] == '\r' || source[e - 1] == ' ')) --e;
+    SourceLines.emplace_back(source + b, e - b);
+    i = end + 1;
+  }
+}
+
+void set_opt_level(int level) {
+  OptLevel = level < 0 ? 0 : (level > 3 ? 3 : level);
+}
+
+static CodeGenOpt::Level codegenOptLevel() {
+  switch (OptLevel) {
+    case 0:  return CodeGenOpt::None;
+    case 1:  return CodeGenOpt::Less;
+    case 3:  return CodeGenOpt::Aggressive;
+    default: return CodeGenOpt::Default;
+  }
+}
+
+// CPU e features da máquina host ("+avx2", "-avx512f", ...), para que tanto o
+// vetorizador quanto o backend usem o ISA vetorial disponível
+static std::vector<std::string> hostFeatures() {
+  std::vector<std::string> attrs;
+  StringMap<bool> feats;
+  if (sys::getHostCPUFeatures(feats))
+    for (auto &f : feats)
+      attrs.push_back((f.second ? "+" : "-") + f.first().str());
+  return attrs;
+}
+
+// TargetMachine do host com as mesmas CPU, features e nível de otimização
+// do JIT; nullptr (com a mensagem em stderr) se o target não existir
+static std::unique_ptr<TargetMachine> hostTargetMachine(Reloc::Model RM) {
+  std::string triple = sys::getDefaultTargetTriple();
+  std::string err;
+  const Target *T = TargetRegistry::lookupTarget(triple, err);
+  if (!T) {
+    std::fprintf(stderr, "Erro procurando o target %s: %s\n",
+                 triple.c_str(), err.c_str());
+    return nullptr;
+  }
+  std::string feats;
+  for (const std::string &f : hostFeatures())
+    feats += (feats.empty() ? "" : ",") + f;
+  return std::unique_ptr<TargetMachine>(T->createTargetMachine(
+    triple, sys::getHostCPUName(), feats, TargetOptions(), RM,
+    None, codegenOptLevel()));
+}
+
+// ——— pipeline de otimização (new PassManager) ——————————————————————————
+// Roda o pipeline padrão do nível OptLevel sobre M. O TargetMachine fornece
+// o TargetIRAnalysis, de forma que custos e larguras de vetor são os do host.
+static void optimizeModule(Module &M, TargetMachine *TM) {
+  LoopAnalysisManager     LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager    CGAM;
+  ModuleAnalysisManager   MAM;
+
+  PassBuilder PB(TM);
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  ModulePassManager MPM;
+  switch (OptLevel) {
+    case 0:  MPM = PB.buildO0DefaultPipeline(OptimizationLevel::O0); break;
+    case 1:  MPM = PB.buildPerModuleDefaultPipeline(OptimizationLevel::O1); break;
+    case 3:  MPM = PB.buildPerModuleDefaultPipeline(OptimizationLevel::O3); break;
+    default: MPM = PB.buildPerModuleDefaultPipeline(OptimizationLevel::O2); break;
+  }
+  MPM.run(M, MAM);
+}
+
+static void exitOnErr(Error E, const char *what) {
+  if (E) {
+    errs() << "Erro " << what << ": " << toString(std::move(E)) << "\n";
+    std::exit(1);
+  }
+}
+
+// ——— cache de objetos em disco ————————————————————————————————————————————
+// O MCJIT consulta o cache antes de gerar código para um módulo e o avisa
+// depois de compilar. Só módulos cujo identificador é uma chave "lc-<hash>"
+// (o programa principal) passam pelo disco; os laços do modo tiered não.
+class DiskObjectCache : public ObjectCache {
+  std::string Dir;
+
+  std::string pathFor(const std::string &key) const {
+    SmallString<256> P(Dir);
+    sys::path::append(P, key + ".o");
+    return std::string(P.str());
+  }
+  static bool cached(const Module *M) {
+    return StringRef(M->getModuleIdentifier()).startswith("lc-");
+  }
+
+  // Apaga os objetos menos usados (pela data de modificação, que load
+  // atualiza) até o diretório caber em MaxBytes
+  void evict() const {
+    struct Entry { std::string path; uint64_t size; sys::TimePoint<> mtime; };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code EC;
+    for (sys::fs::directory_iterator I(Dir, EC), E; I != E && !EC; I.increment(EC)) {
+      StringRef name = sys::path::filename(I->path());
+      if (!name.startswith("lc-") || !name.endswith(".o")) continue;
+      sys::fs::file_status st;
+      if (sys::fs::status(I->path(), st)) continue;
+      entries.push_back({ I->path(), st.getSize(), st.getLastModificationTime() });
+      total += st.getSize();
+    }
+    if (total <= MaxBytes) return;
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.mtime < b.mtime; });
+    for (const Entry &e : entries) {
+      if (total <= MaxBytes) break;
+      if (!sys::fs::remove(e.path)) total -= e.size;
+    }
+  }
+
+public:
+  static const uint64_t MaxBytes = 64 << 20;   // 64 MiB por diretório
+
+  explicit DiskObjectCache(std::string dir) : Dir(std::move(dir)) {}
+
+  // objeto gravado com a chave do módulo, ou nulo; um acerto renova a data
+  // do arquivo
+  std::unique_ptr<MemoryBuffer> getObject(const Module *M) override {
+    if (!cached(M)) return nullptr;
+    std::string path = pathFor(M->getModuleIdentifier());
+    auto Buf = MemoryBuffer::getFile(path, /*IsText=*/false,
+                                     /*RequiresNullTerminator=*/false);
+    if (!Buf) return nullptr;
+    int fd;
+    if (!sys::fs::openFileForWrite(path, fd, sys::fs::CD_OpenExisting,
+                                   sys::fs::OF_Append)) {
+      sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+      sys::Process::SafelyCloseFileDescriptor(fd);
+    }
+    return std::move(*Buf);
+  }
+
+  void remove(const std::string &key) const {
+    sys::fs::remove(pathFor(key));
+  }
+
+  // grava num arquivo temporário e renomeia: outro processo lendo a mesma
+  // chave nunca vê um objeto pela metade
+  void notifyObjectCompiled(const Module *M, MemoryBufferRef Obj) override {
+    if (!cached(M) || sys::fs::create_directories(Dir)) return;
+    std::string path = pathFor(M->getModuleIdentifier());
+    SmallString<256> Tmp;
+    int fd;
+    if (sys::fs::createUniqueFile(path + ".tmp-%%%%%%", fd, Tmp)) return;
+    raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << Obj.getBuffer();
+    os.close();
+    if (os.has_error() || sys::fs::rename(Tmp, path)) {
+      os.clear_error();
+      sys::fs::remove(Tmp);
+      return;
+    }
+    evict();
+  }
+};
+
+// Chave do objeto: fonte do programa + versão do LLVM + CPU e features do
+// host + nível de otimização + modo de geração (--parallel) + versão do ABI
+// do runtime (LC_RUNTIME_ABI) + grid da sema, que um snapshot lido pelo
+// LOAD pode aumentar sem mudar o fonte. O build do próprio langcell também
+// entra, para um binário novo não reaproveitar objetos gerados pelo antigo.
+void set_object_cache(const char *dir, const char *source, size_t len) {
+  TheObjectCache.reset();
+  CacheKey.clear();
+  if (!dir || !*dir) return;
+
+  std::vector<std::string> feats = hostFeatures();
+  std::sort(feats.begin(), feats.end());
+  std::string id = std::string(LLVM_VERSION_STRING) + "\n" +
+                   sys::getHostCPUName().str() + "\n" +
+                   "O" + std::to_string(OptLevel) +
+                   (Parallel ? " parallel" : "") + "\n" +
+                   "abi " + std::to_string(LC_RUNTIME_ABI) + "\n" +
+                   __DATE__ " " __TIME__ "\n";
+  for (const std::string &f : feats) id += f;
+  const CellLayout *L = sema_layout();
+  id += "grid " + std::to_string(L->col0) + " " + std::to_string(L->row0) + " " +
+        std::to_string(L->ncols) + " " + std::to_string(L->nrows) + "\n";
+  if (L->colspan)
+    id.append((const char *)L->colspan, (size_t)L->ncolspan * sizeof *L->colspan);
+  if (L->rowspan)
+    id.append((const char *)L->rowspan, (size_t)L->nrowspan * sizeof *L->rowspan);
+
+  uint64_t h = xxHash64(StringRef(source, len)) ^
+               (xxHash64(id) * 0x9e3779b97f4a7c15ULL);
+  char key[24];
+  std::snprintf(key, sizeof key, "lc-%016llx", (unsigned long long)h);
+  CacheKey = key;
+  TheObjectCache = std::make_unique<DiskObjectCache>(dir);
+}
+
+// ——— memória do código gerado ————————————————————————————————————————————
+// SectionMemoryManager que soma o tamanho das seções de código alocadas,
+// para o code_bytes de --stats. Com ORC cada objeto ganha o seu, e as
+// partições podem ser compiladas em threads do pool: o contador é atômico.
+static std::atomic<int64_t> CodeBytes{0};
+
+class CountingMemoryManager : public SectionMemoryManager {
+public:
+  uint8_t *allocateCodeSection(uintptr_t Size, unsigned Alignment,
+                               unsigned SectionID,
+                               StringRef SectionName) override {
+    CodeBytes += (int64_t)Size;
+    return SectionMemoryManager::allocateCodeSection(Size, Alignment,
+                                                     SectionID, SectionName);
+  }
+};
+
+// ——— inicializa LLVM + MCJIT/ORC ———————————————————————————————————————
+// contexto, módulo e builder, comuns ao JIT e à compilação AOT
+static void initModule(const char *module_name) {
   InitializeNativeTarget();
   InitializeNativeTargetAsmPrinter();
   InitializeNativeTargetAsmParser();
 
-  // adicionar essa linha:
+  TheTSCtx     = orc::ThreadSafeContext(std::make_unique<LLVMContext>());
+  TheContext   = TheTSCtx.getContext();
+  Builder      = std::make_unique<IRBuilder<>>(*TheContext);
+  TheModule    = std::make_unique<Module>(module_name, *TheContext);
+  TheModuleRaw = TheModule.get();
+  ++ModuleId;
+}
+
+void init_llvm(const char *module_name) {
+  initModule(module_name);
+
+  // símbolos do próprio processo (runtime, libc) visíveis para o JIT
   llvm::sys::DynamicLibrary::LoadLibraryPermanently(nullptr);
 
-  auto M_up = std::make_unique<Module>(module_name, TheContext);
-  TheModuleRaw = M_up.get();
-
-  // protótipo de printf — desambiguado
-  PrintfFunc = TheModuleRaw->getOrInsertFunction(
-    "printf",
-    FunctionType::get(
-      IntegerType::getInt32Ty(TheContext),
-      PointerType::get( llvm::Type::getInt8Ty(TheContext), 0 ),
-      /*isVarArg=*/true
-    )
-  );
+  if (JitKind == JIT_ORC) {
+    // LLLazyJIT: CompileOnDemandLayer + lazy reexports. Cada função vira um
+    // stub que só é compilado quando chamado pela primeira vez; com
+    // CompileThreads > 0 a compilação roda num thread pool do ORC.
+    // detectHost já preenche CPU e features do host
+    auto JTMB = orc::JITTargetMachineBuilder::detectHost();
+    if (!JTMB) exitOnErr(JTMB.takeError(), "detectando host");
+    JTMB->setCodeGenOptLevel(codegenOptLevel());
+
+    // ConcurrentIRCompiler (um TargetMachine por compilação) mesmo sem o
+    // pool: no --serve e no --parallel os stubs são chamados de várias
+    // threads, e cada uma compila na hora o que chamou
+    auto J = orc::LLLazyJITBuilder()
+               .setJITTargetMachineBuilder(*JTMB)
+               .setNumCompileThreads(CompileThreads)
+               .setCompileFunctionCreator(
+                 [](orc::JITTargetMachineBuilder JTMB)
+                     -> Expected<std::unique_ptr<orc::IRCompileLayer::IRCompiler>> {
+                   return std::make_unique<orc::ConcurrentIRCompiler>(std::move(JTMB));
+                 })
+               .setObjectLinkingLayerCreator(
+                 [](orc::ExecutionSession &ES, const Triple &)
+                     -> Expected<std::unique_ptr<orc::ObjectLayer>> {
+                   return std::make_unique<orc::RTDyldObjectLinkingLayer>(
+                     ES, [] { return std::make_unique<CountingMemoryManager>(); });
+                 })
+               .create();
+    if (!J) exitOnErr(J.takeError(), "criando LLLazyJIT");
+    TheLazyJIT = std::move(*J);
+
+    // o pipeline roda por partição, no momento em que o CompileOnDemandLayer
+    // a materializa (possivelmente num thread do pool)
+    orc::JITTargetMachineBuilder OptJTMB = *JTMB;
+    TheLazyJIT->getIRTransformLayer().setTransform(
+      [OptJTMB](orc::ThreadSafeModule TSM,
+                const orc::MaterializationResponsibility &) mutable
+          -> Expected<orc::ThreadSafeModule> {
+        auto TM = OptJTMB.createTargetMachine();
+        if (!TM) return TM.takeError();
+        TSM.withModuleDo([&](Module &M) { optimizeModule(M, TM->get()); });
+        return TSM;
+      });
+
+    // resolve printf, sum_helper etc. nos símbolos do próprio processo
+    auto Gen = orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+                 TheLazyJIT->getDataLayout().getGlobalPrefix());
+    if (!Gen) exitOnErr(Gen.takeError(), "criando gerador de símbolos");
+    TheLazyJIT->getMainJITDylib().addGenerator(std::move(*Gen));
+    TheModuleRaw->setDataLayout(TheLazyJIT->getDataLayout());
+    return;
+  }
 
   std::string err;
-  TheExecutionEngine = EngineBuilder(std::move(M_up))
+  TheExecutionEngine = EngineBuilder(std::move(TheModule))
     .setErrorStr(&err)
     .setEngineKind(EngineKind::JIT)
+    .setOptLevel(codegenOptLevel())
+    .setMCPU(sys::getHostCPUName())
+    .setMAttrs(hostFeatures())
+    .setMCJITMemoryManager(std::make_unique<CountingMemoryManager>())
     .create();
   if (!TheExecutionEngine) {
     std::fprintf(stderr, "Erro criando ExecutionEngine: %s\n", err.c_str());
     std::exit(1);
   }
+  if (TheObjectCache) TheExecutionEngine->setObjectCache(TheObjectCache.get());
+}
+
+// ——— modo paralelo ——————————————————————————————————————————————————————
+// Conjuntos de leitura e escrita de um statement de topo (incluindo o corpo
+// de IF/WHILE), derivados da AST: leituras vêm de Stmt.reads (sema), com
+// ranges expandidos em células.
+struct StmtSets {
+  std::vector<int64_t> reads, writes;
+  bool                 barrier = false;   // EXPORT/IMPORT/SAVE/LOAD: E/S
+  int64_t              cost    = 0;       // estimativa, em células tocadas
+};
+
+static void collectSets(Stmt *s, StmtSets &S) {
+  size_t before = S.reads.size();
+  for (int64_t i = 0; i < s->n_reads; ++i) {
+    Expr *r = s->reads[i];
+    if (r->kind != EXPR_RANGE) {
+      S.reads.push_back(r->slot);
+      continue;
+    }
+    for (int64_t c = 0; c < r->range.cols; ++c)
+      for (int64_t j = 0; j < r->range.rows; ++j)
+        S.reads.push_back(r->range.slot + c * TheLayout.nrows + j);
+  }
+  S.cost += 1 + (int64_t)(S.reads.size() - before);
+  switch (s->kind) {
+    case STMT_ASSIGN:
+      S.writes.push_back(s->assign.slot);
+      break;
+    case STMT_IF:
+      for (Stmt *b = s->ifs.then_branch; b; b = b->next) collectSets(b, S);
+      break;
+    case STMT_WHILE:
+      // número de iterações desconhecido: o laço vira uma tarefa própria
+      S.cost += MinTaskCost;
+      for (Stmt *b = s->whiles.body; b; b = b->next) collectSets(b, S);
+      break;
+    case STMT_EXPORT:
+    case STMT_SAVE:
+    case STMT_IMPORT:   // IMPORT e LOAD escrevem células que só se conhecem
+    case STMT_LOAD:     // em runtime
+      S.barrier = true;
+      break;
+    case STMT_TABLE:
+      break;
+  }
+}
+
+// Distribui os statements de topo em níveis: cada statement fica um nível
+// acima de todo statement anterior com que conflita (leitura depois de
+// escrita, escrita depois de leitura ou de escrita), então statements do
+// mesmo nível são independentes e podem rodar em qualquer ordem, com o mesmo
+// resultado da execução sequencial. EXPORT, IMPORT, SAVE e LOAD são
+// barreiras: rodam no lc_main, entre os níveis anteriores e os seguintes.
+// Cada nível vira tarefas de custo >= MinTaskCost; um nível com várias
+// tarefas é executado via par_run. Retorna o bloco do lc_main onde a geração continua.
+static BasicBlock* emitParallel(Stmt *program, Function *MainF,
+                                FunctionType *TaskTy) {
+  int64_t ncells = layout_ncells(&TheLayout);
+  std::vector<int> lastW(ncells > 0 ? ncells : 1, 0);
+  std::vector<int> lastR(ncells > 0 ? ncells : 1, 0);
+
+  struct Level { std::vector<std::vector<Stmt*>> tasks; int64_t cost = 0; };
+  std::map<int, Level> levels;
+  std::map<Stmt*, std::pair<Function*, BasicBlock*>*> where;
+  std::map<Stmt*, int> barriers;
+  int floorLevel = 0, maxLevel = 0;
+
+  for (Stmt *s = program; s; s = s->next) {
+    if (s->kind == STMT_TABLE) continue;   // TABLE sai no fim do lc_main
+    StmtSets S;
+    collectSets(s, S);
+
+    int level;
+    if (S.barrier) {
+      level = floorLevel = maxLevel + 1;
+    } else {
+      level = floorLevel;
+      for (int64_t c : S.reads)  level = std::max(level, lastW[c]);
+      for (int64_t c : S.writes) level = std::max({ level, lastW[c], lastR[c] });
+      level += 1;
+    }
+    for (int64_t c : S.reads)  lastR[c] = std::max(lastR[c], level);
+    for (int64_t c : S.writes) lastW[c] = level;
+    maxLevel = std::max(maxLevel, level);
+
+    if (S.barrier) {
+      barriers[s] = level;
+      continue;
+    }
+    Level &L = levels[level];
+    if (L.tasks.empty() || L.cost >= MinTaskCost) {
+      L.tasks.emplace_back();
+      L.cost = 0;
+    }
+    L.tasks.back().push_back(s);
+    L.cost += S.cost;
+  }
+
+  // uma função lc_task_N por tarefa; o corpo é gerado na ordem do programa
+  std::vector<std::pair<Function*, BasicBlock*>> funcs;
+  std::map<int, std::vector<size_t>> levelFuncs;
+  size_t total = 0;
+  for (auto &lv : levels) total += lv.second.tasks.size();
+  funcs.reserve(total);
+  for (auto &lv : levels) {
+    for (auto &task : lv.second.tasks) {
+      Function *TF = Function::Create(
+        TaskTy, Function::ExternalLinkage,
+        SymPrefix + "_task_" + std::to_string(funcs.size()), TheModuleRaw);
+      for (auto &A : TF->args()) A.addAttr(Attribute::NoAlias);
+      funcs.emplace_back(TF, BasicBlock::Create(*TheContext, "entry", TF));
+      levelFuncs[lv.first].push_back(funcs.size() - 1);
+      for (Stmt *s : task) where[s] = &funcs.back();
+    }
+  }
+
+  llvm::Type *i64     = llvm::Type::getInt64Ty(*TheContext);
+  llvm::Type *taskPtr = PointerType::get(TaskTy, 0);
+  FunctionCallee parRun = TheModuleRaw->getOrInsertFunction(
+    "par_run",
+    FunctionType::get(llvm::Type::getVoidTy(*TheContext),
+                      { PointerType::get(taskPtr, 0), i64,
+                        TaskTy->getParamType(0), TaskTy->getParamType(1),
+                        TaskTy->getParamType(2), TaskTy->getParamType(3),
+                        TaskTy->getParamType(4) },
+                      false));
+
+  BasicBlock *MainBB = BasicBlock::Create(*TheContext, "entry", MainF);
+  auto emitLevels = [&](int upTo) {
+    Builder->SetInsertPoint(MainBB);
+    setCellArgs(MainF);
+    while (!levelFuncs.empty() && levelFuncs.begin()->first < upTo) {
+      std::vector<size_t> &ids = levelFuncs.begin()->second;
+      if (ids.size() == 1) {
+        Builder->CreateCall(funcs[ids[0]].first, cellArgs());
+      } else {
+        std::vector<Constant*> fs;
+        for (size_t id : ids) fs.push_back(funcs[id].first);
+        ArrayType *arrTy = ArrayType::get(taskPtr, fs.size());
+        auto *arr = new GlobalVariable(
+          *TheModuleRaw, arrTy, true, GlobalValue::PrivateLinkage,
+          ConstantArray::get(arrTy, fs), "lc_level");
+        Builder->CreateCall(parRun, {
+          Builder->CreateConstInBoundsGEP2_64(arrTy, arr, 0, 0),
+          ConstantInt::get(i64, fs.size()), CurNum, CurText, CurIval, CurKind,
+          CurAssigned });
+      }
+      levelFuncs.erase(levelFuncs.begin());
+    }
+  };
+
+  for (Stmt *s = program; s; s = s->next) {
+    if (s->kind == STMT_TABLE) continue;
+    Stmt *next = s->next;
+    s->next = nullptr;
+    auto it = where.find(s);
+    if (it == where.end()) {
+      // barreira: níveis anteriores, depois o próprio statement no lc_main
+      emitLevels(barriers[s]);
+      setCellArgs(MainF);
+      codegenStmtList(s, MainF, MainBB);
+    } else {
+      Function   *TF = it->second->first;
+      BasicBlock *&TB = it->second->second;
+      setCellArgs(TF);
+      Builder->SetInsertPoint(TB);
+      codegenStmtList(s, TF, TB);
+    }
+    s->next = next;
+  }
+  emitLevels(INT32_MAX);
+
+  for (auto &f : funcs) {
+    Builder->SetInsertPoint(f.second);
+    Builder->CreateRetVoid();
+  }
+  return MainBB;
+}
+
+// ——— --profile: pontos e relatório ———————————————————————————————————————
+// Numera os statements na ordem do fonte, incluindo os de dentro de
+// IF/WHILE; TABLE não gera código e fica de fora
+static void numberSites(Stmt *s, std::vector<Stmt*> &sites) {
+  for (; s; s = s->next) {
+    if (s->kind == STMT_TABLE) continue;
+    ProfSite[s] = (int64_t)sites.size();
+    sites.push_back(s);
+    if (s->kind == STMT_IF)    numberSites(s->ifs.then_branch, sites);
+    if (s->kind == STMT_WHILE) numberSites(s->whiles.body, sites);
+  }
+}
+
+// lc_profile_report(pontos, n, lc_prof, ciclos do lc_main) no ponto atual
+// do lc_main; com ciclos, o rdtsc inicial vai para o começo da entrada
+static void emitProfileReport(Function *MainF, const std::vector<Stmt*> &sites) {
+  auto *i8ptr = llvm::PointerType::get(llvm::Type::getInt8Ty(*TheContext), 0);
+  StructType *siteTy = StructType::get(*TheContext, { i64Ty(), i64Ty(), i8ptr });
+
+  std::vector<llvm::Constant*> descs;
+  for (Stmt *s : sites) {
+    llvm::Constant *src = ConstantPointerNull::get(i8ptr);
+    if (s->line > 0 && (size_t)s->line <= SourceLines.size())
+      src = cast<llvm::Constant>(
+        Builder->CreateGlobalStringPtr(SourceLines[s->line - 1], "src"));
+    descs.push_back(ConstantStruct::get(siteTy, {
+      ConstantInt::get(i64Ty(), s->line), ConstantInt::get(i64Ty(), s->kind), src }));
+  }
+  ArrayType *arrTy = ArrayType::get(siteTy, descs.size());
+  auto *arr = new GlobalVariable(*TheModuleRaw, arrTy, true,
+                                 GlobalValue::PrivateLinkage,
+                                 ConstantArray::get(arrTy, descs), "lc_prof_sites");
+
+  Value *total = ConstantInt::get(i64Ty(), 0);
+  if (Profile == PROFILE_CYCLES) {
+    BasicBlock &entry = MainF->getEntryBlock();
+    IRBuilder<> EB(&entry, entry.begin());
+    total = Builder->CreateSub(readCycles(*Builder), readCycles(EB), "cycles");
+  }
+  auto reportFn = TheModuleRaw->getOrInsertFunction(
+    "lc_profile_report",
+    FunctionType::get(llvm::Type::getVoidTy(*TheContext),
+                      { PointerType::get(siteTy, 0), i64Ty(),
+                        PointerType::get(i64Ty(), 0), i64Ty() }, false));
+  Builder->CreateCall(reportFn, {
+    Builder->CreateConstInBoundsGEP2_64(arrTy, arr, 0, 0),
+    ConstantInt::get(i64Ty(), sites.size()),
+    Builder->CreateConstInBoundsGEP2_64(ProfCounters->getValueType(),
+                                        ProfCounters, 0, 0),
+    total });
 }
 
 // ——— monta o `main` + TABLE + verifica e finaliza JIT ——————————————————————
-void generate_code(Stmt *program) {
-  llvm::Type *doubleTy = llvm::Type::getDoubleTy(TheContext);
-  FunctionType *FT = FunctionType::get(doubleTy, false);
+// Gera lc_main, os chunks/tarefas e o TABLE final no módulo corrente
+static void buildModule(Stmt *program) {
+  llvm::Type *doubleTy = llvm::Type::getDoubleTy(*TheContext);
+
+  // double lc_main(double *num, i8 **text, i64 *ival, i8 *kind,
+  // i8 *assigned): os
+  // ponteiros do CellStore são repassados a todas as funções geradas
+  FunctionType *FT = FunctionType::get(doubleTy, cellParamTypes(), false);
   Function *MainF = Function::Create(
     FT,
     Function::ExternalLinkage,
-    "main",
+    SymPrefix + "_main",
     TheModuleRaw
   );
-  BasicBlock *BB = BasicBlock::Create(TheContext, "entry", MainF);
-  Builder.SetInsertPoint(BB);
-
-  codegenStmtList(program, MainF, BB);
+  // as colunas são arrays distintos, só acessados por ponteiros derivados
+  // deles: com noalias, o que o runtime recebe não invalida as células
+  // mantidas em registrador
+  for (auto &A : MainF->args()) A.addAttr(Attribute::NoAlias);
 
-  // imprime TABLE
+  RangeIndexes.clear();
+  if (!Parallel) collectIndexes(program);
 
-  // 1) numéricos
-  Value *fmtNum = Builder.CreateGlobalStringPtr("%s\t%g\n", "fmtNum");
-  for (auto &pr : CellMap) {
-    Value *nameStr = Builder.CreateGlobalStringPtr(pr.first, "cname");
-    Value *val     = Builder.CreateLoad(
-                       pr.second->getValueType(),
-                       pr.second
-                     );
-    Builder.CreateCall(PrintfFunc, { fmtNum, nameStr, val });
+  // --profile: um ponto com três contadores por statement
+  std::vector<Stmt*> sites;
+  ProfSite.clear();
+  ProfCounters = nullptr;
+  if (Profile != PROFILE_OFF) {
+    numberSites(program, sites);
+    ArrayType *cTy = ArrayType::get(i64Ty(), 3 * sites.size());
+    ProfCounters = new GlobalVariable(*TheModuleRaw, cTy, false,
+                                      GlobalValue::InternalLinkage,
+                                      ConstantAggregateZero::get(cTy), "lc_prof");
   }
 
-  // 2) textos
-  Value *fmtText = Builder.CreateGlobalStringPtr("%s\t%s\n", "fmtText");
-  for (auto &pr : TextMap) {
-    Value *nameStr = Builder.CreateGlobalStringPtr(pr.first, "cnameTxt");
-    Value *txtPtr  = Builder.CreateLoad(
-                       pr.second->getValueType(),
-                       pr.second
-                     );
-    Builder.CreateCall(PrintfFunc, { fmtText, nameStr, txtPtr });
+  // statements de topo em blocos de StmtsPerChunk, cada bloco numa função
+  // própria chamada em sequência pelo lc_main; no modo paralelo, em tarefas
+  // agrupadas por nível de dependência
+  FunctionType *ChunkTy = FunctionType::get(
+    llvm::Type::getVoidTy(*TheContext), cellParamTypes(), false);
+  std::vector<Function*> chunks;
+  BasicBlock *BB = nullptr;
+  if (Parallel) BB = emitParallel(program, MainF, ChunkTy);
+  for (Stmt *s = Parallel ? nullptr : program; s; ) {
+    Stmt *first = s, *last = s;
+    for (int n = 1; n < StmtsPerChunk && last->next; ++n) last = last->next;
+    s = last->next;
+    last->next = nullptr;
+
+    Function *ChunkF = Function::Create(
+      ChunkTy,
+      Function::ExternalLinkage,
+      SymPrefix + "_chunk_" + std::to_string(chunks.size()),
+      TheModuleRaw
+    );
+    for (auto &A : ChunkF->args()) A.addAttr(Attribute::NoAlias);
+    setCellArgs(ChunkF);
+    BasicBlock *CB = BasicBlock::Create(*TheContext, "entry", ChunkF);
+    Builder->SetInsertPoint(CB);
+    codegenStmtList(first, ChunkF, CB);
+    Builder->CreateRetVoid();
+    chunks.push_back(ChunkF);
+
+    last->next = s;
   }
 
-  Builder.CreateRet(ConstantFP::get(doubleTy, APFloat(0.0)));
+  setCellArgs(MainF);
+  if (!BB) BB = BasicBlock::Create(*TheContext, "entry", MainF);
+  Builder->SetInsertPoint(BB);
+  for (Function *ChunkF : chunks)
+    Builder->CreateCall(ChunkF, cellArgs());
+
+  // imprime TABLE: as células atribuídas, numa única chamada
+  std::vector<Value*> tableArgs = cellArgs();
+  tableArgs.insert(tableArgs.begin(), gridTable());
+  Builder->CreateCall(lcTableFn(), tableArgs);
+  if (ProfCounters) emitProfileReport(MainF, sites);
+
+  Builder->CreateRet(ConstantFP::get(doubleTy, APFloat(0.0)));
 
   // verifica o módulo
   if (verifyModule(*TheModuleRaw, &errs())) {
@@ -461,18 +1811,462 @@ void generate_code(Stmt *program) {
     TheModuleRaw->print(outs(), nullptr);
     std::exit(1);
   }
+}
+
+static CodegenStats Stats;
+
+static double secondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+CodegenStats codegen_stats(void) {
+  CodegenStats s = Stats;
+  s.code_bytes = CodeBytes;
+  return s;
+}
+
+void set_emit_listing(int ir, int asm_) {
+  EmitIR  = ir != 0;
+  EmitAsm = asm_ != 0;
+}
+
+// funções definidas, blocos básicos e instruções de M
+static void countIR(const Module &M) {
+  Stats.functions = Stats.blocks = Stats.insts = 0;
+  for (const Function &F : M) {
+    if (F.isDeclaration()) continue;
+    Stats.functions++;
+    for (const BasicBlock &BB : F) {
+      Stats.blocks++;
+      Stats.insts += (int64_t)BB.size();
+    }
+  }
+}
+
+// --emit-ir / --emit-asm de um módulo já otimizado. O assembly sai de uma
+// cópia: os passes de geração de código mexem no IR, e M ainda vai para o
+// JIT ou para o objeto.
+static void printListings(const Module &M) {
+  if (EmitIR) {
+    outs() << "===== IR gerado =====\n";
+    M.print(outs(), nullptr);
+    outs() << "=====================\n";
+  }
+  if (EmitAsm) {
+    if (std::unique_ptr<TargetMachine> TM = hostTargetMachine(Reloc::PIC_)) {
+      std::unique_ptr<Module> Copy = CloneModule(M);
+      Copy->setTargetTriple(TM->getTargetTriple().str());
+      Copy->setDataLayout(TM->createDataLayout());
+      SmallString<0> text;
+      raw_svector_ostream os(text);
+      legacy::PassManager PM;
+      if (TM->addPassesToEmitFile(PM, os, nullptr, CGFT_AssemblyFile))
+        std::fprintf(stderr, "Erro: o target não sabe emitir assembly\n");
+      else
+        PM.run(*Copy);
+      outs() << "===== assembly gerado =====\n" << text
+             << "===========================\n";
+    }
+  }
+  outs().flush();   // antes da saída do programa, que vai direto para stdout
+}
+
+// Acerto no cache: o objeto que getObject devolve para a chave entra
+// direto no MCJIT, e o módulo ainda vazio deixa de ter a chave (o MCJIT o
+// compila sem consultar nem gravar o cache). Um objeto ilegível, ou em que
+// lc_main não se resolve, é apagado e conta como falta: o programa é gerado
+// de novo, num módulo novo se o vazio já foi finalizado.
+static bool loadCachedObject() {
+  auto *Cache = static_cast<DiskObjectCache*>(TheObjectCache.get());
+  std::unique_ptr<MemoryBuffer> Buf = Cache->getObject(TheModuleRaw);
+  if (!Buf) return false;
+
+  auto Obj = object::ObjectFile::createObjectFile(Buf->getMemBufferRef());
+  bool hasMain = false;
+  if (Obj) {
+    for (const object::SymbolRef &Sym : (*Obj)->symbols()) {
+      Expected<StringRef> Name  = Sym.getName();
+      Expected<uint32_t>  Flags = Sym.getFlags();
+      if (Name && Flags && *Name == "lc_main" &&
+          !(*Flags & object::SymbolRef::SF_Undefined))
+        hasMain = true;
+      if (!Name)  consumeError(Name.takeError());
+      if (!Flags) consumeError(Flags.takeError());
+    }
+  } else {
+    consumeError(Obj.takeError());
+  }
+  if (!hasMain) {
+    Cache->remove(CacheKey);
+    return false;
+  }
+
+  TheModuleRaw->setModuleIdentifier("LangCellModule");
+  TheExecutionEngine->addObjectFile(
+    object::OwningBinary<object::ObjectFile>(std::move(*Obj), std::move(Buf)));
+  TheExecutionEngine->finalizeObject();
+  if (TheExecutionEngine->getFunctionAddress("lc_main")) return true;
+
+  Cache->remove(CacheKey);
+  auto M = std::make_unique<Module>(CacheKey, *TheContext);
+  M->setDataLayout(TheExecutionEngine->getDataLayout());
+  TheModuleRaw = M.get();
+  TheExecutionEngine->addModule(std::move(M));
+  return false;
+}
+
+void generate_code(Stmt *program) {
+  // retângulo de células calculado pela sema → offsets fixos no grid
+  TheLayout = *sema_layout();
+  Stats = CodegenStats();
+  auto t0 = std::chrono::steady_clock::now();
+
+  // com o cache, o módulo tem a chave como identificador: o objeto que o
+  // MCJIT gerar para ele é gravado no disco
+  bool useCache = JitKind == JIT_MCJIT && TheObjectCache;
+  if (useCache) {
+    TheModuleRaw->setModuleIdentifier(CacheKey);
+    if (loadCachedObject()) {
+      Stats.finalize = secondsSince(t0);
+      return;
+    }
+  }
 
-  // finalize o JIT e mostre o IR
+  buildModule(program);
+  Stats.irgen = secondsSince(t0);
+
+  // com MCJIT o módulo inteiro é otimizado aqui; com ORC cada partição é
+  // otimizada no IRTransformLayer quando for compilada
+  t0 = std::chrono::steady_clock::now();
+  if (JitKind == JIT_MCJIT)
+    optimizeModule(*TheModuleRaw, TheExecutionEngine->getTargetMachine());
+  Stats.optimize = secondsSince(t0);
+  countIR(*TheModuleRaw);
+
+  if (JitKind == JIT_ORC) {
+    // as listagens mostram o módulo inteiro otimizado numa cópia, já que o
+    // ORC só otimiza cada partição quando ela é compilada
+    if (EmitIR || EmitAsm) {
+      std::unique_ptr<Module> Copy = CloneModule(*TheModuleRaw);
+      if (std::unique_ptr<TargetMachine> TM = hostTargetMachine(Reloc::PIC_))
+        optimizeModule(*Copy, TM.get());
+      printListings(*Copy);
+    }
+    // nada é compilado aqui: o CompileOnDemandLayer só gera código para
+    // cada função quando ela é chamada
+    exitOnErr(TheLazyJIT->addLazyIRModule(
+                orc::ThreadSafeModule(std::move(TheModule), TheTSCtx)),
+              "adicionando módulo ao LLLazyJIT");
+    return;
+  }
+
+  printListings(*TheModuleRaw);
+
+  // finalize o JIT
+  t0 = std::chrono::steady_clock::now();
   TheExecutionEngine->finalizeObject();
-  outs() << "===== IR gerado =====\n";
-  TheModuleRaw->print(outs(), nullptr);
-  outs() << "=====================\n";
+  Stats.finalize = secondsSince(t0);
 }
 
-// ——— executa o `main` compilado ———————————————————————————————————————
+// ——— executa o `lc_main` compilado ————————————————————————————————————
 int run_code() {
-  Function *F = TheExecutionEngine->FindFunctionNamed("main");
-  std::vector<GenericValue> noargs;
-  GenericValue gv = TheExecutionEngine->runFunction(F, noargs);
-  return (int)gv.DoubleVal;
+  typedef double (*MainFn)(double *, const char **, int64_t *, unsigned char *,
+                           unsigned char *);
+  MainFn fn;
+  if (JitKind == JIT_ORC) {
+    auto Sym = TheLazyJIT->lookup("lc_main");
+    if (!Sym) exitOnErr(Sym.takeError(), "procurando lc_main");
+    fn = (MainFn)(intptr_t)Sym->getAddress();
+  } else {
+    fn = (MainFn)TheExecutionEngine->getFunctionAddress("lc_main");
+  }
+  if (!fn) {
+    std::fprintf(stderr, "Erro: lc_main não encontrado\n");
+    return 1;
+  }
+
+  CellStore *st = cells_alloc(layout_ncells(&TheLayout));
+  int rc = (int)fn(st->num, st->text, st->ival, st->kind, st->assigned);
+  cells_free(st);
+  return rc;
+}
+
+// ——— compilação AOT: --emit-obj / --emit-exe ————————————————————————————
+// main(void) do executável gerado: células em arrays globais zerados (o
+// equivalente ao cells_alloc do JIT) e o código de saída vem de lc_main
+static void emitMainWrapper() {
+  int64_t n = layout_ncells(&TheLayout);
+  if (n == 0) n = 1;    // programa sem células
+  llvm::Type *i8 = llvm::Type::getInt8Ty(*TheContext);
+  llvm::Type *elemTys[] = { llvm::Type::getDoubleTy(*TheContext),
+                            PointerType::get(i8, 0), i64Ty(), i8, i8 };
+  const char *names[]   = { "lc_num", "lc_text", "lc_ival", "lc_kind",
+                            "lc_assigned" };
+  std::vector<Value*> cols;
+  for (size_t i = 0; i < 5; ++i) {
+    ArrayType *arrTy = ArrayType::get(elemTys[i], n);
+    auto *G = new GlobalVariable(*TheModuleRaw, arrTy, false,
+                GlobalValue::InternalLinkage,
+                ConstantAggregateZero::get(arrTy), names[i]);
+    cols.push_back(ConstantExpr::getInBoundsGetElementPtr(
+      arrTy, G, ArrayRef<llvm::Constant*>{ ConstantInt::get(i64Ty(), 0),
+                                           ConstantInt::get(i64Ty(), 0) }));
+  }
+
+  llvm::Type *i32 = llvm::Type::getInt32Ty(*TheContext);
+  Function *F = Function::Create(FunctionType::get(i32, false),
+                                 Function::ExternalLinkage, "main",
+                                 TheModuleRaw);
+  Builder->SetInsertPoint(BasicBlock::Create(*TheContext, "entry", F));
+  Value *rc = Builder->CreateCall(TheModuleRaw->getFunction("lc_main"), cols);
+  Builder->CreateRet(Builder->CreateFPToSI(rc, i32));
+}
+
+// liblcrt.a: LANGCELL_RUNTIME, senão ao lado do executável do langcell
+static std::string runtimeLibrary() {
+  if (const char *p = std::getenv("LANGCELL_RUNTIME")) return p;
+  std::string exe = sys::fs::getMainExecutable(nullptr, (void *)&runtimeLibrary);
+  SmallString<256> P(sys::path::parent_path(exe));
+  sys::path::append(P, "liblcrt.a");
+  return std::string(P.str());
+}
+
+int emit_native(Stmt *program, const char *path, int link_exe) {
+  initModule("LangCellModule");
+  TheLayout = *sema_layout();
+
+  // PIC: o objeto vai ser ligado num executável PIE pelo compilador C
+  std::unique_ptr<TargetMachine> TM = hostTargetMachine(Reloc::PIC_);
+  if (!TM) return 1;
+  TheModuleRaw->setTargetTriple(TM->getTargetTriple().str());
+  TheModuleRaw->setDataLayout(TM->createDataLayout());
+
+  Stats = CodegenStats();
+  auto t0 = std::chrono::steady_clock::now();
+  buildModule(program);
+  if (link_exe) emitMainWrapper();
+  Stats.irgen = secondsSince(t0);
+  t0 = std::chrono::steady_clock::now();
+  optimizeModule(*TheModuleRaw, TM.get());
+  Stats.optimize = secondsSince(t0);
+  countIR(*TheModuleRaw);
+  printListings(*TheModuleRaw);
+
+  // objeto: direto em 'path', ou num temporário que o linker consome
+  SmallString<128> objPath(path);
+  if (link_exe &&
+      sys::fs::createTemporaryFile("langcell", "o", objPath)) {
+    std::fprintf(stderr, "Erro criando arquivo temporário\n");
+    return 1;
+  }
+  {
+    // o objeto é gerado em memória para medir as seções de código
+    t0 = std::chrono::steady_clock::now();
+    SmallVector<char, 0> obj;
+    raw_svector_ostream objOS(obj);
+    legacy::PassManager PM;
+    if (TM->addPassesToEmitFile(PM, objOS, nullptr, CGFT_ObjectFile)) {
+      std::fprintf(stderr, "Erro: o target não sabe emitir objetos\n");
+      return 1;
+    }
+    PM.run(*TheModuleRaw);
+    Stats.finalize = secondsSince(t0);
+    auto O = object::ObjectFile::createObjectFile(
+               MemoryBufferRef(StringRef(obj.data(), obj.size()), "lc"));
+    if (O) {
+      for (const object::SectionRef &S : (*O)->sections())
+        if (S.isText()) CodeBytes += (int64_t)S.getSize();
+    } else {
+      consumeError(O.takeError());
+    }
+
+    std::error_code EC;
+    raw_fd_ostream os(objPath, EC, sys::fs::OF_None);
+    if (EC) {
+      std::fprintf(stderr, "Erro abrindo %s: %s\n",
+                   objPath.c_str(), EC.message().c_str());
+      return 1;
+    }
+    os.write(obj.data(), obj.size());
+  }
+  if (!link_exe) return 0;
+
+  // cc objeto.o liblcrt.a -lm -lpthread -o path ($CC, se definido)
+  const char *cc = std::getenv("CC");
+  auto ccPath = sys::findProgramByName(cc && *cc ? cc : "cc");
+  if (!ccPath) {
+    std::fprintf(stderr, "Erro: compilador C não encontrado para ligar %s\n",
+                 path);
+    sys::fs::remove(objPath);
+    return 1;
+  }
+  std::string lib = runtimeLibrary();
+  std::vector<StringRef> args = { *ccPath, objPath, lib,
+                                  "-lm", "-lpthread", "-o", path };
+  std::string err;
+  int rc = sys::ExecuteAndWait(*ccPath, args, None, {}, 0, 0, &err);
+  sys::fs::remove(objPath);
+  if (rc != 0) {
+    std::fprintf(stderr, "Erro ligando %s com %s%s%s\n", path, lib.c_str(),
+                 err.empty() ? "" : ": ", err.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+// ——— modo tiered: compila um WHILE quente —————————————————————————————————
+// Cada laço vai para um módulo próprio, adicionado ao motor já existente (o
+// LLVM só é inicializado quando o primeiro laço fica quente). A função gerada
+// roda o WHILE inteiro a partir do teste da condição, lendo e escrevendo nas
+// colunas do ValueStore do interpretador.
+JitLoopFn jit_compile_loop(Stmt *loop) {
+  if (!TheContext) init_llvm("LangCellModule");
+  TheLayout = *sema_layout();
+
+  static int nloops = 0;
+  std::string name = "lc_loop_" + std::to_string(nloops++);
+  auto M = std::make_unique<Module>(name, *TheContext);
+  M->setDataLayout(JitKind == JIT_ORC ? TheLazyJIT->getDataLayout()
+                                      : TheExecutionEngine->getDataLayout());
+  Module *saved = TheModuleRaw;
+  TheModuleRaw  = M.get();
+  ++ModuleId;
+
+  // void lc_loop_N(double *num, i64 *ival, i8 *kind, i8 *assigned)
+  std::vector<llvm::Type*> cols = cellParamTypes();
+  FunctionType *FT = FunctionType::get(
+    llvm::Type::getVoidTy(*TheContext), { cols[0], cols[2], cols[3], cols[4] }, false);
+  Function *F = Function::Create(FT, Function::ExternalLinkage, name, M.get());
+  for (auto &A : F->args()) A.addAttr(Attribute::NoAlias);
+
+  CurNum      = F->getArg(0);
+  CurIval     = F->getArg(1);
+  CurKind     = F->getArg(2);
+  CurAssigned = F->getArg(3);
+  CurNum->setName("num");
+  CurIval->setName("ival");
+  CurKind->setName("kind");
+  CurAssigned->setName("assigned");
+  InterpSemantics = true;
+  RangeIndexes.clear();
+
+  BasicBlock *BB = BasicBlock::Create(*TheContext, "entry", F);
+  Builder->SetInsertPoint(BB);
+  codegenStmtList(loop, F, BB);
+  Builder->CreateRetVoid();
+
+  InterpSemantics = false;
+  TheModuleRaw    = saved;
+
+  if (verifyModule(*M, &errs())) {
+    errs() << "=== ERRO de verificação do laço " << name << " ===\n";
+    return nullptr;
+  }
+
+  if (JitKind == JIT_ORC) {
+    exitOnErr(TheLazyJIT->addLazyIRModule(
+                orc::ThreadSafeModule(std::move(M), TheTSCtx)),
+              "adicionando laço ao LLLazyJIT");
+    auto Sym = TheLazyJIT->lookup(name);
+    if (!Sym) exitOnErr(Sym.takeError(), "procurando laço");
+    return (JitLoopFn)(intptr_t)Sym->getAddress();
+  }
+
+  optimizeModule(*M, TheExecutionEngine->getTargetMachine());
+  TheExecutionEngine->addModule(std::move(M));
+  TheExecutionEngine->finalizeObject();
+  return (JitLoopFn)TheExecutionEngine->getFunctionAddress(name);
+}
+
+// ——— modo --serve: planilhas residentes ————————————————————————————————
+// Como os laços do tiered, cada planilha vai para um módulo próprio no motor
+// já existente; os símbolos levam o nome da planilha. No ORC o módulo entra
+// no Main com um ResourceTracker próprio, fora do CompileOnDemandLayer: o
+// LLVM 14 só aceita tracker no addIRModule, e o código das partições que o
+// CompileOnDemandLayer gera fica num dylib ".impl" que nenhum tracker
+// remove. A compilação fica para o primeiro jit_sheet_entry, no worker.
+struct JitSheet {
+  std::string            entry;
+  std::atomic<SheetFn>   fn{nullptr};
+  orc::ResourceTrackerSP RT;           // ORC
+  Module                *M = nullptr;  // MCJIT
+};
+
+JitSheet *jit_compile_sheet(Stmt *program, const char *name) {
+  if (!TheContext) init_llvm("LangCellModule");
+  TheLayout = *sema_layout();
+
+  // Com o ORC cada planilha ganha o próprio LLVMContext: o módulo é
+  // compilado no worker que a roda primeiro, com a trava desse contexto, e
+  // gerar aqui o IR da próxima planilha num contexto comum correria com
+  // essas compilações. O MCJIT compila tudo no finalizeObject, ainda dentro
+  // do CompileLock do servidor, e fica no contexto global.
+  orc::ThreadSafeContext SheetCtx = TheTSCtx;
+  LLVMContext *savedCtx = TheContext;
+  std::unique_ptr<IRBuilder<>> savedBuilder;
+  if (JitKind == JIT_ORC) {
+    SheetCtx     = orc::ThreadSafeContext(std::make_unique<LLVMContext>());
+    TheContext   = SheetCtx.getContext();
+    savedBuilder = std::move(Builder);
+    Builder      = std::make_unique<IRBuilder<>>(*TheContext);
+  }
+
+  auto M = std::make_unique<Module>(name, *TheContext);
+  M->setDataLayout(JitKind == JIT_ORC ? TheLazyJIT->getDataLayout()
+                                      : TheExecutionEngine->getDataLayout());
+  Module *saved = TheModuleRaw;
+  TheModuleRaw  = M.get();
+  ++ModuleId;
+  SymPrefix = name;
+  buildModule(program);
+  SymPrefix    = "lc";
+  TheModuleRaw = saved;
+
+  auto *S  = new JitSheet;
+  S->entry = std::string(name) + "_main";
+  if (JitKind == JIT_ORC) {
+    Builder    = std::move(savedBuilder);
+    TheContext = savedCtx;
+    S->RT = TheLazyJIT->getMainJITDylib().createResourceTracker();
+    exitOnErr(TheLazyJIT->addIRModule(
+                S->RT, orc::ThreadSafeModule(std::move(M), SheetCtx)),
+              "adicionando planilha ao LLLazyJIT");
+    return S;
+  }
+
+  optimizeModule(*M, TheExecutionEngine->getTargetMachine());
+  S->M = M.get();
+  TheExecutionEngine->addModule(std::move(M));
+  TheExecutionEngine->finalizeObject();
+  S->fn = (SheetFn)TheExecutionEngine->getFunctionAddress(S->entry);
+  if (!S->fn) {
+    jit_release_sheet(S);
+    return nullptr;
+  }
+  return S;
+}
+
+SheetFn jit_sheet_entry(JitSheet *sheet) {
+  SheetFn fn = sheet->fn.load(std::memory_order_acquire);
+  if (fn) return fn;
+  // ORC: o lookup materializa (otimiza e compila) o módulo neste thread;
+  // lookups simultâneos esperam a mesma compilação
+  auto Sym = TheLazyJIT->lookup(sheet->entry);
+  if (!Sym) exitOnErr(Sym.takeError(), "procurando planilha");
+  fn = (SheetFn)(intptr_t)Sym->getAddress();
+  sheet->fn.store(fn, std::memory_order_release);
+  return fn;
+}
+
+void jit_release_sheet(JitSheet *sheet) {
+  if (!sheet) return;
+  if (sheet->RT) {
+    exitOnErr(sheet->RT->remove(), "removendo planilha do LLLazyJIT");
+  } else if (sheet->M) {
+    // o MCJIT devolve o módulo; a memória do código nativo fica no
+    // gerenciador de memória até o fim do processo
+    TheExecutionEngine->removeModule(sheet->M);
+    delete sheet->M;
+  }
+  delete sheet;
 }
@@ -3,16 +3,105 @@
 #ifndef LANGCELL_CODEGEN_H
 #define LANGCELL_CODEGEN_H
 
+#include <stddef.h>
 #include "ast.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Motores de execução do JIT
+typedef enum {
+    JIT_MCJIT,   // MCJIT: compila o módulo inteiro antes de rodar
+    JIT_ORC      // ORC LLLazyJIT: compila cada função na primeira chamada
+} JitEngine;
+
+// Deve ser chamada antes de init_llvm; compile_threads > 0 faz o ORC
+// compilar num thread pool em background.
+void set_jit_options(JitEngine engine, unsigned compile_threads);
+
+// Nível do pipeline de otimização (0..3), como -O0 .. -O3. Padrão: 2.
+void set_opt_level(int level);
+
+// Modo paralelo: statements de topo independentes (sem conflito entre os
+// conjuntos de leitura/escrita) rodam em paralelo no pool de pool.c.
+// Deve ser chamada antes de generate_code.
+void set_parallel(int on);
+
+// Cache em disco dos objetos gerados pelo MCJIT, em 'dir' (NULL desliga).
+// A chave combina o fonte do programa, a versão do LLVM, a CPU do host, o
+// nível de otimização e o modo paralelo; num acerto, generate_code não gera
+// IR e o objeto é carregado do disco. Chamar depois de set_opt_level e
+// set_parallel, antes de init_llvm.
+void set_object_cache(const char *dir, const char *source, size_t len);
+
 void init_llvm(const char *module_name);
 void generate_code(Stmt *program);
 int  run_code(void);
 
+// --profile: o código gerado conta as execuções de cada statement, as
+// vezes que cada IF foi tomado e as voltas de cada WHILE (com
+// PROFILE_CYCLES, também os ciclos de rdtsc) e imprime o relatório em
+// stderr no fim do lc_main, anotado com as linhas de 'source'. Com
+// PROFILE_OFF nada é instrumentado. Chamar antes de generate_code ou
+// emit_native; o modo tiered não é instrumentado.
+typedef enum { PROFILE_OFF, PROFILE_HITS, PROFILE_CYCLES } ProfileMode;
+void set_profile(ProfileMode mode, const char *source, size_t len);
+
+// Listagens opcionais em stdout (--emit-ir, --emit-asm): o IR depois do
+// pipeline de otimização e o assembly do host, antes da saída do programa.
+// Chamar antes de generate_code ou emit_native.
+void set_emit_listing(int ir, int asm_);
+
+// Estatísticas do último generate_code/emit_native (--stats). Tempos de
+// parede em segundos: geração de IR, pipeline de otimização e geração/
+// finalização do código nativo. Com ORC a compilação só acontece nas
+// chamadas (entra no tempo de run_code), os contadores de IR são de antes
+// da otimização e code_bytes cresce enquanto o programa roda.
+typedef struct {
+    double  irgen, optimize, finalize;
+    int64_t functions, blocks, insts;   // IR do módulo
+    int64_t code_bytes;                 // seções de código nativo geradas
+} CodegenStats;
+CodegenStats codegen_stats(void);
+
+// Compilação AOT, sem JIT: escreve o programa como objeto nativo em 'path'
+// (lc_main, chamado com os arrays de células) ou, com link_exe, gera um
+// main() e liga o objeto com liblcrt.a num executável. Não usa init_llvm.
+// Retorna 0, ou 1 em caso de erro.
+int  emit_native(Stmt *program, const char *path, int link_exe);
+
+// Modo tiered: compila um WHILE isolado (loop->next == NULL) para rodar
+// sobre o ValueStore do interpretador; ver interp_set_tiering. Inicializa o
+// LLVM na primeira chamada. JitLoopFn é o mesmo tipo que TierLoopFn
+// (interp.h, que não é incluído aqui por causa do 'Value' de store.h).
+typedef void (*JitLoopFn)(double *num, int64_t *ival, unsigned char *kind,
+                          unsigned char *assigned);
+JitLoopFn jit_compile_loop(Stmt *loop);
+
+// Modo --serve: compila um programa já analisado pela sema (o layout é o
+// de sema_layout) num módulo próprio, adicionado ao motor já existente.
+// jit_sheet_entry devolve a função de entrada, com a assinatura do lc_main:
+// roda o programa sobre as colunas num/text/ival/kind/assigned
+// (layout_ncells posições, como no CellStore de cells.h) e imprime o TABLE
+// final. 'name' prefixa os símbolos do módulo e precisa ser único no
+// processo; retorna NULL se o MCJIT não gerar o código.
+// jit_compile_sheet e jit_release_sheet não podem ser concorrentes entre si,
+// mas podem correr com jit_sheet_entry e a execução das outras planilhas.
+// No ORC o código só é gerado na primeira chamada de jit_sheet_entry, no
+// thread que a fez; as funções devolvidas podem rodar em paralelo, cada
+// chamada com os próprios arrays.
+typedef double (*SheetFn)(double *num, const char **text, int64_t *ival,
+                          unsigned char *kind, unsigned char *assigned);
+typedef struct JitSheet JitSheet;
+JitSheet *jit_compile_sheet(Stmt *program, const char *name);
+SheetFn   jit_sheet_entry(JitSheet *sheet);
+
+// Tira do motor o módulo de uma planilha substituída ou descartada e libera
+// o IR e (no ORC) o código gerado. Nenhuma chamada da SheetFn pode estar em
+// curso.
+void jit_release_sheet(JitSheet *sheet);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,626 @@
+// csv.c
+// IMPORT "arq.csv" AT célula (ver import_csv em runtime.h): o arquivo é
+// mapeado com mmap, os separadores são achados 16 bytes por vez com SSE2 e
+// os números vão direto para as células, sem passar pelo lexer/parser.
+// Também a saída de TABLE/EXPORT (ver csv.h e lc_table/lc_export).
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "runtime.h"
+#include "cells.h"
+#include "csv.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Próximo ',' ou '\n' em [p, end), ou end
+static const char *next_delim(const char *p, const char *end) {
+#if defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i nl    = _mm_set1_epi8('\n');
+    for (; p + 16 <= end; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        int m = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, comma),
+                                               _mm_cmpeq_epi8(v, nl)));
+        if (m) return p + __builtin_ctz(m);
+    }
+#endif
+    while (p < end && *p != ',' && *p != '\n') p++;
+    return p;
+}
+
+// Potências de 10 exatas em double (10^22 é a maior)
+static const double Pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Converte o campo [p, end) inteiro em número. Caminho rápido de Clinger:
+// mantissa até 2^53 e expoente decimal em [-22, 22] dão um resultado
+// exato com uma única multiplicação/divisão; o resto (muitos dígitos,
+// expoentes grandes, inf/nan) cai no strtod. Retorna 0 se não é número.
+static int parse_number(const char *p, const char *end, double *out) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    if (p == end) return 0;
+
+    const char *s = p;
+    int neg = 0;
+    if (*s == '-' || *s == '+') neg = *s++ == '-';
+    uint64_t m = 0;
+    int digits = 0, exp10 = 0, seen = 0;
+    for (; s < end && *s >= '0' && *s <= '9'; ++s, ++seen) {
+        if (m || *s != '0') digits++;
+        m = m * 10 + (uint64_t)(*s - '0');
+    }
+    if (s < end && *s == '.') {
+        for (++s; s < end && *s >= '0' && *s <= '9'; ++s, ++seen) {
+            if (m || *s != '0') digits++;
+            m = m * 10 + (uint64_t)(*s - '0');
+            exp10--;
+        }
+    }
+    if (seen && s < end && (*s == 'e' || *s == 'E')) {
+        const char *e = s + 1;
+        int eneg = 0, ev = 0, edigits = 0;
+        if (e < end && (*e == '-' || *e == '+')) eneg = *e++ == '-';
+        for (; e < end && *e >= '0' && *e <= '9'; ++e, ++edigits)
+            if (ev < 10000) ev = ev * 10 + (*e - '0');
+        if (edigits) {
+            exp10 += eneg ? -ev : ev;
+            s = e;
+        }
+    }
+    if (seen && s == end && digits <= 19 && m <= (1ULL << 53) &&
+        exp10 >= -22 && exp10 <= 22) {
+        double v = (double)m;
+        v = exp10 < 0 ? v / Pow10[-exp10] : v * Pow10[exp10];
+        *out = neg ? -v : v;
+        return 1;
+    }
+
+    // strtod precisa de um buffer terminado em '\0'
+    char buf[128];
+    size_t n = (size_t)(end - p);
+    if (n >= sizeof buf) return 0;
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    char *stop;
+    double v = strtod(buf, &stop);
+    if (stop == buf || *stop) return 0;
+    *out = v;
+    return 1;
+}
+
+// Campo [p, end) é um nome de célula ("B7")? Formato do EXPORT: célula,valor
+static int parse_cell_name(const char *p, const char *end,
+                           int64_t *col, int64_t *row) {
+    char buf[32];
+    size_t n = (size_t)(end - p);
+    if (n == 0 || n >= sizeof buf) return 0;
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+    return cell_parse(buf, col, row) == 0;
+}
+
+// Campo entre aspas: pula até a aspa de fechamento ("" é aspa escapada)
+static const char *skip_quoted(const char *p, const char *end) {
+    for (++p; p < end; ++p) {
+        const char *q = memchr(p, '"', (size_t)(end - p));
+        if (!q) return end;
+        if (q + 1 < end && q[1] == '"') { p = q + 1; continue; }
+        return q + 1;
+    }
+    return end;
+}
+
+typedef struct {
+    const CellLayout *grid;
+    double           *num;
+    unsigned char    *kind;
+    unsigned char    *assigned;
+    ImportCellFn      on_cell;
+    void             *ctx;
+    int64_t           written;
+} Sink;
+
+static void put(Sink *k, int64_t col, int64_t row, double v) {
+    int64_t slot = layout_find(k->grid, col, row);
+    if (slot < 0) return;
+    if (k->on_cell) k->on_cell(k->ctx, slot, v);
+    else {
+        k->num[slot] = v;
+        if (k->kind)     k->kind[slot]     = V_FLOAT;
+        if (k->assigned) k->assigned[slot] = 1;
+    }
+    k->written++;
+}
+
+int64_t import_csv(const char *filename, int64_t at_col, int64_t at_row,
+                   const CellLayout *grid, double *num, unsigned char *kind,
+                   unsigned char *assigned, ImportCellFn on_cell, void *ctx) {
+    int fd = open(filename, O_RDONLY);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) != 0) {
+        perror(filename);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if (sb.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    const char *data = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror(filename);
+        return -1;
+    }
+    madvise((void *)data, (size_t)sb.st_size, MADV_SEQUENTIAL);
+
+    Sink k = { grid, num, kind, assigned, on_cell, ctx, 0 };
+    int64_t row_end = layout_row_end(grid);
+    const char *p = data, *end = data + sb.st_size;
+
+    // Arquivo no formato do EXPORT (célula,valor por linha): cada valor vai
+    // para a célula nomeada, deslocada para que A1 caia em 'AT'. Senão é
+    // uma grade: campo j da linha i vai para (at_col + j, at_row + i).
+    int64_t pc, pr;
+    const char *d = next_delim(p, end);
+    int pairs = d < end && *d == ',' && parse_cell_name(p, d, &pc, &pr);
+
+    for (int64_t line = 0; p < end; ++line) {
+        if (!pairs && at_row + line >= row_end) break;  // abaixo do grid
+        int64_t field = 0;
+        int64_t cell_col = 0, cell_row = 0;
+        int named = 0;
+        for (;;) {
+            const char *f = p;
+            if (p < end && *p == '"') p = skip_quoted(p, end);
+            d = next_delim(p, end);
+            double v;
+            if (pairs) {
+                if (field == 0)
+                    named = parse_cell_name(f, d, &cell_col, &cell_row);
+                else if (field == 1 && named && f < d && *f != '"' &&
+                         parse_number(f, d, &v))
+                    put(&k, at_col + cell_col, at_row + cell_row - 1, v);
+            } else if (f < d && *f != '"' && parse_number(f, d, &v)) {
+                put(&k, at_col + field, at_row + line, v);
+            }
+            field++;
+            p = d + 1;
+            if (d >= end || *d == '\n') break;
+        }
+    }
+
+    munmap((void *)data, (size_t)sb.st_size);
+    return k.written;
+}
+
+// ——— saída: TABLE / EXPORT —————————————————————————————————————————————————
+
+#define OUT_SIZE (1 << 20)
+
+void out_open(OutBuf *o, FILE *f) {
+    o->f   = f;
+    o->buf = malloc(OUT_SIZE);
+    o->len = 0;
+    o->err = 0;
+    if (!o->buf) exit(1);
+}
+
+static void out_flush(OutBuf *o) {
+    if (o->len && fwrite(o->buf, 1, o->len, o->f) != o->len) o->err = 1;
+    o->len = 0;
+}
+
+int out_close(OutBuf *o) {
+    out_flush(o);
+    if (fflush(o->f) != 0) o->err = 1;
+    free(o->buf);
+    o->buf = NULL;
+    return o->err;
+}
+
+void out_bytes(OutBuf *o, const char *s, size_t n) {
+    if (o->len + n > OUT_SIZE) {
+        out_flush(o);
+        if (n > OUT_SIZE) {
+            if (fwrite(s, 1, n, o->f) != n) o->err = 1;
+            return;
+        }
+    }
+    memcpy(o->buf + o->len, s, n);
+    o->len += n;
+}
+
+void out_str(OutBuf *o, const char *s) {
+    out_bytes(o, s, strlen(s));
+}
+
+void out_char(OutBuf *o, char c) {
+    if (o->len == OUT_SIZE) out_flush(o);
+    o->buf[o->len++] = c;
+}
+
+// Dígitos decimais de m, com 'frac' deles depois do ponto
+static size_t fmt_fixed(uint64_t m, int frac, int neg, char *buf) {
+    char tmp[24];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + m % 10); m /= 10; } while (m);
+    while (n <= frac) tmp[n++] = '0';          // 0.000123
+    size_t k = 0;
+    if (neg) buf[k++] = '-';
+    for (int i = n - 1; i >= 0; --i) {
+        buf[k++] = tmp[i];
+        if (i == frac && frac > 0) buf[k++] = '.';
+    }
+    buf[k] = '\0';
+    return k;
+}
+
+// ——— fmt_double: Grisu2 (Florian Loitsch, "Printing Floating-Point Numbers
+// Quickly and Accurately with Integers", PLDI 2010) ————————————————————————
+//
+// Os dígitos saem de aritmética inteira de 64 bits sobre v escalado por uma
+// potência de 10 da tabela; o resultado sempre volta ao mesmo double e é o
+// mais curto em quase todos os casos (nos raros restantes sobra um dígito).
+
+typedef struct { uint64_t f; int e; } DiyFp;   // f · 2^e
+
+// 10^k normalizado (bit 63 ligado) e arredondado, k = -348, -340, ..., 340
+static const DiyFp CachedPow10[] = {
+    { 0xfa8fd5a0081c0288ULL, -1220 },  // 1e-348
+    { 0xbaaee17fa23ebf76ULL, -1193 },  // 1e-340
+    { 0x8b16fb203055ac76ULL, -1166 },  // 1e-332
+    { 0xcf42894a5dce35eaULL, -1140 },  // 1e-324
+    { 0x9a6bb0aa55653b2dULL, -1113 },  // 1e-316
+    { 0xe61acf033d1a45dfULL, -1087 },  // 1e-308
+    { 0xab70fe17c79ac6caULL, -1060 },  // 1e-300
+    { 0xff77b1fcbebcdc4fULL, -1034 },  // 1e-292
+    { 0xbe5691ef416bd60cULL, -1007 },  // 1e-284
+    { 0x8dd01fad907ffc3cULL,  -980 },  // 1e-276
+    { 0xd3515c2831559a83ULL,  -954 },  // 1e-268
+    { 0x9d71ac8fada6c9b5ULL,  -927 },  // 1e-260
+    { 0xea9c227723ee8bcbULL,  -901 },  // 1e-252
+    { 0xaecc49914078536dULL,  -874 },  // 1e-244
+    { 0x823c12795db6ce57ULL,  -847 },  // 1e-236
+    { 0xc21094364dfb5637ULL,  -821 },  // 1e-228
+    { 0x9096ea6f3848984fULL,  -794 },  // 1e-220
+    { 0xd77485cb25823ac7ULL,  -768 },  // 1e-212
+    { 0xa086cfcd97bf97f4ULL,  -741 },  // 1e-204
+    { 0xef340a98172aace5ULL,  -715 },  // 1e-196
+    { 0xb23867fb2a35b28eULL,  -688 },  // 1e-188
+    { 0x84c8d4dfd2c63f3bULL,  -661 },  // 1e-180
+    { 0xc5dd44271ad3cdbaULL,  -635 },  // 1e-172
+    { 0x936b9fcebb25c996ULL,  -608 },  // 1e-164
+    { 0xdbac6c247d62a584ULL,  -582 },  // 1e-156
+    { 0xa3ab66580d5fdaf6ULL,  -555 },  // 1e-148
+    { 0xf3e2f893dec3f126ULL,  -529 },  // 1e-140
+    { 0xb5b5ada8aaff80b8ULL,  -502 },  // 1e-132
+    { 0x87625f056c7c4a8bULL,  -475 },  // 1e-124
+    { 0xc9bcff6034c13053ULL,  -449 },  // 1e-116
+    { 0x964e858c91ba2655ULL,  -422 },  // 1e-108
+    { 0xdff9772470297ebdULL,  -396 },  // 1e-100
+    { 0xa6dfbd9fb8e5b88fULL,  -369 },  // 1e-92
+    { 0xf8a95fcf88747d94ULL,  -343 },  // 1e-84
+    { 0xb94470938fa89bcfULL,  -316 },  // 1e-76
+    { 0x8a08f0f8bf0f156bULL,  -289 },  // 1e-68
+    { 0xcdb02555653131b6ULL,  -263 },  // 1e-60
+    { 0x993fe2c6d07b7facULL,  -236 },  // 1e-52
+    { 0xe45c10c42a2b3b06ULL,  -210 },  // 1e-44
+    { 0xaa242499697392d3ULL,  -183 },  // 1e-36
+    { 0xfd87b5f28300ca0eULL,  -157 },  // 1e-28
+    { 0xbce5086492111aebULL,  -130 },  // 1e-20
+    { 0x8cbccc096f5088ccULL,  -103 },  // 1e-12
+    { 0xd1b71758e219652cULL,   -77 },  // 1e-4
+    { 0x9c40000000000000ULL,   -50 },  // 1e4
+    { 0xe8d4a51000000000ULL,   -24 },  // 1e12
+    { 0xad78ebc5ac620000ULL,     3 },  // 1e20
+    { 0x813f3978f8940984ULL,    30 },  // 1e28
+    { 0xc097ce7bc90715b3ULL,    56 },  // 1e36
+    { 0x8f7e32ce7bea5c70ULL,    83 },  // 1e44
+    { 0xd5d238a4abe98068ULL,   109 },  // 1e52
+    { 0x9f4f2726179a2245ULL,   136 },  // 1e60
+    { 0xed63a231d4c4fb27ULL,   162 },  // 1e68
+    { 0xb0de65388cc8ada8ULL,   189 },  // 1e76
+    { 0x83c7088e1aab65dbULL,   216 },  // 1e84
+    { 0xc45d1df942711d9aULL,   242 },  // 1e92
+    { 0x924d692ca61be758ULL,   269 },  // 1e100
+    { 0xda01ee641a708deaULL,   295 },  // 1e108
+    { 0xa26da3999aef774aULL,   322 },  // 1e116
+    { 0xf209787bb47d6b85ULL,   348 },  // 1e124
+    { 0xb454e4a179dd1877ULL,   375 },  // 1e132
+    { 0x865b86925b9bc5c2ULL,   402 },  // 1e140
+    { 0xc83553c5c8965d3dULL,   428 },  // 1e148
+    { 0x952ab45cfa97a0b3ULL,   455 },  // 1e156
+    { 0xde469fbd99a05fe3ULL,   481 },  // 1e164
+    { 0xa59bc234db398c25ULL,   508 },  // 1e172
+    { 0xf6c69a72a3989f5cULL,   534 },  // 1e180
+    { 0xb7dcbf5354e9beceULL,   561 },  // 1e188
+    { 0x88fcf317f22241e2ULL,   588 },  // 1e196
+    { 0xcc20ce9bd35c78a5ULL,   614 },  // 1e204
+    { 0x98165af37b2153dfULL,   641 },  // 1e212
+    { 0xe2a0b5dc971f303aULL,   667 },  // 1e220
+    { 0xa8d9d1535ce3b396ULL,   694 },  // 1e228
+    { 0xfb9b7cd9a4a7443cULL,   720 },  // 1e236
+    { 0xbb764c4ca7a44410ULL,   747 },  // 1e244
+    { 0x8bab8eefb6409c1aULL,   774 },  // 1e252
+    { 0xd01fef10a657842cULL,   800 },  // 1e260
+    { 0x9b10a4e5e9913129ULL,   827 },  // 1e268
+    { 0xe7109bfba19c0c9dULL,   853 },  // 1e276
+    { 0xac2820d9623bf429ULL,   880 },  // 1e284
+    { 0x80444b5e7aa7cf85ULL,   907 },  // 1e292
+    { 0xbf21e44003acdd2dULL,   933 },  // 1e300
+    { 0x8e679c2f5e44ff8fULL,   960 },  // 1e308
+    { 0xd433179d9c8cb841ULL,   986 },  // 1e316
+    { 0x9e19db92b4e31ba9ULL,  1013 },  // 1e324
+    { 0xeb96bf6ebadf77d9ULL,  1039 },  // 1e332
+    { 0xaf87023b9bf0ee6bULL,  1066 },  // 1e340
+};
+
+static const uint32_t Pow10U32[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static DiyFp diy_mul(DiyFp x, DiyFp y) {
+    unsigned __int128 p = (unsigned __int128)x.f * y.f;
+    uint64_t h = (uint64_t)(p >> 64), l = (uint64_t)p;
+    DiyFp r = { h + (l >> 63), x.e + y.e + 64 };     // arredonda o bit 63
+    return r;
+}
+
+static DiyFp diy_normalize(DiyFp x) {
+    int s = __builtin_clzll(x.f);
+    DiyFp r = { x.f << s, x.e - s };
+    return r;
+}
+
+// Dígitos de w em buf: gera até o intervalo [Mp - delta, Mp] ficar dentro
+// de uma unidade do último dígito e então arredonda em direção a w
+static void grisu_round(char *buf, int len, uint64_t delta, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int digit_gen(DiyFp w, DiyFp mp, uint64_t delta, char *buf, int *K) {
+    DiyFp one = { 1ULL << -mp.e, mp.e };
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+    uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = 1, len = 0;
+    while (kappa < 10 && p1 >= Pow10U32[kappa]) kappa++;
+
+    while (kappa > 0) {
+        uint32_t d = p1 / Pow10U32[kappa - 1];
+        p1 %= Pow10U32[kappa - 1];
+        if (d || len) buf[len++] = (char)('0' + d);
+        kappa--;
+        uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+        if (rest <= delta) {
+            *K += kappa;
+            grisu_round(buf, len, delta, rest,
+                        (uint64_t)Pow10U32[kappa] << -one.e, wp_w);
+            return len;
+        }
+    }
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d || len) buf[len++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            grisu_round(buf, len, delta, p2, one.f,
+                        -kappa < 10 ? wp_w * Pow10U32[-kappa] : 0);
+            return len;
+        }
+    }
+}
+
+// v > 0 finito: dígitos em buf (sem ponto), v ≈ buf · 10^K
+static int grisu2(double v, char *buf, int *K) {
+    uint64_t u;
+    memcpy(&u, &v, sizeof u);
+    const uint64_t hidden = 1ULL << 52;
+    int bexp = (int)((u >> 52) & 0x7FF);
+    DiyFp w = { u & (hidden - 1), -1074 };
+    if (bexp) { w.f += hidden; w.e = bexp - 1075; }
+
+    // fronteiras do intervalo que arredonda para v, no expoente de mp
+    DiyFp mp = { (w.f << 1) + 1, w.e - 1 };
+    mp = diy_normalize(mp);
+    DiyFp mm = w.f == hidden ? (DiyFp){ (w.f << 2) - 1, w.e - 2 }
+                             : (DiyFp){ (w.f << 1) - 1, w.e - 1 };
+    mm.f <<= mm.e - mp.e;
+    mm.e = mp.e;
+
+    // potência 10^-K que deixa o expoente de mp·10^-K em [-60, -32]
+    double dk = (-61 - mp.e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    if (dk - k > 0.0) k++;
+    unsigned idx = (unsigned)((k >> 3) + 1);
+    *K = -(-348 + (int)idx * 8);
+    DiyFp c = CachedPow10[idx];
+
+    DiyFp W  = diy_mul(diy_normalize(w), c);
+    DiyFp Wp = diy_mul(mp, c);
+    DiyFp Wm = diy_mul(mm, c);
+    Wm.f++;
+    Wp.f--;
+    return digit_gen(W, Wp, Wp.f - Wm.f, buf, K);
+}
+
+// O Grisu2 às vezes devolve um dígito a mais (0.11769399999999999 em vez de
+// 0.117694). Quando os dígitos sem o último cabem em m·10^e com m < 2^53 e
+// |e| <= 22, m·10^e (e m+1) é calculado com um único arredondamento, como no
+// strtod, e basta comparar com v para saber se a forma curta volta.
+static int shorten(double a, char *d, int len, int *K) {
+    while (len > 1) {
+        uint64_t m = 0;
+        for (int i = 0; i < len - 1; ++i) m = m * 10 + (uint64_t)(d[i] - '0');
+        int e = *K + 1;
+        if (m + 1 >= 9007199254740992ULL || e < -22 || e > 22) break;
+        int j;
+        for (j = 0; j < 2; ++j) {
+            double x = e < 0 ? (double)(m + j) / Pow10[-e] : (double)(m + j) * Pow10[e];
+            if (x == a) break;
+        }
+        if (j == 2) break;
+        m += (uint64_t)j;
+        while (m % 10 == 0) { m /= 10; e++; }
+        char tmp[20];
+        len = 0;
+        do { tmp[len++] = (char)('0' + m % 10); m /= 10; } while (m);
+        for (int i = 0; i < len; ++i) d[i] = tmp[len - 1 - i];
+        *K = e;
+    }
+    return len;
+}
+
+// Inteiros até 2^53 saem direto; o resto passa pelo Grisu2 e é escrito em
+// notação fixa para expoentes decimais de -5 a 16 e, fora disso, como o %g
+// ("1.5e-07", "1e+20")
+size_t fmt_double(double v, char *buf) {
+    if (isnan(v)) return (size_t)sprintf(buf, "nan");
+    if (isinf(v)) return (size_t)sprintf(buf, v < 0 ? "-inf" : "inf");
+    if (v == 0.0) return (size_t)sprintf(buf, signbit(v) ? "-0" : "0");
+
+    double a = fabs(v);
+    if (a < 9007199254740992.0 && a == (double)(uint64_t)a)
+        return fmt_fixed((uint64_t)a, 0, v < 0, buf);
+
+    char d[24];
+    int K, len = grisu2(a, d, &K);
+    len = shorten(a, d, len, &K);
+    int exp10 = len + K - 1;                  // expoente do primeiro dígito
+    size_t n = 0;
+    if (v < 0) buf[n++] = '-';
+
+    if (exp10 >= -5 && exp10 < 17) {
+        int pt = len + K;                     // dígitos antes do ponto
+        if (pt <= 0) {
+            buf[n++] = '0';
+            buf[n++] = '.';
+            for (int i = pt; i < 0; ++i) buf[n++] = '0';
+            memcpy(buf + n, d, len);
+            n += len;
+        } else if (pt >= len) {
+            memcpy(buf + n, d, len);
+            n += len;
+            for (int i = len; i < pt; ++i) buf[n++] = '0';
+        } else {
+            memcpy(buf + n, d, pt);
+            n += pt;
+            buf[n++] = '.';
+            memcpy(buf + n, d + pt, len - pt);
+            n += len - pt;
+        }
+    } else {
+        buf[n++] = d[0];
+        if (len > 1) {
+            buf[n++] = '.';
+            memcpy(buf + n, d + 1, len - 1);
+            n += len - 1;
+        }
+        buf[n++] = 'e';
+        buf[n++] = exp10 < 0 ? '-' : '+';
+        int e = exp10 < 0 ? -exp10 : exp10;
+        if (e >= 100) buf[n++] = (char)('0' + e / 100);
+        buf[n++] = (char)('0' + e / 10 % 10);
+        buf[n++] = (char)('0' + e % 10);
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+void out_double(OutBuf *o, double v) {
+    char buf[32];
+    out_bytes(o, buf, fmt_double(v, buf));
+}
+
+void out_int(OutBuf *o, int64_t v) {
+    char buf[32];
+    uint64_t m = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    out_bytes(o, buf, fmt_fixed(m, 0, v < 0, buf));
+}
+
+void csv_escape(OutBuf *o, const char *s) {
+    if (!s) return;
+    if (!strpbrk(s, "\",\n")) {
+        out_str(o, s);
+        return;
+    }
+    out_char(o, '"');
+    for (const char *p = s; *p; ++p) {
+        if (*p == '"') out_char(o, '"');
+        out_char(o, *p);
+    }
+    out_char(o, '"');
+}
+
+// Linhas "nome<sep>valor" das células atribuídas, na ordem dos slots
+static void write_cells(OutBuf *o, char sep, int escape, const CellLayout *grid,
+                        const double *num, const char *const *text,
+                        const int64_t *ival, const unsigned char *kind,
+                        const unsigned char *assigned) {
+    int64_t n = layout_ncells(grid);
+    for (int64_t slot = 0; slot < n; ++slot) {
+        if (!assigned[slot]) continue;
+        char name[32];
+        layout_name(grid, slot, name, sizeof name);
+        out_str(o, name);
+        out_char(o, sep);
+        if (kind[slot] == V_INT)        out_int(o, ival[slot]);
+        else if (kind[slot] == V_FLOAT) out_double(o, num[slot]);
+        else if (escape)                csv_escape(o, text[slot]);
+        else if (text[slot])            out_str(o, text[slot]);
+        out_char(o, '\n');
+    }
+}
+
+static __thread FILE *TableOut = NULL;
+
+void lc_set_table_output(FILE *f) {
+    TableOut = f;
+}
+
+void lc_table(const CellLayout *grid, const double *num,
+              const char *const *text, const int64_t *ival,
+              const unsigned char *kind, const unsigned char *assigned) {
+    OutBuf o;
+    out_open(&o, TableOut ? TableOut : stdout);
+    write_cells(&o, '\t', 0, grid, num, text, ival, kind, assigned);
+    out_close(&o);
+}
+
+int lc_export(const char *filename, const CellLayout *grid, const double *num,
+              const char *const *text, const int64_t *ival,
+              const unsigned char *kind, const unsigned char *assigned) {
+    FILE *f = fopen(filename, "w");
+    if (!f) {
+        perror(filename);
+        return 1;
+    }
+    OutBuf o;
+    out_open(&o, f);
+    write_cells(&o, ',', 1, grid, num, text, ival, kind, assigned);
+    int err = out_close(&o);
+    if (fclose(f) != 0) err = 1;
+    if (err) perror(filename);
+    return err;
+}
@@ -0,0 +1,46 @@
+// csv.h
+// Saída de TABLE/EXPORT (csv.c), comum ao JIT (lc_table/lc_export) e aos
+// engines interpretados (store_table/store_export): buffer grande em
+// memória, números no formato mais curto que volta ao mesmo double e
+// textos escapados por csv_escape.
+#ifndef LANGCELL_CSV_H
+#define LANGCELL_CSV_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    FILE   *f;
+    char   *buf;
+    size_t  len;
+    int     err;       // alguma escrita falhou
+} OutBuf;
+
+void out_open(OutBuf *o, FILE *f);
+// Esvazia o buffer em o->f; retorna 0, ou 1 se alguma escrita falhou
+int  out_close(OutBuf *o);
+
+void out_bytes(OutBuf *o, const char *s, size_t n);
+void out_str(OutBuf *o, const char *s);
+void out_char(OutBuf *o, char c);
+void out_double(OutBuf *o, double v);
+void out_int(OutBuf *o, int64_t v);
+
+// Texto como campo CSV: com vírgula, aspas ou quebra de linha, vai entre
+// aspas e com as aspas internas duplicadas
+void csv_escape(OutBuf *o, const char *s);
+
+// Representação decimal curta de v que o strtod lê de volta como v (a menor
+// possível, salvo raros casos com expoente fora de ±22); buf com pelo menos
+// 32 bytes. Retorna o tamanho escrito
+size_t fmt_double(double v, char *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_CSV_H
@@ -6,121 +6,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include "ast.h"
+#include "cells.h"
+#include "runtime.h"
+#include "sema.h"
+#include "store.h"
+#include "interp.h"
 
-// sum_helper, avg_helper, min_helper, max_helper
-double sum_helper(int n, double *vals) {
-  double acc = 0.0;
-  for (int i = 0; i < n; ++i) acc += vals[i];
-  return acc;
-}
-
-double avg_helper(int n, double *vals) {
-  double acc = sum_helper(n, vals);
-  return n>0 ? acc / n : 0.0;
-}
-
-double min_helper(int n, double *vals) {
-  if (n<=0) return 0.0;
-  double m = vals[0];
-  for (int i = 1; i < n; ++i) if (vals[i] < m) m = vals[i];
-  return m;
-}
+// Células do programa: ValueStore indexado pelo slot que a sema resolveu
+static ValueStore store;
 
-double max_helper(int n, double *vals) {
-  if (n<=0) return 0.0;
-  double m = vals[0];
-  for (int i = 1; i < n; ++i) if (vals[i] > m) m = vals[i];
-  return m;
-}
-
-
-// export_csv
-void export_csv(const char *filename,
-                int n_cells, const char **names, double *values) {
-  FILE *f = fopen(filename, "w");
-  for (int i = 0; i < n_cells; ++i)
-    fprintf(f, "%s,%g\n", names[i], values[i]);
-  fclose(f);
-}
+// Argumentos de uma chamada de agregação que cabem na pilha
+#define CALL_STACK_ARGS 8
 
-
-// Se string contém vírgula, aspas ou newline, envolve em "..." e duplica as aspas internas
-static char *csv_escape(const char *s) {
-  int need = 0;
-  for (const char *p = s; *p; ++p) {
-      if (*p == '"' || *p == ',' || *p == '\n') need++;
-  }
-  // sem escapes, retorna copia direta
-  if (need == 0) return strdup(s);
-
-  size_t len = strlen(s) + need + 2 + 1;
-  char *out = malloc(len);
-  char *o = out;
-  *o++ = '"';
-  for (const char *p = s; *p; ++p) {
-      if (*p == '"') {
-          *o++ = '"';
-          *o++ = '"';
-      } else {
-          *o++ = *p;
-      }
-  }
-  *o++ = '"';
-  *o   = '\0';
-  return out;
-}
-
-
-// Tipo genérico de valor
-typedef enum { V_INT, V_FLOAT, V_TEXT } ValueKind;
-typedef struct {
-    ValueKind kind;
-    union {
-        int    ival;
-        double fval;
-        char  *sval;
-    };
-} Value;
-
-// Estrutura para o mapa de células
-typedef struct Cell {
-    char *name;
-    Value val;
-    struct Cell *next;
-} Cell;
-
-static Cell *cell_map = NULL;
-
-// Insere ou atualiza valor de célula, mantendo ordem de inserção
-static void map_set(const char *name, Value v) {
-    for (Cell *c = cell_map; c; c = c->next) {
-        if (strcmp(c->name, name) == 0) {
-            c->val = v;
-            return;
-        }
-    }
-    // inserir no final da lista para preservar ordem
-    Cell *n = malloc(sizeof *n);
-    n->name = strdup(name);
-    n->val  = v;
-    n->next = NULL;
-    if (!cell_map) {
-        cell_map = n;
-    } else {
-        Cell *it = cell_map;
-        while (it->next) it = it->next;
-        it->next = n;
-    }
-}
-
-// Recupera valor de célula (0 se não existir)
-static Value map_get(const char *name) {
-    for (Cell *c = cell_map; c; c = c->next) {
-        if (strcmp(c->name, name) == 0)
-            return c->val;
-    }
-    return (Value){.kind = V_INT, .ival = 0};
-}
+// Modo streaming (interp_stream_begin): statement a statement, sem a
+// inferência de células inteiras do programa inteiro
+static int Streaming = 0;
 
 // Avalia uma expressão e retorna um Value
 static Value eval_expr(Expr *e) {
@@ -131,15 +31,19 @@ static Value eval_expr(Expr *e) {
         return (Value){.kind=V_FLOAT, .fval=e->fval};
       case EXPR_TEXT:
         return (Value){.kind=V_TEXT,  .sval=e->sval};
-      case EXPR_CELL:
-        return map_get(e->sval);
+      case EXPR_CELL: {
+        Value v = store_get(&store, e->slot);
+        return e->type == TYPE_INT || Streaming ? v : value_float(v);
+      }
       case EXPR_UNARY: {
         Value sub = eval_expr(e->un.sub);
         if (e->un.op == OP_NEG) {
             if (sub.kind == V_FLOAT) sub.fval = -sub.fval;
+            else if (sub.kind == V_INT && sub.ival == INT64_MIN)
+                sub = (Value){.kind=V_FLOAT, .fval = -(double)sub.ival};
             else                      sub.ival = -sub.ival;
         } else { // OP_NOT
-            int cond = (sub.kind == V_FLOAT ? (int)sub.fval : sub.ival);
+            int cond = value_truth(sub);
             sub.kind = V_INT;
             sub.ival = !cond;
         }
@@ -148,6 +52,28 @@ static Value eval_expr(Expr *e) {
       case EXPR_BINARY: {
         Value L = eval_expr(e->bin.left);
         Value R = eval_expr(e->bin.right);
+        // +, - e * entre inteiros ficam inteiros enquanto o resultado cabe
+        // em 64 bits; se estoura, a conta é feita em double logo abaixo (como
+        // no JIT). Comparações entre inteiros também são exatas; a divisão é
+        // sempre em double
+        if (L.kind == V_INT && R.kind == V_INT) {
+            int64_t v;
+            int     ovf = 1;
+            int64_t l = L.ival, r = R.ival;
+            switch (e->bin.op) {
+              case OP_ADD: ovf = __builtin_add_overflow(l, r, &v); break;
+              case OP_SUB: ovf = __builtin_sub_overflow(l, r, &v); break;
+              case OP_MUL: ovf = __builtin_mul_overflow(l, r, &v); break;
+              case OP_GT:  return (Value){.kind=V_INT, .ival = l > r};
+              case OP_LT:  return (Value){.kind=V_INT, .ival = l < r};
+              case OP_GE:  return (Value){.kind=V_INT, .ival = l >= r};
+              case OP_LE:  return (Value){.kind=V_INT, .ival = l <= r};
+              case OP_EQ:  return (Value){.kind=V_INT, .ival = l == r};
+              case OP_NE:  return (Value){.kind=V_INT, .ival = l != r};
+              default:     break;
+            }
+            if (!ovf) return (Value){.kind=V_INT, .ival=v};
+        }
         double l = (L.kind == V_FLOAT ? L.fval : L.ival);
         double r = (R.kind == V_FLOAT ? R.fval : R.ival);
         switch (e->bin.op) {
@@ -168,67 +94,57 @@ static Value eval_expr(Expr *e) {
       }
       case EXPR_CALL: {
         const char *fn = e->call.fname;
-        double *vals = NULL;
-        size_t  n    = 0;
-
-        // Expande args: ranges e expressões
-        for (Expr *arg = e->call.args; arg; arg = arg->next) {
-            if (arg->kind == EXPR_RANGE) {
-                char sc = arg->range.start_cell[0];
-                char ec = arg->range.end_cell[0];
-                int  sr = atoi(arg->range.start_cell + 1);
-                int  er = atoi(arg->range.end_cell   + 1);
-                for (char c = sc; c <= ec; ++c) {
-                    for (int r = sr; r <= er; ++r) {
-                        char cell[16];
-                        snprintf(cell, sizeof cell, "%c%d", c, r);
-                        Value v = map_get(cell);
-                        double x = (v.kind == V_FLOAT ? v.fval : v.ival);
-                        vals = realloc(vals, (n+1)*sizeof *vals);
-                        vals[n++] = x;
-                    }
-                }
-            } else {
-                Value v = eval_expr(arg);
-                double x = (v.kind == V_FLOAT ? v.fval : v.ival);
-                vals = realloc(vals, (n+1)*sizeof *vals);
-                vals[n++] = x;
-            }
-        }
+        int64_t nargs  = 0;
+        for (Expr *arg = e->call.args; arg; arg = arg->next) nargs++;
 
-        if (n == 0) {
+        if (nargs == 0) {
             fprintf(stderr, "Erro: chamada %s sem argumentos\n", fn);
             return (Value){.kind=V_INT, .ival = 0};
         }
 
-        if (strcmp(fn, "SUM") == 0) {
-            double acc = 0;
-            for (size_t i = 0; i < n; ++i) acc += vals[i];
-            free(vals);
-            return (Value){.kind=V_FLOAT, .fval = acc};
+        // mesmos kernels usados pelo JIT, via agg_helper
+        int agg = e->call.fn;
+        if (agg < 0) {
+            fprintf(stderr, "Erro: função desconhecida %s\n", fn);
+            return (Value){.kind=V_INT, .ival = 0};
         }
-        if (strcmp(fn, "AVERAGE") == 0) {
-            double acc = 0;
-            for (size_t i = 0; i < n; ++i) acc += vals[i];
-            free(vals);
-            return (Value){.kind=V_FLOAT, .fval = acc / n};
+
+        // range indexado: a árvore responde sem percorrer as células
+        Expr *first = e->call.args;
+        if (nargs == 1 && first->kind == EXPR_RANGE && first->range.index)
+            return (Value){.kind=V_FLOAT,
+                           .fval = rindex_query(first->range.index, agg, store.num)};
+
+        // Um AggArg por argumento, como no JIT: ranges apontam direto para
+        // a coluna num do store, expressões vão para scalars[]. Até
+        // CALL_STACK_ARGS argumentos ficam na pilha; só chamadas maiores
+        // alocam (chamadas aninhadas têm cada uma o seu buffer)
+        AggArg  args_buf[CALL_STACK_ARGS];
+        double  scalars_buf[CALL_STACK_ARGS];
+        AggArg *args    = args_buf;
+        double *scalars = scalars_buf;
+        if (nargs > CALL_STACK_ARGS) {
+            args    = malloc(nargs * sizeof *args);
+            scalars = malloc(nargs * sizeof *scalars);
+            if (!args || !scalars) exit(1);
         }
-        if (strcmp(fn, "MIN") == 0) {
-            double m = vals[0];
-            for (size_t i = 1; i < n; ++i) if (vals[i] < m) m = vals[i];
-            free(vals);
-            return (Value){.kind=V_FLOAT, .fval = m};
+        int64_t i = 0;
+        for (Expr *arg = e->call.args; arg; arg = arg->next, ++i) {
+            if (arg->kind == EXPR_RANGE) {
+                args[i] = (AggArg){ store.num + arg->range.slot,
+                                    arg->range.rows, arg->range.cols,
+                                    store.layout->nrows };
+            } else {
+                scalars[i] = value_num(eval_expr(arg));
+                args[i] = (AggArg){ &scalars[i], 1, 1, 1 };
+            }
         }
-        if (strcmp(fn, "MAX") == 0) {
-            double m = vals[0];
-            for (size_t i = 1; i < n; ++i) if (vals[i] > m) m = vals[i];
-            free(vals);
-            return (Value){.kind=V_FLOAT, .fval = m};
+        double r = agg_helper(agg, nargs, args);
+        if (args != args_buf) {
+            free(args);
+            free(scalars);
         }
-
-        fprintf(stderr, "Erro: função desconhecida %s\n", fn);
-        free(vals);
-        return (Value){.kind=V_INT, .ival = 0};
+        return (Value){.kind=V_FLOAT, .fval = r};
       }
       case EXPR_RANGE:
         // isolado, retorna 0
@@ -238,65 +154,362 @@ static Value eval_expr(Expr *e) {
     return (Value){.kind=V_INT, .ival = 0};
 }
 
+// ——— tiering: WHILE quente → código nativo ————————————————————————————————
+
+static int64_t      TierThreshold = 0;
+static TierCompiler TierCompile   = NULL;
+
+void interp_set_tiering(int64_t threshold, TierCompiler compile) {
+    TierThreshold = threshold > 0 ? threshold : 1;
+    TierCompile   = compile;
+}
+
+// Estado de um WHILE no tier nativo (Stmt.whiles.tier)
+typedef struct {
+    TierLoopFn     fn;        // NULL: laço inelegível, fica no interpretador
+    int64_t       *reads;     // slots lidos como célula (EXPR_CELL)
+    int64_t        n_reads;
+    int64_t       *writes;    // slots atribuídos, na ordem em que aparecem
+    int64_t        n_writes;
+    int64_t       *fresh;     // writes ainda não atribuídos antes da chamada
+} TierLoop;
+
+static void slot_list_add(int64_t **v, int64_t *n, int64_t slot) {
+    for (int64_t i = 0; i < *n; ++i)
+        if ((*v)[i] == slot) return;
+    *v = realloc(*v, (*n + 1) * sizeof **v);
+    if (!*v) exit(1);
+    (*v)[(*n)++] = slot;
+}
+
+// O código nativo só trabalha com a coluna num: textos, TABLE, EXPORT,
+// IMPORT, SAVE e LOAD dentro do laço o deixam no interpretador
+static int tier_expr_ok(TierLoop *t, Expr *e) {
+    switch (e->kind) {
+      case EXPR_TEXT:
+        return 0;
+      case EXPR_CELL:
+        slot_list_add(&t->reads, &t->n_reads, e->slot);
+        return 1;
+      case EXPR_UNARY:
+        return tier_expr_ok(t, e->un.sub);
+      case EXPR_BINARY:
+        return tier_expr_ok(t, e->bin.left) && tier_expr_ok(t, e->bin.right);
+      case EXPR_CALL:
+        for (Expr *arg = e->call.args; arg; arg = arg->next)
+            if (!tier_expr_ok(t, arg)) return 0;
+        return 1;
+      default:
+        return 1;
+    }
+}
+
+static int tier_stmts_ok(TierLoop *t, Stmt *s) {
+    for (; s; s = s->next) {
+        switch (s->kind) {
+          case STMT_ASSIGN:
+            if (!tier_expr_ok(t, s->assign.expr)) return 0;
+            slot_list_add(&t->writes, &t->n_writes, s->assign.slot);
+            break;
+          case STMT_IF:
+            if (!tier_expr_ok(t, s->ifs.cond) ||
+                !tier_stmts_ok(t, s->ifs.then_branch)) return 0;
+            break;
+          case STMT_WHILE:
+            if (!tier_expr_ok(t, s->whiles.cond) ||
+                !tier_stmts_ok(t, s->whiles.body)) return 0;
+            break;
+          default:
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Roda o laço no tier nativo. Retorna 0 se alguma célula lida contém texto
+// (o laço continua interpretado).
+static int tier_run(TierLoop *t) {
+    for (int64_t i = 0; i < t->n_reads; ++i)
+        if (store.kind[t->reads[i]] == V_TEXT) return 0;
+
+    int64_t n_fresh = 0;
+    for (int64_t i = 0; i < t->n_writes; ++i)
+        if (!store.assigned[t->writes[i]]) t->fresh[n_fresh++] = t->writes[i];
+
+    t->fn(store.num, store.ival, store.kind, store.assigned);
+    store_rindex_invalidate(&store);   // o laço nativo escreveu direto em num[]
+
+    // o código nativo só marca assigned; a ordem de inserção de TABLE/EXPORT
+    // segue a ordem das atribuições no corpo do laço
+    for (int64_t i = 0; i < n_fresh; ++i)
+        if (store.assigned[t->fresh[i]])
+            store.order[store.n_order++] = t->fresh[i];
+    return 1;
+}
+
+// Chamado quando o WHILE atinge TierThreshold back-edges
+static int tier_enter(Stmt *s) {
+    TierLoop *t = s->whiles.tier;
+    if (!t) {
+        t = calloc(1, sizeof *t);
+        if (!t) exit(1);
+        s->whiles.tier = t;
+        Stmt *next = s->next;
+        s->next = NULL;
+        if (tier_stmts_ok(t, s)) {
+            t->fresh = malloc((t->n_writes ? t->n_writes : 1) * sizeof *t->fresh);
+            if (!t->fresh) exit(1);
+            t->fn = TierCompile(s);
+        }
+        s->next = next;
+    }
+    if (!t->fn) return 0;
+    if (tier_run(t)) return 1;
+    s->whiles.backedges = 0;    // tenta de novo mais tarde
+    return 0;
+}
+
+// Reexecução pelo recálculo: células fixadas e saída suprimida
+static const unsigned char *Pinned = NULL;
+
 // Executa uma lista de statements
 static int interpret_stmt(Stmt *s) {
     while (s) {
         switch (s->kind) {
           case STMT_ASSIGN: {
+            if (Pinned && Pinned[s->assign.slot]) {
+                store_touch(&store, s->assign.slot);
+                break;
+            }
             Value v = eval_expr(s->assign.expr);
-            map_set(s->assign.cell, v);
+            // sem o programa inteiro o streaming não tem tipos de célula:
+            // nele o valor fica com o tipo dinâmico
+            if (s->assign.type != TYPE_INT && !Streaming) v = value_float(v);
+            store_set(&store, s->assign.slot, v);
             break;
           }
           case STMT_IF: {
             Value c = eval_expr(s->ifs.cond);
-            int cond = (c.kind == V_FLOAT ? (int)c.fval : c.ival);
-            if (cond) interpret_stmt(s->ifs.then_branch);
+            if (value_truth(c)) interpret_stmt(s->ifs.then_branch);
             break;
           }
           case STMT_WHILE: {
-            Value c = eval_expr(s->whiles.cond);
-            int cond = (c.kind == V_FLOAT ? (int)c.fval : c.ival);
-            while (cond) {
+            // laço já compilado: entra direto no tier nativo
+            // (o código nativo não conhece células fixadas: fica desligado
+            // durante interp_rerun)
+            TierLoop *t = s->whiles.tier;
+            if (!Pinned && t && t->fn && tier_run(t)) break;
+            while (value_truth(eval_expr(s->whiles.cond))) {
                 interpret_stmt(s->whiles.body);
-                c = eval_expr(s->whiles.cond);
-                cond = (c.kind == V_FLOAT ? (int)c.fval : c.ival);
+                if (TierCompile && !Pinned && ++s->whiles.backedges == TierThreshold &&
+                    tier_enter(s))
+                    break;
             }
             break;
           }
-          case STMT_TABLE: {
-            for (Cell *c = cell_map; c; c = c->next) {
-                if (c->val.kind == V_FLOAT)
-                    printf("%s\t%g\n", c->name, c->val.fval);
-                else if (c->val.kind == V_INT)
-                    printf("%s\t%d\n", c->name, c->val.ival);
-                else
-                    printf("%s\t%s\n", c->name, c->val.sval);
-            }
+          case STMT_TABLE:
+            if (!Pinned) store_table(&store);
             break;
-          }
-          case STMT_EXPORT: {
-            FILE *f = fopen(s->exp.filename, "w");
-            if (!f) { perror("fopen"); return 1; }
-            for (Cell *c = cell_map; c; c = c->next) {
-              if (c->val.kind == V_FLOAT) {
-                fprintf(f, "%s,%g\n", c->name, c->val.fval);
-              } else if (c->val.kind == V_INT) {
-                fprintf(f, "%s,%d\n", c->name, c->val.ival);
-              } else {
-                char *esc = csv_escape(c->val.sval);
-                fprintf(f, "%s,%s\n", c->name, esc);
-                free(esc);
-              }
-            }
-            fclose(f);
+          case STMT_EXPORT:
+            if (!Pinned && store_export(&store, s->exp.filename)) return 1;
+            break;
+          case STMT_IMPORT:
+            if (store_import(&store, s->imp.filename, s->imp.col, s->imp.row,
+                             Pinned))
+                return 1;
+            break;
+          case STMT_SAVE:
+            if (!Pinned && store_save(&store, s->exp.filename)) return 1;
+            break;
+          case STMT_LOAD:
+            if (store_load(&store, s->exp.filename, Pinned)) return 1;
             break;
-          }
         }
         s = s->next;
     }
     return 0;
 }
 
+// Ranges marcados pela sema (Expr.range.indexed) ganham um RangeIndex,
+// que o store mantém a cada escrita
+static void attach_index_expr(Expr *e) {
+    switch (e->kind) {
+      case EXPR_UNARY:
+        attach_index_expr(e->un.sub);
+        break;
+      case EXPR_BINARY:
+        attach_index_expr(e->bin.left);
+        attach_index_expr(e->bin.right);
+        break;
+      case EXPR_CALL:
+        for (Expr *arg = e->call.args; arg; arg = arg->next) {
+            if (arg->kind == EXPR_RANGE && arg->range.indexed) {
+                arg->range.index = rindex_new(arg->range.slot, arg->range.rows,
+                                              arg->range.cols, store.layout->nrows);
+                store_add_rindex(&store, arg->range.index);
+            } else {
+                attach_index_expr(arg);
+            }
+        }
+        break;
+      default:
+        break;
+    }
+}
+
+static void attach_indexes(Stmt *s) {
+    for (; s; s = s->next) {
+        switch (s->kind) {
+          case STMT_ASSIGN:
+            attach_index_expr(s->assign.expr);
+            break;
+          case STMT_IF:
+            attach_index_expr(s->ifs.cond);
+            attach_indexes(s->ifs.then_branch);
+            break;
+          case STMT_WHILE:
+            attach_index_expr(s->whiles.cond);
+            attach_indexes(s->whiles.body);
+            break;
+          default:
+            break;
+        }
+    }
+}
+
+// Requer analyze_program(program) antes: usa os slots e o layout da sema
 int interpret(Stmt *program) {
+    store_init(&store, sema_layout());
+    attach_indexes(program);
     return interpret_stmt(program);
 }
+
+// ——— modo streaming ——————————————————————————————————————————————————————
+// Dois layouts alternados: store_relayout lê o antigo enquanto copia
+static CellLayout StreamLayout[2];
+static int        CurLayout = 0;
+
+void interp_stream_begin(void) {
+    layout_init(&StreamLayout[0]);
+    CurLayout = 0;
+    store_init(&store, &StreamLayout[0]);
+    // a AST de cada statement é liberada: o store copia os textos
+    store.own_text = 1;
+    Streaming = 1;
+}
+
+// Extensões de IMPORT/LOAD, em qualquer nível do statement
+static void add_io_extents(CellLayout *L, Stmt *s) {
+    for (; s; s = s->next) {
+        int64_t col, row;
+        if (s->kind == STMT_IMPORT && cell_parse(s->imp.cell, &col, &row) == 0)
+            store_import_extent(s->imp.filename, col, row, L);
+        else if (s->kind == STMT_LOAD)
+            store_load_extent(s->exp.filename, L);
+        else if (s->kind == STMT_IF)
+            add_io_extents(L, s->ifs.then_branch);
+        else if (s->kind == STMT_WHILE)
+            add_io_extents(L, s->whiles.body);
+    }
+}
+
+// Novo layout que cobre 'need': cada lado que cresce avança pelo menos o
+// tamanho atual, então um script que desce linha a linha refaz o grid
+// O(log n) vezes. Retorna 0 se 'need' já cabe em 'cur'.
+static int stream_grow(const CellLayout *cur, const CellLayout *need,
+                       CellLayout *out) {
+    if (cur->ncols == 0) {
+        *out = *need;
+        return need->ncols != 0;
+    }
+    int64_t c0 = cur->col0, c1 = cur->col0 + cur->ncols;   // [c0, c1)
+    int64_t r0 = cur->row0, r1 = cur->row0 + cur->nrows;
+    int64_t nc0 = need->col0, nc1 = need->col0 + need->ncols;
+    int64_t nr0 = need->row0, nr1 = need->row0 + need->nrows;
+    if (nc0 >= c0 && nc1 <= c1 && nr0 >= r0 && nr1 <= r1) return 0;
+
+    if (nc0 < c0) { c0 = nc0 < c0 - cur->ncols ? nc0 : c0 - cur->ncols; if (c0 < 0) c0 = 0; }
+    if (nc1 > c1) c1 = nc1 > c1 + cur->ncols ? nc1 : c1 + cur->ncols;
+    if (nr0 < r0) { r0 = nr0 < r0 - cur->nrows ? nr0 : r0 - cur->nrows; if (r0 < 0) r0 = 0; }
+    if (nr1 > r1) r1 = nr1 > r1 + cur->nrows ? nr1 : r1 + cur->nrows;
+    out->col0  = c0;
+    out->row0  = r0;
+    out->ncols = c1 - c0;
+    out->nrows = r1 - r0;
+    return 1;
+}
+
+int interp_stream_stmt(Stmt *s) {
+    // células do statement (e dos arquivos de IMPORT/LOAD) no grid
+    CellLayout *cur  = &StreamLayout[CurLayout];
+    CellLayout *next = &StreamLayout[1 - CurLayout];
+    CellLayout  io, need;
+    layout_init(&io);
+    add_io_extents(&io, s);
+    layout_free(next);
+    int grow = 0;
+    if (!cur->colspan) {
+        need = *cur;
+        layout_add_program(&need, s);
+        if (io.ncols) {
+            layout_add(&need, io.col0, io.row0);
+            layout_add(&need, layout_col_end(&io) - 1, layout_row_end(&io) - 1);
+        }
+        grow = stream_grow(cur, &need, next);
+    }
+    // um retângulo grande demais (script esparso) vira um grid compactado,
+    // que depois cresce só com as faixas novas
+    int64_t n = grow ? layout_ncells(next) : 0;
+    if (cur->colspan || n < 0 || n > LAYOUT_DENSE_MAX) {
+        if (layout_cover(next, cur, s, &io) < 0) {
+            fprintf(stderr, "Erro semântico: grid grande demais\n");
+            layout_free(&io);
+            return 1;
+        }
+        grow = !next->colspan != !cur->colspan ||
+               next->ncols != cur->ncols || next->nrows != cur->nrows ||
+               next->col0 != cur->col0 || next->row0 != cur->row0;
+    }
+    layout_free(&io);
+    if (grow) {
+        store_relayout(&store, next);
+        CurLayout = 1 - CurLayout;
+    }
+
+    sema_set_layout(store.layout);
+    if (analyze_stmt_list(s) > 0) return 1;
+    return interpret_stmt(s);
+}
+
+ValueStore *interp_store(void) {
+    return &store;
+}
+
+Value interp_eval(Expr *e) {
+    return eval_expr(e);
+}
+
+int interp_rerun(Stmt *program, const unsigned char *pinned) {
+    int64_t n = layout_ncells(store.layout);
+    int64_t npin = 0;
+    for (int64_t i = 0; i < n; ++i) npin += pinned[i] != 0;
+
+    // guarda os valores fixados, limpa o resto do store
+    int64_t *pslot = malloc((npin ? npin : 1) * sizeof *pslot);
+    Value   *pval  = malloc((npin ? npin : 1) * sizeof *pval);
+    if (!pslot || !pval) exit(1);
+    for (int64_t i = 0, k = 0; i < n; ++i)
+        if (pinned[i]) { pslot[k] = i; pval[k] = store_get(&store, i); ++k; }
+    store_clear(&store);
+    for (int64_t k = 0; k < npin; ++k) store_put(&store, pslot[k], pval[k]);
+
+    Pinned = pinned;
+    int rc = interpret_stmt(program);
+    Pinned = NULL;
+
+    // entradas que o programa nunca atribui vão para o fim da TABLE
+    for (int64_t k = 0; k < npin; ++k) store_touch(&store, pslot[k]);
+    free(pslot);
+    free(pval);
+    return rc;
+}
@@ -3,6 +3,7 @@
 #define LANGCELL_INTERP_H
 
 #include "ast.h"
+#include "store.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,6 +11,32 @@ extern "C" {
 
 int interpret(Stmt *program);
 
+// Modo tiered: o programa começa interpretado e cada WHILE conta seus
+// back-edges. Ao atingir 'threshold', compile(loop) devolve código nativo
+// que executa o WHILE inteiro (a partir do teste da condição) direto sobre
+// as colunas do ValueStore (num, ival, kind, assigned); NULL mantém o laço
+// no interpretador.
+typedef void (*TierLoopFn)(double *num, int64_t *ival, unsigned char *kind,
+                           unsigned char *assigned);
+typedef TierLoopFn (*TierCompiler)(Stmt *loop);
+
+void interp_set_tiering(int64_t threshold, TierCompiler compile);
+
+// Modo streaming (--stream): o programa não existe inteiro na memória. Cada
+// statement de topo é analisado e executado por interp_stream_stmt assim
+// que o parser o reduz, e sua AST pode ser liberada logo depois. O grid
+// começa vazio e cresce (com folga) quando aparecem células novas. Retorna
+// 0, ou 1 em erro semântico ou de E/S.
+void interp_stream_begin(void);
+int  interp_stream_stmt(Stmt *s);
+
+// Estado do interpretador para o recálculo incremental (recalc.c)
+ValueStore *interp_store(void);
+Value       interp_eval(Expr *e);
+// Reexecuta o programa do zero, sem TABLE/EXPORT. Slots com pinned[slot]
+// mantêm o valor atual do store: as atribuições a eles só registram a ordem.
+int         interp_rerun(Stmt *program, const unsigned char *pinned);
+
 #ifdef __cplusplus
 }
 #endif
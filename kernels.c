@@ -0,0 +1,239 @@
+// kernels.c
+// Kernels vetorizados de SUM/MIN/MAX. Cada variante usa 4 acumuladores
+// independentes para esconder a latência das somas/comparações e trata o
+// resto (n não múltiplo da largura) com um laço escalar no final.
+// As variantes AVX2/AVX-512 são compiladas com __attribute__((target)), de
+// forma que o binário continua rodando em qualquer x86-64; a escolha é feita
+// em runtime com __builtin_cpu_supports.
+
+#include <pthread.h>
+#include <stddef.h>
+#include "kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LC_X86 1
+#include <immintrin.h>
+#endif
+
+// ——— escalar (referência) ————————————————————————————————————————————————
+
+static double sum_scalar(const double *v, int64_t n) {
+    double acc = 0.0;
+    for (int64_t i = 0; i < n; ++i) acc += v[i];
+    return acc;
+}
+
+static double min_scalar(const double *v, int64_t n) {
+    double m = v[0];
+    for (int64_t i = 1; i < n; ++i) if (v[i] < m) m = v[i];
+    return m;
+}
+
+static double max_scalar(const double *v, int64_t n) {
+    double m = v[0];
+    for (int64_t i = 1; i < n; ++i) if (v[i] > m) m = v[i];
+    return m;
+}
+
+#ifdef LC_X86
+
+// ——— SSE2: 4 x 2 doubles por iteração ————————————————————————————————————
+
+static double sum_sse2(const double *v, int64_t n) {
+    __m128d a0 = _mm_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        a0 = _mm_add_pd(a0, _mm_loadu_pd(v + i));
+        a1 = _mm_add_pd(a1, _mm_loadu_pd(v + i + 2));
+        a2 = _mm_add_pd(a2, _mm_loadu_pd(v + i + 4));
+        a3 = _mm_add_pd(a3, _mm_loadu_pd(v + i + 6));
+    }
+    __m128d s = _mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3));
+    double acc = _mm_cvtsd_f64(s) + _mm_cvtsd_f64(_mm_unpackhi_pd(s, s));
+    for (; i < n; ++i) acc += v[i];
+    return acc;
+}
+
+#define SSE2_MINMAX(NAME, OP, CMP)                                          \
+static double NAME(const double *v, int64_t n) {                            \
+    if (n < 8) return CMP(v, n);                                            \
+    __m128d a0 = _mm_loadu_pd(v),     a1 = _mm_loadu_pd(v + 2);             \
+    __m128d a2 = _mm_loadu_pd(v + 4), a3 = _mm_loadu_pd(v + 6);             \
+    int64_t i = 8;                                                          \
+    for (; i + 8 <= n; i += 8) {                                            \
+        a0 = OP(a0, _mm_loadu_pd(v + i));                                   \
+        a1 = OP(a1, _mm_loadu_pd(v + i + 2));                               \
+        a2 = OP(a2, _mm_loadu_pd(v + i + 4));                               \
+        a3 = OP(a3, _mm_loadu_pd(v + i + 6));                               \
+    }                                                                       \
+    __m128d m = OP(OP(a0, a1), OP(a2, a3));                                 \
+    double lanes[2];                                                        \
+    _mm_storeu_pd(lanes, m);                                                \
+    double r = CMP(lanes, 2);                                               \
+    if (i < n) {                                                            \
+        double t = CMP(v + i, n - i);                                       \
+        lanes[0] = r; lanes[1] = t;                                         \
+        r = CMP(lanes, 2);                                                  \
+    }                                                                       \
+    return r;                                                               \
+}
+
+SSE2_MINMAX(min_sse2, _mm_min_pd, min_scalar)
+SSE2_MINMAX(max_sse2, _mm_max_pd, max_scalar)
+
+// ——— AVX2: 4 x 4 doubles por iteração ————————————————————————————————————
+
+__attribute__((target("avx2")))
+static double hsum256(__m256d x) {
+    __m128d lo = _mm256_castpd256_pd128(x);
+    __m128d hi = _mm256_extractf128_pd(x, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(lo) + _mm_cvtsd_f64(_mm_unpackhi_pd(lo, lo));
+}
+
+__attribute__((target("avx2")))
+static double sum_avx2(const double *v, int64_t n) {
+    __m256d a0 = _mm256_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_add_pd(a0, _mm256_loadu_pd(v + i));
+        a1 = _mm256_add_pd(a1, _mm256_loadu_pd(v + i + 4));
+        a2 = _mm256_add_pd(a2, _mm256_loadu_pd(v + i + 8));
+        a3 = _mm256_add_pd(a3, _mm256_loadu_pd(v + i + 12));
+    }
+    double acc = hsum256(_mm256_add_pd(_mm256_add_pd(a0, a1),
+                                       _mm256_add_pd(a2, a3)));
+    for (; i < n; ++i) acc += v[i];
+    return acc;
+}
+
+#define AVX2_MINMAX(NAME, OP, CMP)                                          \
+__attribute__((target("avx2")))                                             \
+static double NAME(const double *v, int64_t n) {                            \
+    if (n < 16) return CMP(v, n);                                           \
+    __m256d a0 = _mm256_loadu_pd(v),     a1 = _mm256_loadu_pd(v + 4);       \
+    __m256d a2 = _mm256_loadu_pd(v + 8), a3 = _mm256_loadu_pd(v + 12);      \
+    int64_t i = 16;                                                         \
+    for (; i + 16 <= n; i += 16) {                                          \
+        a0 = OP(a0, _mm256_loadu_pd(v + i));                                \
+        a1 = OP(a1, _mm256_loadu_pd(v + i + 4));                            \
+        a2 = OP(a2, _mm256_loadu_pd(v + i + 8));                            \
+        a3 = OP(a3, _mm256_loadu_pd(v + i + 12));                           \
+    }                                                                       \
+    double lanes[5];                                                        \
+    _mm256_storeu_pd(lanes, OP(OP(a0, a1), OP(a2, a3)));                    \
+    int k = 4;                                                              \
+    if (i < n) lanes[k++] = CMP(v + i, n - i);                              \
+    return CMP(lanes, k);                                                   \
+}
+
+AVX2_MINMAX(min_avx2, _mm256_min_pd, min_scalar)
+AVX2_MINMAX(max_avx2, _mm256_max_pd, max_scalar)
+
+// ——— AVX-512: 4 x 8 doubles por iteração, resto com load mascarado ———————
+
+__attribute__((target("avx512f")))
+static double sum_avx512(const double *v, int64_t n) {
+    __m512d a0 = _mm512_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+    int64_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        a0 = _mm512_add_pd(a0, _mm512_loadu_pd(v + i));
+        a1 = _mm512_add_pd(a1, _mm512_loadu_pd(v + i + 8));
+        a2 = _mm512_add_pd(a2, _mm512_loadu_pd(v + i + 16));
+        a3 = _mm512_add_pd(a3, _mm512_loadu_pd(v + i + 24));
+    }
+    for (; i < n; i += 8) {
+        __mmask8 k = n - i >= 8 ? 0xFF : (__mmask8)((1u << (n - i)) - 1);
+        a0 = _mm512_add_pd(a0, _mm512_maskz_loadu_pd(k, v + i));
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(a0, a1),
+                                              _mm512_add_pd(a2, a3)));
+}
+
+#define AVX512_MINMAX(NAME, OP, RED, CMP)                                   \
+__attribute__((target("avx512f")))                                          \
+static double NAME(const double *v, int64_t n) {                            \
+    if (n < 32) return CMP(v, n);                                           \
+    __m512d a0 = _mm512_loadu_pd(v),      a1 = _mm512_loadu_pd(v + 8);      \
+    __m512d a2 = _mm512_loadu_pd(v + 16), a3 = _mm512_loadu_pd(v + 24);     \
+    int64_t i = 32;                                                         \
+    for (; i + 32 <= n; i += 32) {                                          \
+        a0 = OP(a0, _mm512_loadu_pd(v + i));                                \
+        a1 = OP(a1, _mm512_loadu_pd(v + i + 8));                            \
+        a2 = OP(a2, _mm512_loadu_pd(v + i + 16));                           \
+        a3 = OP(a3, _mm512_loadu_pd(v + i + 24));                           \
+    }                                                                       \
+    double lanes[2];                                                        \
+    lanes[0] = RED(OP(OP(a0, a1), OP(a2, a3)));                             \
+    int k = 1;                                                              \
+    if (i < n) lanes[k++] = CMP(v + i, n - i);                              \
+    return CMP(lanes, k);                                                   \
+}
+
+AVX512_MINMAX(min_avx512, _mm512_min_pd, _mm512_reduce_min_pd, min_scalar)
+AVX512_MINMAX(max_avx512, _mm512_max_pd, _mm512_reduce_max_pd, max_scalar)
+
+#endif // LC_X86
+
+// ——— tabelas e dispatch ——————————————————————————————————————————————————
+
+static const AggKernels k_scalar = { sum_scalar, min_scalar, max_scalar };
+#ifdef LC_X86
+static const AggKernels k_sse2   = { sum_sse2,   min_sse2,   max_sse2   };
+static const AggKernels k_avx2   = { sum_avx2,   min_avx2,   max_avx2   };
+static const AggKernels k_avx512 = { sum_avx512, min_avx512, max_avx512 };
+#endif
+
+const AggKernels *kernels_for(KernelIsa isa) {
+    switch (isa) {
+      case ISA_SCALAR: return &k_scalar;
+#ifdef LC_X86
+      case ISA_SSE2:   return &k_sse2;
+      case ISA_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? &k_avx2 : NULL;
+      case ISA_AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") ? &k_avx512 : NULL;
+#endif
+      default:         return NULL;
+    }
+}
+
+// Resolvido uma vez por processo: kernels_best é chamado também dos
+// workers do pool (aggpar.c), e o pthread_once publica best e best_isa
+// juntos para todas as threads
+static pthread_once_t     best_once = PTHREAD_ONCE_INIT;
+static KernelIsa          best_isa  = ISA_COUNT;
+static const AggKernels  *best      = NULL;
+
+static void resolve_best(void) {
+    for (int isa = ISA_COUNT - 1; isa >= 0; --isa) {
+        const AggKernels *k = kernels_for((KernelIsa)isa);
+        if (k) {
+            best_isa = (KernelIsa)isa;
+            best     = k;
+            return;
+        }
+    }
+}
+
+const AggKernels *kernels_best(void) {
+    pthread_once(&best_once, resolve_best);
+    return best;
+}
+
+KernelIsa kernels_best_isa(void) {
+    pthread_once(&best_once, resolve_best);
+    return best_isa;
+}
+
+const char *kernels_isa_name(KernelIsa isa) {
+    switch (isa) {
+      case ISA_SCALAR: return "scalar";
+      case ISA_SSE2:   return "sse2";
+      case ISA_AVX2:   return "avx2";
+      case ISA_AVX512: return "avx512";
+      default:         return "?";
+    }
+}
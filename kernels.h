@@ -0,0 +1,40 @@
+// kernels.h
+// Kernels de agregação (SUM/MIN/MAX) sobre vetores de double, com versões
+// SSE2, AVX2 e AVX-512 escolhidas em runtime conforme a CPU.
+#ifndef LANGCELL_KERNELS_H
+#define LANGCELL_KERNELS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ISA_SCALAR,    // laço escalar de referência
+    ISA_SSE2,      // baseline x86-64
+    ISA_AVX2,
+    ISA_AVX512,
+    ISA_COUNT
+} KernelIsa;
+
+typedef struct {
+    double (*sum)(const double *v, int64_t n);
+    double (*min)(const double *v, int64_t n);   // n >= 1
+    double (*max)(const double *v, int64_t n);   // n >= 1
+} AggKernels;
+
+// Tabela da variante pedida, ou NULL se a CPU não a suporta
+const AggKernels *kernels_for(KernelIsa isa);
+
+// Melhor variante suportada (resolvida uma vez, na primeira chamada)
+const AggKernels *kernels_best(void);
+KernelIsa         kernels_best_isa(void);
+
+const char *kernels_isa_name(KernelIsa isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_KERNELS_H
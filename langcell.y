@@ -2,6 +2,7 @@
 
 %debug
 %define parse.error verbose
+%locations
 
  %{
  #include <stdio.h>
@@ -25,18 +26,17 @@
     double    fval;
     char     *sval;
     Expr     *expr;
-    Expr     *expr_list;
+    ExprList  expr_list;
     Stmt     *stmt;
-    Stmt     *stmt_list;
+    StmtList  stmt_list;
 }
 
 /* Tokens com valor */
 %token  <ival>    INT
 %token  <fval>    FLOAT
-%token  <sval>    TEXT CELL
+%token  <sval>    TEXT CELL IDENT
 
-%token            IF THEN WHILE TABLE EXPORT
-%token            SUM AVERAGE MIN MAX
+%token            IF THEN WHILE TABLE EXPORT IMPORT AT SAVE LOAD
 %token            AND OR NOT
 %token            GT LT GE LE EQ NE
 %token            PLUS MINUS TIMES DIVIDE
@@ -52,7 +52,7 @@
 %right  NOT UMINUS
 
 /* Não-terminais e tipos */
-%type  <stmt_list> start program
+%type  <stmt_list> top_program program
 %type  <stmt>      statement statement_block
 %type  <expr>      expression logical_or logical_and comparison
 %type  <expr>      addition_subtraction multiplication_division unary primary
@@ -63,13 +63,30 @@
 
 /* Símbolo inicial que captura o programa inteiro */
 start
-    : program              { program_root = $1; }
+    : top_program          { program_root = $1.head; }
     ;
 
-/* Programa: lista de statements */
+/* Statements de topo; no modo streaming cada um vai para ast_stream assim
+   que é reduzido e a lista fica vazia */
+top_program
+    : /* vazio */              { $$ = (StmtList){ NULL, NULL }; }
+    | top_program statement
+        {
+          $2->line = @2.first_line;
+          if (!ast_stream)
+              $$ = stmt_list_append($1, $2);
+          else if (ast_stream($2, yychar == YYEMPTY) != 0)
+              YYABORT;
+          else
+              $$ = $1;
+        }
+    ;
+
+/* Lista de statements de um bloco */
 program
-    : /* vazio */          { $$ = NULL; }
-    | program statement    { $$ = stmt_append($1, $2); }
+    : /* vazio */          { $$ = (StmtList){ NULL, NULL }; }
+    | program statement    { $2->line = @2.first_line;
+                             $$ = stmt_list_append($1, $2); }
     ;
 
 /* Statements */
@@ -84,14 +101,20 @@ statement
         { $$ = make_table_stmt(); }
     | EXPORT TEXT SEMI
         { $$ = make_export_stmt($2); }
+    | IMPORT TEXT AT CELL SEMI
+        { $$ = make_import_stmt($2, $4); }
+    | SAVE TEXT SEMI
+        { $$ = make_save_stmt($2); }
+    | LOAD TEXT SEMI
+        { $$ = make_load_stmt($2); }
     ;
 
 /* Bloco de statements dentro de IF/WHILE */
 statement_block
     : statement
-        { $$ = $1; }
+        { $1->line = @1.first_line; $$ = $1; }
     | LBRACE program RBRACE
-        { $$ = $2; }
+        { $$ = $2.head; }
     ;
 
 /* Expressão */
@@ -174,14 +197,8 @@ primary
         { $$ = make_text_expr($1); }
     | CELL
         { $$ = make_cell_expr($1); }
-    | SUM     LPAREN expression_list RPAREN
-        { $$ = make_call_expr("SUM",     $3); }
-    | AVERAGE LPAREN expression_list RPAREN
-        { $$ = make_call_expr("AVERAGE", $3); }
-    | MIN     LPAREN expression_list RPAREN
-        { $$ = make_call_expr("MIN",     $3); }
-    | MAX     LPAREN expression_list RPAREN
-        { $$ = make_call_expr("MAX",     $3); }
+    | IDENT LPAREN expression_list RPAREN
+        { $$ = make_call_expr($1, $3.head); }
     | LPAREN expression RPAREN
         { $$ = $2; }
     ;
@@ -189,9 +206,9 @@ primary
 /* Lista de expressões (argumentos) */
 expression_list
     : expression_or_range
-        { $$ = $1; }
+        { $$ = expr_list_append((ExprList){ NULL, NULL }, $1); }
     | expression_list COMMA expression_or_range
-        { $$ = expr_append($1, $3); }
+        { $$ = expr_list_append($1, $3); }
     ;
 
 /* Expressão ou rango */
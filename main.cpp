@@ -1,11 +1,22 @@
 // // main.cpp
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <sys/resource.h>
 #include "ast.h"
 #include "sema.h"
 #include "interp.h"
 #include "codegen.h"
+#include "vm.h"
+#include "recalc.h"
+#include "server.h"
+#include "pool.h"
+#include "aggpar.h"
 
+extern "C" FILE *yyin;
 extern "C" int yyparse(void);
 extern "C" int yyerror(const char *s);
 
@@ -16,12 +27,325 @@ int yyerror(const char *s) {
     return 1;
 }
 
-int main() {
+static void usage(const char *prog) {
+    std::fprintf(stderr,
+        "uso: %s [--engine=jit|vm|interp|tiered] [-O0|-O1|-O2|-O3]"
+        " [--jit=mcjit|orc] [--jit-threads=N] [--parallel] [--tier-threshold=N]"
+        " [--threads=N] [--agg-par-min=N]"
+        " [--recalc=edicoes.txt] [--cache-dir=DIR|--no-cache]"
+        " [--emit-obj ARQ.o|--emit-exe ARQ] [--emit-ir] [--emit-asm]"
+        " [--stats[=json]] [--profile[=cycles]] [--stream] < programa.lc\n"
+        "     %s --serve ARQ.sock [--workers=N] [-O0..-O3] [--jit=mcjit|orc]\n",
+        prog, prog);
+}
+
+// Diretório do cache de objetos do JIT: LANGCELL_CACHE_DIR, senão
+// $XDG_CACHE_HOME/langcell, senão ~/.cache/langcell
+static std::string default_cache_dir() {
+    const char *d = std::getenv("LANGCELL_CACHE_DIR");
+    if (d) return d;
+    d = std::getenv("XDG_CACHE_HOME");
+    if (d && *d) return std::string(d) + "/langcell";
+    d = std::getenv("HOME");
+    if (d && *d) return std::string(d) + "/.cache/langcell";
+    return "";
+}
+
+// Lê o programa inteiro de stdin (o fonte entra na chave do cache) e faz o
+// lexer ler da cópia em memória
+static bool slurp_stdin(std::string &src) {
+    char buf[65536];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof buf, stdin)) > 0) src.append(buf, n);
+    if (src.empty()) return true;
+    yyin = fmemopen(&src[0], src.size(), "r");
+    return yyin != nullptr;
+}
+
+// Engines de execução
+enum Engine { ENGINE_JIT, ENGINE_VM, ENGINE_INTERP, ENGINE_TIERED };
+static const char *const EngineNames[] = { "jit", "vm", "interp", "tiered" };
+
+// --stats: tempo de parede de cada fase, em segundos, e as estatísticas
+// do codegen
+enum StatsMode { STATS_OFF, STATS_TEXT, STATS_JSON };
+struct PhaseTimes {
+    double parse = 0, sema = 0, init = 0, run = 0;
+    CodegenStats cg = {};
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Relatório em stderr: uma tabela, ou uma linha JSON (lida por
+// bench/bench.c). Chamar antes de ast_release, que zera a contagem de nós.
+static void print_stats(const PhaseTimes &t, const char *engine, StatsMode mode) {
+    int64_t stmts, exprs;
+    ast_node_counts(&stmts, &exprs);
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    const CodegenStats &c = t.cg;
+    double total = t.parse + t.sema + t.init + c.irgen + c.optimize
+                 + c.finalize + t.run;
+
+    if (mode == STATS_JSON) {
+        std::fprintf(stderr,
+            "{\"engine\":\"%s\",\"parse\":%.6f,\"sema\":%.6f,\"init\":%.6f,"
+            "\"irgen\":%.6f,\"optimize\":%.6f,\"finalize\":%.6f,\"run\":%.6f,"
+            "\"stmts\":%lld,\"exprs\":%lld,\"functions\":%lld,\"blocks\":%lld,"
+            "\"insts\":%lld,\"code_bytes\":%lld,\"maxrss_kb\":%ld}\n",
+            engine, t.parse, t.sema, t.init, c.irgen, c.optimize, c.finalize,
+            t.run, (long long)stmts, (long long)exprs, (long long)c.functions,
+            (long long)c.blocks, (long long)c.insts, (long long)c.code_bytes,
+            ru.ru_maxrss);
+        return;
+    }
+    std::fprintf(stderr,
+        "==== estatísticas (%s) ====\n"
+        "parse (yyparse)         %10.6f s\n"
+        "sema                    %10.6f s\n"
+        "init_llvm               %10.6f s\n"
+        "geração de IR           %10.6f s\n"
+        "otimização              %10.6f s\n"
+        "código nativo           %10.6f s\n"
+        "execução                %10.6f s\n"
+        "total                   %10.6f s\n"
+        "AST                     %lld statements, %lld expressões\n"
+        "IR                      %lld funções, %lld blocos, %lld instruções\n"
+        "código de máquina       %lld bytes\n"
+        "pico de RSS             %ld KB\n",
+        engine, t.parse, t.sema, t.init, c.irgen, c.optimize, c.finalize,
+        t.run, total, (long long)stmts, (long long)exprs,
+        (long long)c.functions, (long long)c.blocks, (long long)c.insts,
+        (long long)c.code_bytes, ru.ru_maxrss);
+}
+
+// --stream: cada statement de topo roda assim que o parser o reduz; com o
+// parser parado logo depois dele, a arena volta ao ponto de antes do
+// primeiro statement, liberando a AST de tudo o que já rodou
+static AstMark StreamMark;
+
+static int stream_stmt(Stmt *s, int quiet) {
+    if (interp_stream_stmt(s) != 0) return 1;
+    if (quiet) ast_release_to(StreamMark);
+    return 0;
+}
+
+// back-edges de um WHILE antes de o modo tiered compilá-lo
+static const long DefaultTierThreshold = 1000;
+
+int main(int argc, char **argv) {
+    Engine    exec    = ENGINE_JIT;
+    JitEngine engine  = JIT_MCJIT;
+    unsigned  threads = 0;
+    int       opt     = 2;
+    long      tier    = DefaultTierThreshold;
+    bool      parallel = false;
+    const char *recalc_file = nullptr;
+    std::string cache_dir = default_cache_dir();
+    const char *emit_path = nullptr;    // --emit-obj / --emit-exe
+    bool        emit_exe  = false;
+    bool        emit_ir   = false;      // --emit-ir / --emit-asm
+    bool        emit_asm  = false;
+    StatsMode   stats     = STATS_OFF;
+    ProfileMode profile   = PROFILE_OFF;
+    bool        stream    = false;
+    const char *serve_path = nullptr;   // --serve
+    unsigned    workers   = 0;
+    PhaseTimes  times;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (std::strcmp(a, "--engine=jit") == 0) {
+            exec = ENGINE_JIT;
+        } else if (std::strcmp(a, "--engine=vm") == 0) {
+            exec = ENGINE_VM;
+        } else if (std::strcmp(a, "--engine=interp") == 0) {
+            exec = ENGINE_INTERP;
+        } else if (std::strcmp(a, "--engine=tiered") == 0) {
+            exec = ENGINE_TIERED;
+        } else if (std::strncmp(a, "--tier-threshold=", 17) == 0) {
+            tier = std::atol(a + 17);
+        } else if (std::strncmp(a, "--recalc=", 9) == 0) {
+            recalc_file = a + 9;
+        } else if (std::strcmp(a, "--jit=mcjit") == 0) {
+            engine = JIT_MCJIT;
+        } else if (std::strcmp(a, "--jit=orc") == 0) {
+            engine = JIT_ORC;
+        } else if (a[0] == '-' && a[1] == 'O' && a[2] >= '0' && a[2] <= '3'
+                   && a[3] == '\0') {
+            opt = a[2] - '0';
+        } else if (std::strcmp(a, "--emit-ir") == 0) {
+            emit_ir = true;
+        } else if (std::strcmp(a, "--emit-asm") == 0) {
+            emit_asm = true;
+        } else if (std::strcmp(a, "--emit-obj") == 0 ||
+                   std::strcmp(a, "--emit-exe") == 0) {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                return 1;
+            }
+            emit_exe  = a[7] == 'e';
+            emit_path = argv[++i];
+        } else if (std::strncmp(a, "--emit-obj=", 11) == 0 ||
+                   std::strncmp(a, "--emit-exe=", 11) == 0) {
+            emit_exe  = a[7] == 'e';
+            emit_path = a + 11;
+        } else if (std::strncmp(a, "--cache-dir=", 12) == 0) {
+            cache_dir = a + 12;
+        } else if (std::strcmp(a, "--no-cache") == 0) {
+            cache_dir.clear();
+        } else if (std::strcmp(a, "--profile") == 0) {
+            profile = PROFILE_HITS;
+        } else if (std::strcmp(a, "--profile=cycles") == 0) {
+            profile = PROFILE_CYCLES;
+        } else if (std::strcmp(a, "--stats") == 0) {
+            stats = STATS_TEXT;
+        } else if (std::strcmp(a, "--stats=json") == 0) {
+            stats = STATS_JSON;
+        } else if (std::strcmp(a, "--stream") == 0) {
+            stream = true;
+        } else if (std::strcmp(a, "--serve") == 0) {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                return 1;
+            }
+            serve_path = argv[++i];
+        } else if (std::strncmp(a, "--serve=", 8) == 0) {
+            serve_path = a + 8;
+        } else if (std::strncmp(a, "--workers=", 10) == 0) {
+            workers = (unsigned)std::atoi(a + 10);
+        } else if (std::strcmp(a, "--parallel") == 0) {
+            parallel = true;
+        } else if (std::strncmp(a, "--jit-threads=", 14) == 0) {
+            threads = (unsigned)std::atoi(a + 14);
+        } else if (std::strncmp(a, "--threads=", 10) == 0) {
+            pool_set_threads(std::atoi(a + 10));
+        } else if (std::strncmp(a, "--agg-par-min=", 14) == 0) {
+            aggpar_set_min(std::atoll(a + 14));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // --serve: processo residente; os programas chegam pelo socket e rodam
+    // sempre no JIT
+    if (serve_path) {
+        set_jit_options(engine, threads);
+        set_opt_level(opt);
+        return serve(serve_path, workers);
+    }
+
+    // --stream: parse, sema e execução intercalados, sempre no interpretador
+    // (os outros engines precisam do programa inteiro)
+    if (stream) {
+        if (recalc_file || emit_path) {
+            std::fprintf(stderr, "--stream não combina com --recalc/--emit-*\n");
+            return 1;
+        }
+        StreamMark = ast_mark();
+        interp_stream_begin();
+        ast_stream = stream_stmt;
+        auto t0 = std::chrono::steady_clock::now();
+        int rc = yyparse() != 0;
+        times.run = seconds_since(t0);
+        ast_stream = nullptr;
+        if (stats) print_stats(times, "stream", stats);
+        ast_release();
+        return rc;
+    }
+
+    // o cache só vale para o programa inteiro compilado pelo MCJIT; as
+    // listagens precisam do IR, que um acerto no cache não gera, e o
+    // --profile gera outro código
+    bool use_cache = exec == ENGINE_JIT && engine == JIT_MCJIT
+                     && !cache_dir.empty() && !recalc_file && !emit_path
+                     && !emit_ir && !emit_asm && !profile;
+    std::string source;
+    if ((use_cache || profile) && !slurp_stdin(source)) {
+        std::perror("stdin");
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
     if (yyparse()!=0) return 1;
-    if (analyze_stmt_list(program_root)>0) return 1;
-    init_llvm("LangCellModule");
-    generate_code(program_root);
-    return run_code();
+    times.parse = seconds_since(t0);
+    t0 = std::chrono::steady_clock::now();
+    if (analyze_program(program_root)>0) return 1;
+    times.sema = seconds_since(t0);
+
+    set_emit_listing(emit_ir, emit_asm);
+    set_profile(profile, source.data(), source.size());   // linhas do relatório
+
+    // AOT: só gera o objeto/executável, o programa não roda aqui
+    if (emit_path) {
+        set_opt_level(opt);
+        set_parallel(parallel);
+        int rc = emit_native(program_root, emit_path, emit_exe);
+        times.cg = codegen_stats();
+        if (stats) print_stats(times, "aot", stats);
+        ast_release();
+        return rc;
+    }
+
+    // o recálculo incremental trabalha sobre o store do interpretador
+    if (recalc_file && exec != ENGINE_TIERED) exec = ENGINE_INTERP;
+
+    // engines sem LLVM: nada de init_llvm para scripts curtos
+    int rc;
+    t0 = std::chrono::steady_clock::now();
+    if (exec == ENGINE_INTERP) {
+        rc = interpret(program_root);
+        times.run = seconds_since(t0);
+    } else if (exec == ENGINE_VM) {
+        VmProgram *vm = vm_compile(program_root);
+        rc = vm_run(vm);
+        vm_free(vm);
+        times.run = seconds_since(t0);
+    } else {
+        set_jit_options(engine, threads);
+        set_opt_level(opt);
+        set_parallel(parallel);
+        if (use_cache)
+            set_object_cache(cache_dir.c_str(), source.data(), source.size());
+
+        // tiered: interpreta e só sobe para o JIT os WHILE quentes; o LLVM é
+        // inicializado pelo primeiro laço compilado
+        if (exec == ENGINE_TIERED) {
+            interp_set_tiering(tier, jit_compile_loop);
+            rc = interpret(program_root);
+            times.run = seconds_since(t0);
+        } else {
+            init_llvm("LangCellModule");
+            times.init = seconds_since(t0);
+            generate_code(program_root);
+            t0 = std::chrono::steady_clock::now();
+            rc = run_code();
+            times.run = seconds_since(t0);
+        }
+        times.cg = codegen_stats();   // com ORC, code_bytes cresce durante run_code
+    }
+    if (stats) print_stats(times, EngineNames[exec], stats);
+
+    // --recalc: aplica as edições do arquivo sobre o resultado do programa
+    if (rc == 0 && recalc_file) {
+        FILE *f = std::fopen(recalc_file, "r");
+        if (!f) {
+            std::perror(recalc_file);
+            rc = 1;
+        } else {
+            Recalc *r = recalc_build(program_root);
+            rc = recalc_script(r, f);
+            recalc_free(r);
+            std::fclose(f);
+        }
+    }
+
+    // AST e strings do lexer saem da arena de uma vez
+    ast_release();
+    return rc;
   }
   
 
@@ -32,7 +356,8 @@ int main() {
 // #include "interp.h"
 // #include "codegen.h"
 
-// extern "C" int yyparse(void);
+// extern "C" FILE *yyin;
+extern "C" int yyparse(void);
 // extern "C" int yyerror(const char *s);
 
 // // O parser define e preenche esta variável
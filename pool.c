@@ -0,0 +1,174 @@
+// pool.c
+// Pool de threads com roubo de trabalho (ver pool.h). A thread que chama
+// pool_run trabalha como a thread 0; as demais são criadas no primeiro uso e
+// dormem numa condition variable entre um pool_run e outro.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "pool.h"
+#include "runtime.h"
+
+// Faixa de índices de uma thread: a dona consome de lo, ladrões tiram a
+// metade de cima. Uma linha de cache por faixa, para evitar false sharing.
+typedef struct {
+    pthread_mutex_t lock;
+    int64_t         lo, hi;
+} __attribute__((aligned(64))) Range;
+
+static int    Requested = 0;     // pool_set_threads
+static int    NThreads  = 0;     // 0 até o primeiro pool_run
+static Range *Ranges    = NULL;
+
+static pthread_mutex_t RunMu = PTHREAD_MUTEX_INITIALIZER;  // um pool_run por vez
+static pthread_mutex_t Mu    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  Start = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  Done  = PTHREAD_COND_INITIALIZER;
+static uint64_t        Gen   = 0;    // muda a cada pool_run
+static int             Busy  = 0;    // threads dentro de work()
+static PoolTaskFn      JobFn;
+static void           *JobCtx;
+
+static __thread int InPool = 0;
+
+void pool_set_threads(int n) {
+    Requested = n > 0 ? n : 0;
+}
+
+int pool_threads(void) {
+    if (NThreads) return NThreads;
+    if (Requested) return Requested;
+    const char *e = getenv("LANGCELL_THREADS");
+    if (e && atoi(e) > 0) return atoi(e);
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+// Próximo índice para a thread self: da própria faixa ou roubado
+static int take(int self, int64_t *i) {
+    Range *r = &Ranges[self];
+    pthread_mutex_lock(&r->lock);
+    if (r->lo < r->hi) {
+        *i = r->lo++;
+        pthread_mutex_unlock(&r->lock);
+        return 1;
+    }
+    pthread_mutex_unlock(&r->lock);
+
+    for (int k = 1; k < NThreads; ++k) {
+        Range *v = &Ranges[(self + k) % NThreads];
+        pthread_mutex_lock(&v->lock);
+        int64_t n = v->hi - v->lo;
+        if (n > 0) {
+            int64_t lo = v->hi - (n + 1) / 2, hi = v->hi;
+            v->hi = lo;
+            pthread_mutex_unlock(&v->lock);
+            pthread_mutex_lock(&r->lock);
+            r->lo = lo + 1;
+            r->hi = hi;
+            pthread_mutex_unlock(&r->lock);
+            *i = lo;
+            return 1;
+        }
+        pthread_mutex_unlock(&v->lock);
+    }
+    return 0;
+}
+
+static void work(int self) {
+    int64_t i;
+    while (take(self, &i)) JobFn(JobCtx, i);
+}
+
+static void *worker_main(void *arg) {
+    int self = (int)(intptr_t)arg;
+    uint64_t seen = 0;
+    InPool = 1;
+    pthread_mutex_lock(&Mu);
+    for (;;) {
+        while (Gen == seen) pthread_cond_wait(&Start, &Mu);
+        seen = Gen;
+        Busy++;
+        pthread_mutex_unlock(&Mu);
+        work(self);
+        pthread_mutex_lock(&Mu);
+        if (--Busy == 0) pthread_cond_signal(&Done);
+    }
+    return NULL;
+}
+
+static void start_pool(void) {
+    NThreads = pool_threads();
+    if (posix_memalign((void **)&Ranges, 64, NThreads * sizeof *Ranges)) exit(1);
+    for (int t = 0; t < NThreads; ++t) {
+        pthread_mutex_init(&Ranges[t].lock, NULL);
+        Ranges[t].lo = Ranges[t].hi = 0;
+    }
+    for (int t = 1; t < NThreads; ++t) {
+        pthread_t th;
+        if (pthread_create(&th, NULL, worker_main, (void *)(intptr_t)t) != 0) {
+            NThreads = t;      // segue com as threads que conseguiu criar
+            break;
+        }
+        pthread_detach(th);
+    }
+}
+
+void pool_run(PoolTaskFn fn, void *ctx, int64_t n) {
+    if (n <= 0) return;
+    if (InPool || n == 1 || pool_threads() == 1) {
+        for (int64_t i = 0; i < n; ++i) fn(ctx, i);
+        return;
+    }
+
+    pthread_mutex_lock(&RunMu);
+    if (!NThreads) start_pool();
+
+    // uma thread que acordou atrasada para o pool_run anterior pode ainda
+    // estar em work(); com Busy == 0 as faixas e JobFn são só nossos
+    pthread_mutex_lock(&Mu);
+    while (Busy > 0) pthread_cond_wait(&Done, &Mu);
+    JobFn  = fn;
+    JobCtx = ctx;
+    for (int t = 0; t < NThreads; ++t) {
+        Ranges[t].lo = n * t / NThreads;
+        Ranges[t].hi = n * (t + 1) / NThreads;
+    }
+    Gen++;
+    Busy++;
+    pthread_cond_broadcast(&Start);
+    pthread_mutex_unlock(&Mu);
+
+    InPool = 1;
+    work(0);
+    InPool = 0;
+
+    // quem ainda está em work() pode estar rodando a última tarefa
+    pthread_mutex_lock(&Mu);
+    Busy--;
+    while (Busy > 0) pthread_cond_wait(&Done, &Mu);
+    pthread_mutex_unlock(&Mu);
+    pthread_mutex_unlock(&RunMu);
+}
+
+// ——— par_run (runtime.h) ——————————————————————————————————————————————————
+
+typedef struct {
+    const ParTaskFn *tasks;
+    double          *num;
+    const char     **text;
+    int64_t         *ival;
+    unsigned char   *kind;
+    unsigned char   *assigned;
+} ParJob;
+
+static void par_task(void *ctx, int64_t i) {
+    ParJob *j = ctx;
+    j->tasks[i](j->num, j->text, j->ival, j->kind, j->assigned);
+}
+
+void par_run(const ParTaskFn *tasks, int64_t n, double *num, const char **text,
+             int64_t *ival, unsigned char *kind, unsigned char *assigned) {
+    ParJob j = { tasks, num, text, ival, kind, assigned };
+    pool_run(par_task, &j, n);
+}
@@ -0,0 +1,30 @@
+// pool.h
+// Pool de threads persistente com roubo de trabalho (work stealing). Cada
+// pool_run divide [0, n) em faixas contíguas, uma por thread; quem esvazia a
+// própria faixa rouba metade da faixa de outra thread.
+#ifndef LANGCELL_POOL_H
+#define LANGCELL_POOL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*PoolTaskFn)(void *ctx, int64_t i);
+
+// Número de threads (contando a que chama pool_run). Deve ser chamada antes
+// do primeiro pool_run; 0 usa LANGCELL_THREADS, se definida, ou o número de
+// núcleos da máquina.
+void pool_set_threads(int n);
+int  pool_threads(void);
+
+// Executa fn(ctx, i) para todo i em [0, n) e espera todas terminarem.
+// Chamadas de dentro de uma tarefa rodam sequencialmente na própria thread.
+void pool_run(PoolTaskFn fn, void *ctx, int64_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_POOL_H
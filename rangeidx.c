@@ -0,0 +1,116 @@
+// rangeidx.c
+// Árvore de segmentos dos ranges indexados (ver rangeidx.h). Árvore
+// implícita em vetor: o nó i tem filhos 2i e 2i+1, a raiz é o nó 1 e as
+// folhas ocupam [size, size + n), na ordem column-major do range; as folhas
+// de sobra até a potência de 2 são neutras (+inf no mínimo, -inf no máximo).
+
+#include <math.h>
+#include <stdlib.h>
+#include "rangeidx.h"
+#include "runtime.h"
+
+// Agregados mantidos pela árvore
+enum { BIT_MIN = 1, BIT_MAX = 2 };
+
+struct RangeIndex {
+    int64_t  col0, row0;           // canto do range no grid
+    int64_t  slot, rows, cols, stride;
+    int64_t  size;                 // folhas: potência de 2 >= rows * cols
+    unsigned want;                 // agregados já pedidos por uma consulta
+    unsigned built;                // agregados válidos na árvore (0: remontar)
+    double  *min, *max;            // 2 * size nós cada, alocados sob demanda
+};
+
+RangeIndex *rindex_new(int64_t slot, int64_t rows, int64_t cols, int64_t stride) {
+    RangeIndex *ix = calloc(1, sizeof *ix);
+    if (!ix) exit(1);
+    ix->slot   = slot;
+    ix->rows   = rows;
+    ix->cols   = cols;
+    ix->stride = stride;
+    ix->col0   = slot / stride;
+    ix->row0   = slot % stride;
+    ix->size   = 1;
+    while (ix->size < rows * cols) ix->size *= 2;
+    return ix;
+}
+
+void rindex_free(RangeIndex *ix) {
+    if (!ix) return;
+    free(ix->min);
+    free(ix->max);
+    free(ix);
+}
+
+void rindex_invalidate(RangeIndex *ix) {
+    if (ix) ix->built = 0;
+}
+
+// mesmas comparações dos kernels escalares: em empate fica o primeiro
+static inline double lower(double a, double b)  { return b < a ? b : a; }
+static inline double higher(double a, double b) { return b > a ? b : a; }
+
+static double *tree_alloc(double *t, int64_t size) {
+    if (!t) t = malloc((size_t)(2 * size) * sizeof *t);
+    if (!t) exit(1);
+    return t;
+}
+
+static void build(RangeIndex *ix, const double *num) {
+    int64_t size = ix->size, n = ix->rows * ix->cols;
+    if (ix->want & BIT_MIN) ix->min = tree_alloc(ix->min, size);
+    if (ix->want & BIT_MAX) ix->max = tree_alloc(ix->max, size);
+
+    for (int64_t c = 0, k = size; c < ix->cols; ++c) {
+        const double *col = num + ix->slot + c * ix->stride;
+        for (int64_t r = 0; r < ix->rows; ++r, ++k) {
+            if (ix->min) ix->min[k] = col[r];
+            if (ix->max) ix->max[k] = col[r];
+        }
+    }
+    for (int64_t k = size + n; k < 2 * size; ++k) {
+        if (ix->min) ix->min[k] = INFINITY;
+        if (ix->max) ix->max[k] = -INFINITY;
+    }
+    for (int64_t i = size - 1; i >= 1; --i) {
+        if (ix->min) ix->min[i] = lower(ix->min[2 * i], ix->min[2 * i + 1]);
+        if (ix->max) ix->max[i] = higher(ix->max[2 * i], ix->max[2 * i + 1]);
+    }
+    ix->built = ix->want;
+}
+
+void rindex_set(RangeIndex *ix, int64_t slot, double v) {
+    if (!ix || !ix->built) return;
+    int64_t dc = slot / ix->stride - ix->col0;
+    int64_t dr = slot % ix->stride - ix->row0;
+    if (dc < 0 || dc >= ix->cols || dr < 0 || dr >= ix->rows) return;
+
+    int64_t leaf = ix->size + dc * ix->rows + dr;
+    if (ix->min) {
+        ix->min[leaf] = v;
+        for (int64_t i = leaf / 2; i >= 1; i /= 2)
+            ix->min[i] = lower(ix->min[2 * i], ix->min[2 * i + 1]);
+    }
+    if (ix->max) {
+        ix->max[leaf] = v;
+        for (int64_t i = leaf / 2; i >= 1; i /= 2)
+            ix->max[i] = higher(ix->max[2 * i], ix->max[2 * i + 1]);
+    }
+}
+
+double rindex_query(RangeIndex *ix, int fn, const double *num) {
+    unsigned bit = fn == AGG_MIN ? BIT_MIN : BIT_MAX;
+    if (!(ix->built & bit)) {
+        ix->want |= bit;
+        build(ix, num);
+    }
+    return fn == AGG_MIN ? ix->min[1] : ix->max[1];
+}
+
+// ——— ABI do JIT (runtime.h) ——————————————————————————————————————————————
+
+double lc_rindex_query(RangeIndex **ix, int fn, const double *num, int64_t slot,
+                       int64_t rows, int64_t cols, int64_t stride) {
+    if (!*ix) *ix = rindex_new(slot, rows, cols, stride);
+    return rindex_query(*ix, fn, num);
+}
@@ -0,0 +1,48 @@
+// rangeidx.h
+// Índice de agregação de um range: árvore de segmentos sobre as células do
+// range, com o mínimo e o máximo de cada subárvore. Serve o MIN e o MAX de
+// um único range grande lidos dentro de um WHILE (marcados pela sema em
+// Expr.range.indexed): a consulta lê a raiz em O(1) e cada escrita numa
+// célula coberta custa O(log n), em vez de percorrer o range inteiro a cada
+// volta do laço. A árvore é montada a partir do grid na primeira consulta e
+// só mantém os agregados já pedidos.
+//
+// SUM e AVERAGE não são indexados: a soma na ordem da árvore (pares de
+// subárvores) não bate bit a bit com a do kernel linear, e o resultado de
+// um programa não pode depender de o range ter índice ou não. Mínimo e
+// máximo saem iguais em qualquer ordem.
+#ifndef LANGCELL_RANGEIDX_H
+#define LANGCELL_RANGEIDX_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ranges menores que isso ficam com os kernels vetorizados: percorrê-los
+// custa menos que manter a árvore a cada escrita
+#define RINDEX_MIN_CELLS 4096
+
+typedef struct RangeIndex RangeIndex;
+
+// Índice do bloco rows x cols que começa em 'slot' num grid column-major de
+// 'stride' linhas
+RangeIndex *rindex_new(int64_t slot, int64_t rows, int64_t cols, int64_t stride);
+void        rindex_free(RangeIndex *ix);
+
+// Descarta o conteúdo (o grid mudou por fora): a próxima consulta remonta
+void rindex_invalidate(RangeIndex *ix);
+
+// A célula 'slot' do grid passou a valer v; ignorado se ela não está no
+// range ou se a árvore ainda não foi montada
+void rindex_set(RangeIndex *ix, int64_t slot, double v);
+
+// fn (AGG_MIN ou AGG_MAX) sobre o range em num[]
+double rindex_query(RangeIndex *ix, int fn, const double *num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_RANGEIDX_H
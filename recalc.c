@@ -0,0 +1,361 @@
+// recalc.c
+// Grafo de dependências entre células e recálculo incremental (ver recalc.h).
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "recalc.h"
+#include "cells.h"
+#include "interp.h"
+#include "sema.h"
+
+struct Recalc {
+    Stmt             *program;
+    const CellLayout *layout;
+    ValueStore       *store;
+    int64_t           ncells;
+
+    Stmt            **formula;   // ASSIGN que define o slot, ou NULL
+    unsigned char    *opaque;    // slot lido fora do grafo (IF/WHILE, etc.)
+    int64_t          *dep_off;   // CSR: dep_to[dep_off[c] .. dep_off[c+1]]
+    int64_t          *dep_to;    //      são as fórmulas que leem a célula c
+
+    unsigned char    *pinned;    // valor fixado por recalc_set
+    unsigned char    *is_changed;
+    int64_t          *changed;   // slots alterados desde o último recalc_run
+    int64_t           n_changed;
+
+    // rascunho de recalc_run
+    unsigned char    *dirty;
+    int64_t          *indeg;
+    int64_t          *queue;     // fórmulas sujas, na ordem da busca
+    int64_t          *order;     // fila de Kahn
+    int64_t          *reads;     // ver expand_reads
+    int64_t           reads_cap;
+};
+
+// Expande as leituras de s (células e ranges) em slots, em rc->reads
+static int64_t expand_reads(Recalc *rc, const Stmt *s) {
+    int64_t n = 0;
+    for (int64_t i = 0; i < s->n_reads; ++i) {
+        const Expr *r = s->reads[i];
+        n += r->kind == EXPR_RANGE ? r->range.rows * r->range.cols : 1;
+    }
+    if (n > rc->reads_cap) {
+        rc->reads     = realloc(rc->reads, n * sizeof *rc->reads);
+        rc->reads_cap = n;
+        if (!rc->reads) exit(1);
+    }
+    int64_t k = 0;
+    for (int64_t i = 0; i < s->n_reads; ++i) {
+        const Expr *r = s->reads[i];
+        if (r->kind != EXPR_RANGE) {
+            rc->reads[k++] = r->slot;
+            continue;
+        }
+        for (int64_t c = 0; c < r->range.cols; ++c) {
+            int64_t col = r->range.slot + c * rc->layout->nrows;
+            for (int64_t j = 0; j < r->range.rows; ++j) rc->reads[k++] = col + j;
+        }
+    }
+    return k;
+}
+
+// ——— construção do grafo ——————————————————————————————————————————————————
+
+// IMPORT pode escrever qualquer célula à direita e abaixo do seu canto, e
+// LOAD qualquer célula do grid: essas células nunca são fórmulas
+static void count_region(const CellLayout *L, int64_t col, int64_t row,
+                         int64_t *nassign) {
+    for (int64_t slot = 0, n = layout_ncells(L); slot < n; ++slot) {
+        int64_t c, r;
+        layout_coords(L, slot, &c, &r);
+        if (c >= col && r >= row) nassign[slot] += 2;
+    }
+}
+
+static void count_assigns(const CellLayout *L, Stmt *s, int64_t *nassign) {
+    for (; s; s = s->next) {
+        switch (s->kind) {
+          case STMT_ASSIGN: nassign[s->assign.slot]++; break;
+          case STMT_IF:     count_assigns(L, s->ifs.then_branch, nassign); break;
+          case STMT_WHILE:  count_assigns(L, s->whiles.body, nassign); break;
+          case STMT_IMPORT: count_region(L, s->imp.col, s->imp.row, nassign); break;
+          case STMT_LOAD:   count_region(L, L->col0, L->row0, nassign); break;
+          default:          break;
+        }
+    }
+}
+
+// Tudo o que statements fora do grafo leem (condições, corpos de IF/WHILE,
+// atribuições repetidas) é opaco: mudar essas células exige reexecução
+static void mark_opaque(Recalc *rc, Stmt *s, int top) {
+    for (; s; s = s->next) {
+        int is_formula = top && s->kind == STMT_ASSIGN &&
+                         rc->formula[s->assign.slot] == s;
+        if (!is_formula) {
+            int64_t n = expand_reads(rc, s);
+            for (int64_t i = 0; i < n; ++i) rc->opaque[rc->reads[i]] = 1;
+        }
+        if (s->kind == STMT_IF)    mark_opaque(rc, s->ifs.then_branch, 0);
+        if (s->kind == STMT_WHILE) mark_opaque(rc, s->whiles.body, 0);
+    }
+}
+
+Recalc *recalc_build(Stmt *program) {
+    Recalc *rc = calloc(1, sizeof *rc);
+    if (!rc) exit(1);
+    rc->program = program;
+    rc->layout  = sema_layout();
+    rc->store   = interp_store();
+    rc->ncells  = layout_ncells(rc->layout);
+    int64_t n   = rc->ncells > 0 ? rc->ncells : 1;
+
+    int64_t *nassign = calloc(n, sizeof *nassign);
+    rc->formula  = calloc(n, sizeof *rc->formula);
+    rc->opaque   = calloc(n, sizeof *rc->opaque);
+    rc->dep_off  = calloc(n + 1, sizeof *rc->dep_off);
+    rc->pinned   = calloc(n, sizeof *rc->pinned);
+    rc->is_changed = calloc(n, sizeof *rc->is_changed);
+    rc->changed  = malloc(n * sizeof *rc->changed);
+    rc->dirty    = calloc(n, sizeof *rc->dirty);
+    rc->indeg    = calloc(n, sizeof *rc->indeg);
+    rc->queue    = malloc(n * sizeof *rc->queue);
+    rc->order    = malloc(n * sizeof *rc->order);
+    if (!nassign || !rc->formula || !rc->opaque || !rc->dep_off ||
+        !rc->pinned || !rc->is_changed || !rc->changed || !rc->dirty ||
+        !rc->indeg || !rc->queue || !rc->order)
+        exit(1);
+
+    // fórmula = ASSIGN de topo a uma célula atribuída uma única vez
+    count_assigns(rc->layout, program, nassign);
+    for (Stmt *s = program; s; s = s->next)
+        if (s->kind == STMT_ASSIGN && nassign[s->assign.slot] == 1)
+            rc->formula[s->assign.slot] = s;
+    free(nassign);
+    mark_opaque(rc, program, 1);
+
+    // arestas célula → fórmula, em CSR (contagem, prefixo, preenchimento)
+    for (Stmt *s = program; s; s = s->next) {
+        if (s->kind != STMT_ASSIGN || rc->formula[s->assign.slot] != s) continue;
+        int64_t k = expand_reads(rc, s);
+        for (int64_t i = 0; i < k; ++i) rc->dep_off[rc->reads[i] + 1]++;
+    }
+    for (int64_t i = 0; i < n; ++i) rc->dep_off[i + 1] += rc->dep_off[i];
+    rc->dep_to = malloc((rc->dep_off[n] ? rc->dep_off[n] : 1) * sizeof *rc->dep_to);
+    int64_t *fill = malloc(n * sizeof *fill);
+    if (!rc->dep_to || !fill) exit(1);
+    memcpy(fill, rc->dep_off, n * sizeof *fill);
+    for (Stmt *s = program; s; s = s->next) {
+        if (s->kind != STMT_ASSIGN || rc->formula[s->assign.slot] != s) continue;
+        int64_t k = expand_reads(rc, s);
+        for (int64_t i = 0; i < k; ++i)
+            rc->dep_to[fill[rc->reads[i]]++] = s->assign.slot;
+    }
+    free(fill);
+    return rc;
+}
+
+void recalc_free(Recalc *rc) {
+    if (!rc) return;
+    free(rc->formula);
+    free(rc->opaque);
+    free(rc->dep_off);
+    free(rc->dep_to);
+    free(rc->pinned);
+    free(rc->is_changed);
+    free(rc->changed);
+    free(rc->dirty);
+    free(rc->indeg);
+    free(rc->queue);
+    free(rc->order);
+    free(rc->reads);
+    free(rc);
+}
+
+// ——— edição e recálculo ———————————————————————————————————————————————————
+
+int recalc_set(Recalc *rc, const char *cell, Value v) {
+    int64_t col, row;
+    const CellLayout *L = rc->layout;
+    int64_t slot;
+    if (cell_parse(cell, &col, &row) != 0 || (slot = layout_find(L, col, row)) < 0)
+        return -1;
+    store_set(rc->store, slot, v);
+    rc->formula[slot] = NULL;
+    rc->pinned[slot]  = 1;
+    if (!rc->is_changed[slot]) {
+        rc->is_changed[slot] = 1;
+        rc->changed[rc->n_changed++] = slot;
+    }
+    return 0;
+}
+
+static int64_t rerun(Recalc *rc, int64_t n_dirty) {
+    for (int64_t i = 0; i < n_dirty; ++i) rc->dirty[rc->queue[i]] = 0;
+    interp_rerun(rc->program, rc->pinned);
+    return -1;
+}
+
+int64_t recalc_run(Recalc *rc) {
+    int64_t n_changed = rc->n_changed;
+    rc->n_changed = 0;
+    for (int64_t i = 0; i < n_changed; ++i) rc->is_changed[rc->changed[i]] = 0;
+    if (n_changed == 0) return 0;
+
+    // 1) fórmulas sujas: busca em largura a partir das células alteradas;
+    //    queue[0..n_dirty) guarda as fórmulas na ordem em que foram achadas
+    int64_t n_dirty = 0, opaque = 0;
+    for (int64_t i = 0; i < n_changed; ++i) {
+        int64_t c = rc->changed[i];
+        opaque |= rc->opaque[c];
+        for (int64_t e = rc->dep_off[c]; e < rc->dep_off[c + 1]; ++e) {
+            int64_t f = rc->dep_to[e];
+            if (rc->formula[f] && !rc->dirty[f]) {
+                rc->dirty[f] = 1;
+                rc->queue[n_dirty++] = f;
+            }
+        }
+    }
+    for (int64_t h = 0; h < n_dirty; ++h) {
+        int64_t c = rc->queue[h];
+        opaque |= rc->opaque[c];
+        for (int64_t e = rc->dep_off[c]; e < rc->dep_off[c + 1]; ++e) {
+            int64_t f = rc->dep_to[e];
+            if (rc->formula[f] && !rc->dirty[f]) {
+                rc->dirty[f] = 1;
+                rc->queue[n_dirty++] = f;
+            }
+        }
+    }
+    if (opaque) return rerun(rc, n_dirty);
+
+    // 2) grau de entrada de cada fórmula suja, contando só leituras de
+    //    outras fórmulas sujas
+    for (int64_t i = 0; i < n_dirty; ++i) {
+        int64_t f = rc->queue[i], d = 0;
+        int64_t k = expand_reads(rc, rc->formula[f]);
+        for (int64_t j = 0; j < k; ++j) d += rc->dirty[rc->reads[j]];
+        rc->indeg[f] = d;
+    }
+
+    // 3) Kahn: reavalia cada fórmula depois de todas as que ela lê
+    int64_t *order = rc->order;
+    int64_t head = 0, tail = 0;
+    for (int64_t i = 0; i < n_dirty; ++i)
+        if (rc->indeg[rc->queue[i]] == 0) order[tail++] = rc->queue[i];
+    while (head < tail) {
+        int64_t f = order[head++];
+        Stmt   *s = rc->formula[f];
+        store_set(rc->store, f, interp_eval(s->assign.expr));
+        for (int64_t e = rc->dep_off[f]; e < rc->dep_off[f + 1]; ++e) {
+            int64_t g = rc->dep_to[e];
+            if (rc->dirty[g] && --rc->indeg[g] == 0) order[tail++] = g;
+        }
+    }
+
+    // ciclo entre fórmulas sujas: sem ordem topológica, reexecuta tudo
+    if (tail < n_dirty) return rerun(rc, n_dirty);
+    for (int64_t i = 0; i < n_dirty; ++i) rc->dirty[rc->queue[i]] = 0;
+    return n_dirty;
+}
+
+// ——— comandos ——————————————————————————————————————————————————————————
+
+static void skip_space(const char **p) {
+    for (;;) {
+        while (isspace((unsigned char)**p)) ++*p;
+        if ((*p)[0] == '/' && (*p)[1] == '/') {
+            while (**p && **p != '\n') ++*p;
+        } else {
+            return;
+        }
+    }
+}
+
+static int expect_semi(const char **p) {
+    skip_space(p);
+    if (**p != ';') return -1;
+    ++*p;
+    return 0;
+}
+
+int recalc_script(Recalc *rc, FILE *f) {
+    // lê o arquivo inteiro; os textos vão para a arena da AST
+    size_t cap = 4096, len = 0;
+    char *buf = malloc(cap);
+    if (!buf) exit(1);
+    size_t got;
+    while ((got = fread(buf + len, 1, cap - len - 1, f)) > 0) {
+        len += got;
+        if (cap - len - 1 == 0) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+            if (!buf) exit(1);
+        }
+    }
+    buf[len] = '\0';
+
+    int err = 0;
+    const char *p = buf;
+    for (skip_space(&p); *p && !err; skip_space(&p)) {
+        const char *w = p;
+        while (isalnum((unsigned char)*p)) ++p;
+        size_t wn = (size_t)(p - w);
+
+        if (wn == 6 && strncmp(w, "RECALC", 6) == 0) {
+            if (expect_semi(&p)) { err = 1; break; }
+            int64_t r = recalc_run(rc);
+            if (r < 0)
+                fprintf(stderr, "RECALC: programa reexecutado\n");
+            else
+                fprintf(stderr, "RECALC: %lld fórmula(s) recalculada(s)\n",
+                        (long long)r);
+            continue;
+        }
+        if (wn == 5 && strncmp(w, "TABLE", 5) == 0) {
+            if (expect_semi(&p)) { err = 1; break; }
+            store_table(rc->store);
+            continue;
+        }
+
+        // CELULA = valor;
+        char *cell = ast_strndup(w, wn);
+        skip_space(&p);
+        if (wn == 0 || *p != '=') { err = 1; break; }
+        ++p;
+        skip_space(&p);
+        Value v;
+        if (*p == '"') {
+            const char *q = strchr(p + 1, '"');
+            if (!q) { err = 1; break; }
+            v = (Value){.kind = V_TEXT, .sval = ast_strndup(p + 1, q - p - 1)};
+            p = q + 1;
+        } else {
+            char *end;
+            double d = strtod(p, &end);
+            if (end == p) { err = 1; break; }
+            // inteiro lido à parte, exato; fora de 64 bits vale o double
+            int is_float = memchr(p, '.', end - p) || memchr(p, 'e', end - p);
+            char *iend;
+            errno = 0;
+            long long iv = is_float ? 0 : strtoll(p, &iend, 10);
+            v = is_float || iend != end || errno == ERANGE
+                  ? (Value){.kind = V_FLOAT, .fval = d}
+                  : (Value){.kind = V_INT,   .ival = iv};
+            p = end;
+        }
+        if (expect_semi(&p)) { err = 1; break; }
+        if (recalc_set(rc, cell, v) != 0) {
+            // o comando em si estava certo: sem "Erro de sintaxe"
+            fprintf(stderr, "Erro: célula %s fora do programa\n", cell);
+            free(buf);
+            return 1;
+        }
+    }
+    if (err && *p)
+        fprintf(stderr, "Erro de sintaxe no script de recálculo perto de: %.20s\n", p);
+    free(buf);
+    return err;
+}
@@ -0,0 +1,45 @@
+// recalc.h
+// Recálculo incremental no estilo planilha. Depois que o interpretador
+// executou o programa uma vez, cada ASSIGN de topo cuja célula só é atribuída
+// ali vira uma fórmula. As leituras registradas pela sema (Stmt.reads)
+// formam o grafo célula → fórmulas que a leem; alterar uma entrada reavalia
+// só as fórmulas alcançáveis a partir dela, em ordem topológica.
+#ifndef LANGCELL_RECALC_H
+#define LANGCELL_RECALC_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Recalc Recalc;
+
+// Requer analyze_program(program) e interpret(program) já executados
+Recalc *recalc_build(Stmt *program);
+void    recalc_free(Recalc *rc);
+
+// Fixa o valor de uma célula; se ela era uma fórmula, passa a ser entrada.
+// Retorna 0, ou -1 se a célula é inválida ou está fora do grid do programa.
+int     recalc_set(Recalc *rc, const char *cell, Value v);
+
+// Recalcula o que depende das células alteradas desde a última chamada.
+// Retorna quantas fórmulas foram reavaliadas, ou -1 se foi preciso
+// reexecutar o programa inteiro (a mudança alcança IF/WHILE, células
+// atribuídas mais de uma vez ou um ciclo).
+int64_t recalc_run(Recalc *rc);
+
+// Executa comandos de f, um por statement:
+//   A1 = 5;  B2 = 2.5;  T1 = "texto";   fixa entradas
+//   RECALC;                             recalcula
+//   TABLE;                              imprime as células
+// Retorna 0, ou 1 em caso de erro.
+int     recalc_script(Recalc *rc, FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_RECALC_H
@@ -0,0 +1,121 @@
+// runtime.c
+// Funções de runtime chamadas pelo código gerado (ver runtime.h). Ficam fora
+// do interpretador para formar, com kernels.c e pool.c, a biblioteca estática
+// liblcrt.a ligada aos executáveis gerados por --emit-exe.
+
+#include <stdio.h>
+#include <string.h>
+#include "runtime.h"
+#include "kernels.h"
+#include "stats.h"
+#include "aggpar.h"
+#include "ast.h"
+
+// Registro das funções de planilha: nome, AggFn, mínimo de argumentos,
+// indexável por rangeidx.c, último argumento é o k
+static const AggInfo AggTable[] = {
+  { "SUM",        AGG_SUM,        1, 0, 0 },
+  { "AVERAGE",    AGG_AVERAGE,    1, 0, 0 },
+  { "MIN",        AGG_MIN,        1, 1, 0 },
+  { "MAX",        AGG_MAX,        1, 1, 0 },
+  { "COUNT",      AGG_COUNT,      1, 0, 0 },
+  { "PRODUCT",    AGG_PRODUCT,    1, 0, 0 },
+  { "VAR",        AGG_VAR,        1, 0, 0 },
+  { "STDEV",      AGG_STDEV,      1, 0, 0 },
+  { "MEDIAN",     AGG_MEDIAN,     1, 0, 0 },
+  { "PERCENTILE", AGG_PERCENTILE, 2, 0, 1 },
+};
+
+const AggInfo *agg_lookup(const char *name) {
+  for (size_t i = 0; i < sizeof AggTable / sizeof AggTable[0]; ++i)
+    if (strcmp(AggTable[i].name, name) == 0) return &AggTable[i];
+  return NULL;
+}
+
+// sum_helper, avg_helper, min_helper, max_helper: um vetor só, pelo
+// agg_helper (kernels vetorizados de kernels.c, ou blocos no pool de threads
+// acima de aggpar_min() valores)
+static double vec_helper(int fn, int64_t n, const double *vals) {
+  AggArg a = { vals, n, 1, n };
+  return agg_helper(fn, 1, &a);
+}
+
+double sum_helper(int64_t n, const double *vals) { return vec_helper(AGG_SUM, n, vals); }
+double avg_helper(int64_t n, const double *vals) { return vec_helper(AGG_AVERAGE, n, vals); }
+double min_helper(int64_t n, const double *vals) { return vec_helper(AGG_MIN, n, vals); }
+double max_helper(int64_t n, const double *vals) { return vec_helper(AGG_MAX, n, vals); }
+
+// agg_helper: agrega uma lista de blocos (ranges ou escalares), coluna a
+// coluna, sem copiar as células para um vetor temporário. Blocos cujas
+// colunas são adjacentes (stride == rows) viram uma única chamada de kernel.
+// As funções estatísticas ficam em stats.c; a partir de aggpar_min()
+// valores, as que têm parcial associativo vão em blocos para o pool de
+// threads (aggpar.c), com resultado independente do número de threads.
+double agg_helper(int fn, int64_t nargs, const AggArg *args) {
+  if (aggpar_supports(fn)) {
+    int64_t total = 0;
+    for (int64_t a = 0; a < nargs; ++a)
+      if (args[a].rows > 0 && args[a].cols > 0) total += args[a].rows * args[a].cols;
+    if (total >= aggpar_min()) return aggpar_run(fn, nargs, args, total);
+  }
+  if (fn >= AGG_COUNT) return stats_agg(fn, nargs, args);
+  const AggKernels *k = kernels_best();
+  int64_t count = 0;
+  double  acc   = 0.0;
+  for (int64_t a = 0; a < nargs; ++a) {
+    const AggArg *g = &args[a];
+    int64_t rows = g->rows, cols = g->cols;
+    if (rows <= 0 || cols <= 0) continue;
+    if (cols > 1 && g->stride == rows) {
+      rows *= cols;
+      cols  = 1;
+    }
+    for (int64_t c = 0; c < cols; ++c) {
+      const double *col = g->ptr + c * g->stride;
+      switch (fn) {
+        case AGG_MIN: {
+          double v = k->min(col, rows);
+          if (count == 0 || v < acc) acc = v;
+          break;
+        }
+        case AGG_MAX: {
+          double v = k->max(col, rows);
+          if (count == 0 || v > acc) acc = v;
+          break;
+        }
+        default:
+          acc += k->sum(col, rows);
+          break;
+      }
+      count += rows;
+    }
+  }
+  if (fn == AGG_AVERAGE) return count > 0 ? acc / count : 0.0;
+  return acc;
+}
+
+
+// lc_profile_report: uma linha por statement executado, na ordem do fonte.
+// Os ciclos de IF/WHILE incluem os statements de dentro.
+void lc_profile_report(const LcProfSite *sites, int64_t n,
+                       const int64_t *counters, int64_t total_cycles) {
+  fprintf(stderr, "==== perfil ====\n");
+  fprintf(stderr, " linha    execuções      desvios%s  fonte\n",
+          total_cycles > 0 ? "           ciclos       %" : "");
+  for (int64_t i = 0; i < n; ++i) {
+    const int64_t *c = counters + 3 * i;
+    if (c[0] == 0) continue;
+    char branch[24] = "-";
+    if (sites[i].kind == STMT_IF || sites[i].kind == STMT_WHILE)
+      snprintf(branch, sizeof branch, "%lld", (long long)c[2]);
+    fprintf(stderr, "%6lld %12lld %12s", (long long)sites[i].line,
+            (long long)c[0], branch);
+    if (total_cycles > 0)
+      fprintf(stderr, " %16lld %6.1f%%", (long long)c[1],
+              100.0 * (double)c[1] / (double)total_cycles);
+    const char *src = sites[i].source ? sites[i].source : "";
+    fprintf(stderr, "  %.60s\n", src);
+  }
+  if (total_cycles > 0)
+    fprintf(stderr, "total: %lld ciclos\n", (long long)total_cycles);
+}
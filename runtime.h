@@ -0,0 +1,139 @@
+// runtime.h
+// ABI das funções de runtime chamadas pelo código gerado pelo JIT
+// (implementadas em runtime.c, csv.c, snapshot.c, pool.c e rangeidx.c;
+// ligadas em liblcrt.a).
+#ifndef LANGCELL_RUNTIME_H
+#define LANGCELL_RUNTIME_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "cells.h"
+#include "rangeidx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Versão deste ABI: sobe a cada mudança numa assinatura, struct ou enum
+// usados pelo código gerado. Entra na chave do cache de objetos do JIT, para
+// que um objeto compilado contra o ABI antigo não seja carregado.
+#define LC_RUNTIME_ABI 4
+
+// Funções de agregação suportadas por agg_helper
+typedef enum {
+    AGG_SUM,
+    AGG_AVERAGE,
+    AGG_MIN,
+    AGG_MAX,
+    AGG_COUNT,
+    AGG_PRODUCT,
+    AGG_VAR,          // variância amostral (n - 1)
+    AGG_STDEV,
+    AGG_MEDIAN,
+    AGG_PERCENTILE    // último valor é o k, em [0, 1]
+} AggFn;
+
+// Registro das funções de planilha: a sema resolve o nome de cada chamada
+// para o AggFn em Expr.call.fn
+typedef struct {
+    const char *name;
+    AggFn       fn;
+    int         min_args;
+    int         indexable;   // mantido por rangeidx.c
+    int         k_last;      // último argumento é o parâmetro k (escalar)
+} AggInfo;
+
+// Entrada de 'name', ou NULL se a função não existe
+const AggInfo *agg_lookup(const char *name);
+
+// Um argumento de agregação: bloco de rows x cols células em column-major.
+// Um range A1:C3 vira {&A1, 3, 3, nrows}; um escalar vira {&v, 1, 1, 1}.
+typedef struct {
+    const double *ptr;     // primeira célula do bloco
+    int64_t       rows;    // células contíguas por coluna
+    int64_t       cols;    // número de colunas
+    int64_t       stride;  // distância, em doubles, entre colunas
+} AggArg;
+
+double agg_helper(int fn, int64_t nargs, const AggArg *args);
+
+double sum_helper(int64_t n, const double *vals);
+double avg_helper(int64_t n, const double *vals);
+double min_helper(int64_t n, const double *vals);
+double max_helper(int64_t n, const double *vals);
+
+// Agregação repetida sobre um range grande (rangeidx.h): cada range
+// indexado tem um global RangeIndex* no módulo, que a primeira consulta
+// cria. Escritas em células cobertas chamam rindex_set e IMPORT/LOAD
+// chamam rindex_invalidate, que aceitam o índice ainda NULL.
+double lc_rindex_query(RangeIndex **ix, int fn, const double *num, int64_t slot,
+                       int64_t rows, int64_t cols, int64_t stride);
+
+// Todas as funções geradas recebem as colunas do CellStore (cells.h):
+// num, text, ival, kind e assigned.
+//
+// Modo --parallel: roda as n tarefas de um nível do escalonamento no pool
+// de threads (pool.c) e espera todas terminarem
+typedef void (*ParTaskFn)(double *num, const char **text, int64_t *ival,
+                          unsigned char *kind, unsigned char *assigned);
+void par_run(const ParTaskFn *tasks, int64_t n, double *num, const char **text,
+             int64_t *ival, unsigned char *kind, unsigned char *assigned);
+
+// IMPORT "arq.csv" AT célula (csv.c): grava os números do CSV nas células a
+// partir de (at_col, at_row). grid é o layout do programa (uma constante
+// do módulo no JIT); células fora do grid são ignoradas. Com on_cell == NULL o valor vai direto
+// para num[slot], kind[slot] passa a V_FLOAT e assigned[slot] a 1; senão
+// on_cell(ctx, slot, valor) decide o que fazer. Retorna quantas células
+// foram escritas, ou -1 se o arquivo não abriu.
+typedef void (*ImportCellFn)(void *ctx, int64_t slot, double v);
+int64_t import_csv(const char *filename, int64_t at_col, int64_t at_row,
+                   const CellLayout *grid, double *num, unsigned char *kind,
+                   unsigned char *assigned, ImportCellFn on_cell, void *ctx);
+
+// TABLE/EXPORT do JIT (csv.c): escrevem "nome<TAB>valor" (ou "nome,valor")
+// num buffer para cada slot do grid com assigned[slot] != 0, na ordem dos
+// slots: o mesmo conjunto de células que o interpretador lista (atribuídas,
+// importadas ou carregadas). O valor de uma célula V_INT sai de ival,
+// exato; o de uma V_TEXT, de text.
+void lc_table(const CellLayout *grid, const double *num,
+              const char *const *text, const int64_t *ival,
+              const unsigned char *kind, const unsigned char *assigned);
+// Destino do lc_table no thread que chama (NULL volta para stdout); o modo
+// --serve captura a tabela de cada requisição num buffer próprio
+void lc_set_table_output(FILE *f);
+// Retorna 0, ou 1 se o arquivo não pôde ser escrito
+int  lc_export(const char *filename, const CellLayout *grid, const double *num,
+               const char *const *text, const int64_t *ival,
+               const unsigned char *kind, const unsigned char *assigned);
+
+// SAVE/LOAD do JIT (snapshot.c, formato em snapshot.h). lc_save grava o
+// num[] inteiro do grid (o layout do programa) e, na tabela de células,
+// as com assigned[slot] != 0. lc_load substitui as colunas pelo conteúdo
+// do arquivo, e só as células dele ficam atribuídas. Retornam 0, ou 1 em
+// caso de erro.
+int  lc_save(const char *filename, const CellLayout *grid, const double *num,
+             const char *const *text, const int64_t *ival,
+             const unsigned char *kind, const unsigned char *assigned);
+int  lc_load(const char *filename, const CellLayout *grid, double *num,
+             const char **text, int64_t *ival, unsigned char *kind,
+             unsigned char *assigned);
+
+// --profile (codegen.cpp): um ponto por statement instrumentado, com a
+// linha e o texto do fonte. counters tem três i64 por ponto: execuções,
+// ciclos de rdtsc (0 sem --profile=cycles) e desvios (vezes que o IF foi
+// tomado, voltas do WHILE). O relatório sai em stderr; total_cycles é o
+// lc_main inteiro, ou 0.
+typedef struct {
+    int64_t     line;
+    int64_t     kind;      // StmtKind (ast.h)
+    const char *source;    // linha do fonte, ou NULL
+} LcProfSite;
+
+void lc_profile_report(const LcProfSite *sites, int64_t n,
+                       const int64_t *counters, int64_t total_cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_RUNTIME_H
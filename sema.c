@@ -1,8 +1,59 @@
 // sema.c
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "sema.h"
 #include "ast.h"
+#include "runtime.h"
+#include "snapshot.h"
+
+// Layout do grid de células do programa em análise
+static CellLayout Layout;
+
+// WHILEs em volta do statement em análise
+static int LoopDepth = 0;
+
+// Marcação de Expr.range.indexed (ver rangeidx.h)
+static int RangeIndexing = 1;
+
+void sema_set_range_index(int on) {
+    RangeIndexing = on;
+}
+
+const CellLayout *sema_layout(void) {
+    return &Layout;
+}
+
+void sema_set_layout(const CellLayout *L) {
+    layout_free(&Layout);
+    layout_copy(&Layout, L);
+}
+
+// Resolve o nome de uma célula para seu slot no grid (-1 se inválido)
+static int64_t resolve_slot(const char *name) {
+    int64_t col, row;
+    if (cell_parse(name, &col, &row) != 0) {
+        fprintf(stderr, "Erro semântico: célula inválida %s\n", name);
+        return -1;
+    }
+    return layout_slot(&Layout, col, row);
+}
+
+static int resolve_range(Expr *e) {
+    int64_t sc, sr, ec, er;
+    if (cell_parse(e->range.start_cell, &sc, &sr) != 0 ||
+        cell_parse(e->range.end_cell,   &ec, &er) != 0) {
+        fprintf(stderr, "Erro semântico: range inválido %s:%s\n",
+                e->range.start_cell, e->range.end_cell);
+        return -1;
+    }
+    if (ec < sc) { int64_t t = sc; sc = ec; ec = t; }
+    if (er < sr) { int64_t t = sr; sr = er; er = t; }
+    e->range.slot = layout_slot(&Layout, sc, sr);
+    e->range.rows = er - sr + 1;
+    e->range.cols = ec - sc + 1;
+    return 0;
+}
 
 static Type promote(Type a, Type b) {
     if (a==TYPE_ERROR || b==TYPE_ERROR) return TYPE_ERROR;
@@ -11,13 +62,22 @@ static Type promote(Type a, Type b) {
     return TYPE_INT;
 }
 
+static Type type_expr(Expr *e);
+
+// Tipo estático de e, guardado também em e->type (e nas subexpressões)
 Type analyze_expr(Expr *e) {
     if (!e) return TYPE_ERROR;
+    return e->type = type_expr(e);
+}
+
+static Type type_expr(Expr *e) {
     switch (e->kind) {
       case EXPR_INT:   return TYPE_INT;
       case EXPR_FLOAT: return TYPE_FLOAT;
       case EXPR_TEXT:  return TYPE_TEXT;
-      case EXPR_CELL:  return TYPE_FLOAT;
+      case EXPR_CELL:
+        e->slot = resolve_slot(e->sval);
+        return e->slot < 0 ? TYPE_ERROR : TYPE_FLOAT;
       case EXPR_UNARY: {
         Type t = analyze_expr(e->un.sub);
         if (e->un.op==OP_NOT) {
@@ -44,6 +104,9 @@ Type analyze_expr(Expr *e) {
                 fprintf(stderr, "Erro semântico: aritmética só para numéricos\n");
                 return TYPE_ERROR;
             }
+            // a divisão é sempre em ponto flutuante: 7 / 2 vale 3.5
+            if (e->bin.op==OP_DIV && promote(l,r)==TYPE_INT)
+                return TYPE_FLOAT;
             return promote(l,r);
           case OP_GT: case OP_LT:
           case OP_GE: case OP_LE:
@@ -63,11 +126,17 @@ Type analyze_expr(Expr *e) {
         break;
       }
       case EXPR_CALL: {
+        const AggInfo *info = agg_lookup(e->call.fname);
+        if (!info) {
+          fprintf(stderr, "Erro semântico: função desconhecida %s\n", e->call.fname);
+          return TYPE_ERROR;
+        }
+        e->call.fn = info->fn;
         Expr *arg = e->call.args;
         int cnt = 0; Type acc = TYPE_ERROR;
         while (arg) {
           Type t = (arg->kind==EXPR_RANGE
-                    ? TYPE_FLOAT
+                    ? (resolve_range(arg) < 0 ? TYPE_ERROR : TYPE_FLOAT)
                     : analyze_expr(arg));
           if (t==TYPE_ERROR) return TYPE_ERROR;
           acc = (cnt==0? t : promote(acc,t));
@@ -77,14 +146,29 @@ Type analyze_expr(Expr *e) {
           fprintf(stderr, "Erro semântico: %s sem argumentos\n", e->call.fname);
           return TYPE_ERROR;
         }
-        if (strcmp(e->call.fname,"AVERAGE")==0)
-            return TYPE_FLOAT;
-        if (!strcmp(e->call.fname,"SUM") ||
-            !strcmp(e->call.fname,"MIN") ||
-            !strcmp(e->call.fname,"MAX"))
-            return acc;
-        fprintf(stderr, "Erro semântico: função desconhecida %s\n", e->call.fname);
-        return TYPE_ERROR;
+        if (cnt < info->min_args) {
+          fprintf(stderr, "Erro semântico: %s precisa de %d argumentos\n",
+                  e->call.fname, info->min_args);
+          return TYPE_ERROR;
+        }
+        if (info->k_last) {
+          for (arg = e->call.args; arg->next; arg = arg->next) ;
+          if (arg->kind==EXPR_RANGE) {
+            fprintf(stderr, "Erro semântico: o último argumento de %s é um número, "
+                            "não um range\n", e->call.fname);
+            return TYPE_ERROR;
+          }
+        }
+        // SUM(A1:A50000) dentro de um WHILE: consultas repetidas, o range
+        // ganha um RangeIndex
+        arg = e->call.args;
+        if (RangeIndexing && info->indexable && cnt==1 && arg->kind==EXPR_RANGE &&
+            LoopDepth>0 && arg->range.rows * arg->range.cols >= RINDEX_MIN_CELLS)
+            arg->range.indexed = 1;
+        if (acc==TYPE_TEXT &&
+            (info->fn==AGG_SUM || info->fn==AGG_MIN || info->fn==AGG_MAX))
+            return TYPE_TEXT;
+        return TYPE_FLOAT;   // agg_helper devolve double
       }
       case EXPR_RANGE:
         fprintf(stderr, "Erro semântico: range isolado\n");
@@ -93,12 +177,69 @@ Type analyze_expr(Expr *e) {
     return TYPE_ERROR;
 }
 
+// ——— dependências ————————————————————————————————————————————————————————
+// Cada statement guarda os nós EXPR_CELL/EXPR_RANGE que sua expressão lê,
+// usados pelo recálculo incremental (recalc.c) para montar o grafo
+
+static int64_t count_reads(const Expr *e) {
+    switch (e->kind) {
+      case EXPR_CELL:
+      case EXPR_RANGE:
+        return 1;
+      case EXPR_UNARY:
+        return count_reads(e->un.sub);
+      case EXPR_BINARY:
+        return count_reads(e->bin.left) + count_reads(e->bin.right);
+      case EXPR_CALL: {
+        int64_t n = 0;
+        for (const Expr *a = e->call.args; a; a = a->next) n += count_reads(a);
+        return n;
+      }
+      default:
+        return 0;
+    }
+}
+
+static void collect_reads(Expr *e, Expr **out, int64_t *k) {
+    switch (e->kind) {
+      case EXPR_CELL:
+      case EXPR_RANGE:
+        out[(*k)++] = e;
+        break;
+      case EXPR_UNARY:
+        collect_reads(e->un.sub, out, k);
+        break;
+      case EXPR_BINARY:
+        collect_reads(e->bin.left, out, k);
+        collect_reads(e->bin.right, out, k);
+        break;
+      case EXPR_CALL:
+        for (Expr *a = e->call.args; a; a = a->next) collect_reads(a, out, k);
+        break;
+      default:
+        break;
+    }
+}
+
+static void record_reads(Stmt *s, Expr *e) {
+    s->n_reads = count_reads(e);
+    if (s->n_reads == 0) return;
+    s->reads = ast_alloc(s->n_reads * sizeof *s->reads);
+    int64_t k = 0;
+    collect_reads(e, s->reads, &k);
+}
+
 int analyze_stmt_list(Stmt *s) {
     int errs = 0;
     for (; s; s = s->next) {
       switch (s->kind) {
         case STMT_ASSIGN:
-          if (analyze_expr(s->assign.expr)==TYPE_ERROR) errs++;
+          s->assign.slot = resolve_slot(s->assign.cell);
+          if (s->assign.slot < 0) errs++;
+          s->assign.type = analyze_expr(s->assign.expr)==TYPE_TEXT ? TYPE_TEXT
+                                                                    : TYPE_FLOAT;
+          if (s->assign.expr->type==TYPE_ERROR) errs++;
+          record_reads(s, s->assign.expr);
           break;
         case STMT_IF: {
           Type t = analyze_expr(s->ifs.cond);
@@ -106,22 +247,173 @@ int analyze_stmt_list(Stmt *s) {
             fprintf(stderr, "Erro semântico: IF precisa de numérico\n");
             errs++;
           }
+          record_reads(s, s->ifs.cond);
           errs += analyze_stmt_list(s->ifs.then_branch);
           break;
         }
         case STMT_WHILE: {
+          LoopDepth++;
           Type t = analyze_expr(s->whiles.cond);
           if (t==TYPE_ERROR||t==TYPE_TEXT) {
             fprintf(stderr, "Erro semântico: WHILE precisa de numérico\n");
             errs++;
           }
+          record_reads(s, s->whiles.cond);
           errs += analyze_stmt_list(s->whiles.body);
+          LoopDepth--;
           break;
         }
+        case STMT_IMPORT:
+          if (cell_parse(s->imp.cell, &s->imp.col, &s->imp.row) != 0) {
+            fprintf(stderr, "Erro semântico: célula inválida %s\n", s->imp.cell);
+            errs++;
+          }
+          break;
         case STMT_TABLE:
         case STMT_EXPORT:
+        case STMT_SAVE:
+        case STMT_LOAD:
           break;
       }
     }
     return errs;
 }
+
+// ——— células inteiras ————————————————————————————————————————————————————
+// Uma célula é TYPE_INT quando todas as atribuições a ela, em qualquer ponto
+// do programa (dentro de IF e WHILE inclusive), têm valor inteiro; o JIT
+// então faz a aritmética dela em i64. O ponto de partida é otimista (toda
+// célula com atribuição numérica é inteira) e cada passada rebaixa as que
+// recebem uma expressão FLOAT, até um ponto fixo: num laço com A1 = B1 e
+// B1 = B1 + 0.5, B1 cai na primeira passada e A1 na seguinte. Ficam de fora
+// as células sem atribuição e as de texto. IMPORT e LOAD não rebaixam
+// ninguém: o valor V_FLOAT que gravam numa célula inteira é visto pelo
+// ValueKind em tempo de execução (o JIT cai no caminho em double).
+
+static int            IntInference = 1;
+static unsigned char *IntCell;          // por slot: 1 se a célula é inteira
+
+void sema_set_int_inference(int on) {
+    IntInference = on;
+}
+
+// Tipo de e com os tipos atuais das células; regrava e->type nos nós que
+// dependem deles (o resto já veio de analyze_expr)
+static Type infer_expr(Expr *e) {
+    switch (e->kind) {
+      case EXPR_CELL:
+        e->type = IntCell[e->slot] ? TYPE_INT : TYPE_FLOAT;
+        break;
+      case EXPR_UNARY: {
+        Type t = infer_expr(e->un.sub);
+        if (e->un.op==OP_NEG) e->type = t;
+        break;
+      }
+      case EXPR_BINARY: {
+        Type l = infer_expr(e->bin.left);
+        Type r = infer_expr(e->bin.right);
+        if (e->bin.op==OP_ADD || e->bin.op==OP_SUB || e->bin.op==OP_MUL)
+            e->type = l==TYPE_INT && r==TYPE_INT ? TYPE_INT : TYPE_FLOAT;
+        break;
+      }
+      case EXPR_CALL:
+        for (Expr *a = e->call.args; a; a = a->next)
+            if (a->kind != EXPR_RANGE) infer_expr(a);
+        break;
+      default:
+        break;
+    }
+    return e->type;
+}
+
+// Uma passada: anota as expressões e rebaixa as células que recebem valor
+// FLOAT. Retorna 1 se alguma célula mudou.
+static int infer_stmts(Stmt *s) {
+    int changed = 0;
+    for (; s; s = s->next) {
+      switch (s->kind) {
+        case STMT_ASSIGN:
+          if (infer_expr(s->assign.expr) != TYPE_INT && IntCell[s->assign.slot]) {
+              IntCell[s->assign.slot] = 0;
+              changed = 1;
+          }
+          if (s->assign.type != TYPE_TEXT)
+              s->assign.type = IntCell[s->assign.slot] ? TYPE_INT : TYPE_FLOAT;
+          break;
+        case STMT_IF:
+          infer_expr(s->ifs.cond);
+          changed |= infer_stmts(s->ifs.then_branch);
+          break;
+        case STMT_WHILE:
+          infer_expr(s->whiles.cond);
+          changed |= infer_stmts(s->whiles.body);
+          break;
+        default:
+          break;
+      }
+    }
+    return changed;
+}
+
+// Candidatas iniciais: 1 nas células com atribuição numérica, 2 (nunca
+// inteira) nas de texto
+static void mark_cells(Stmt *s) {
+    for (; s; s = s->next) {
+      switch (s->kind) {
+        case STMT_ASSIGN:
+          if (s->assign.type == TYPE_TEXT)  IntCell[s->assign.slot] = 2;
+          else if (!IntCell[s->assign.slot]) IntCell[s->assign.slot] = 1;
+          break;
+        case STMT_IF:    mark_cells(s->ifs.then_branch); break;
+        case STMT_WHILE: mark_cells(s->whiles.body);     break;
+        default:
+          break;
+      }
+    }
+}
+
+static void infer_int_cells(Stmt *program) {
+    int64_t n = layout_ncells(&Layout);
+    IntCell = calloc(n > 0 ? n : 1, 1);
+    if (!IntCell) exit(1);
+    mark_cells(program);
+    for (int64_t i = 0; i < n; ++i) IntCell[i] = IntCell[i] == 1;
+    while (infer_stmts(program))
+        ;
+    free(IntCell);
+    IntCell = NULL;
+}
+
+// LOAD troca as células pelas do arquivo: o grid cobre também o layout
+// dos snapshots que já existem na análise, para nenhuma célula carregada
+// ficar de fora (um arquivo gravado depois, com células fora do grid, faz
+// o LOAD falhar; ver snapshot_load). Retorna -1 se o grid não cabe.
+static int add_load_extents(Stmt *s) {
+    for (; s; s = s->next) {
+        int rc = 0;
+        if (s->kind == STMT_IF)    rc = add_load_extents(s->ifs.then_branch);
+        if (s->kind == STMT_WHILE) rc = add_load_extents(s->whiles.body);
+        if (rc < 0) return -1;
+        CellLayout F, out;
+        if (s->kind != STMT_LOAD || snapshot_layout(s->exp.filename, &F) != 0)
+            continue;
+        rc = layout_cover(&out, &Layout, NULL, &F);
+        layout_free(&F);
+        if (rc < 0) return -1;
+        layout_free(&Layout);
+        Layout = out;
+    }
+    return 0;
+}
+
+int analyze_program(Stmt *program) {
+    layout_free(&Layout);
+    layout_add_program(&Layout, program);
+    if (layout_compact(&Layout, program) < 0 || add_load_extents(program) < 0) {
+        fprintf(stderr, "Erro semântico: grid grande demais\n");
+        return 1;
+    }
+    int errs = analyze_stmt_list(program);
+    if (errs == 0 && IntInference) infer_int_cells(program);
+    return errs;
+}
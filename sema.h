@@ -2,6 +2,7 @@
 #define LANGCELL_SEMA_H
 
 #include "ast.h"
+#include "cells.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -11,6 +12,30 @@ extern "C" {
 Type analyze_expr(Expr *e);
 int  analyze_stmt_list(Stmt *stmts);
 
+// Análise do programa inteiro: calcula o layout do grid de células e
+// resolve cada EXPR_CELL, EXPR_RANGE e destino de atribuição para um slot.
+// Retorna o número de erros (um grid que não cabe em LAYOUT_MAX_CELLS é um).
+int  analyze_program(Stmt *program);
+
+// Inferência de células inteiras no analyze_program (ligada por padrão):
+// células cujas atribuições são todas inteiras ficam com TYPE_INT em
+// Stmt.assign.type e nos EXPR_CELL que as leem. Desligar quando as células
+// podem receber valores de fora do programa (entradas do --serve).
+void sema_set_int_inference(int on);
+
+// Índice dos ranges agregados dentro de WHILE (ligado por padrão): a árvore
+// de um range é única por programa, então desligar quando o mesmo código
+// roda em várias threads ao mesmo tempo (--serve)
+void sema_set_range_index(int on);
+
+// Layout calculado pelo último analyze_program; as faixas de um layout
+// compactado só valem até o próximo (quem guarda o layout usa layout_copy)
+const CellLayout *sema_layout(void);
+
+// Modo streaming: fixa o layout usado pelo próximo analyze_stmt_list, que
+// então resolve os slots de um statement isolado
+void sema_set_layout(const CellLayout *L);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,465 @@
+// server.cpp
+// langcell --serve (ver server.h). O parser, a sema e o codegen usam estado
+// global, então compilar é serializado por CompileLock; já o código gerado
+// só toca nos arrays que recebe, e cada worker roda as planilhas sobre os
+// próprios arrays, sem trava. Com o ORC, o módulo de uma planilha é
+// compilado no worker que a roda primeiro, no LLVMContext próprio da
+// planilha (ver jit_compile_sheet), fora do CompileLock.
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "server.h"
+#include "ast.h"
+#include "sema.h"
+#include "cells.h"
+#include "codegen.h"
+#include "runtime.h"
+
+extern "C" FILE *yyin;
+extern "C" int   yylineno;
+extern "C" int   yyparse(void);
+extern "C" void  yyrestart(FILE *f);
+extern Stmt *program_root;
+
+static std::mutex CompileLock;    // yyparse, sema e codegen
+static unsigned   NextSheet = 0;  // nome dos símbolos de cada módulo
+
+// Uma planilha compilada: módulo no JIT e grid das células. O módulo
+// sai do motor quando a última referência cai: a planilha foi substituída
+// (ou o script saiu do cache) e nenhum RUN em curso ainda a usa. Nunca
+// soltar a última referência com o RegistryLock ou o CompileLock na mão.
+struct Sheet {
+    JitSheet  *jit = nullptr;
+    CellLayout layout;    // cópia própria (layout_copy)
+    int64_t    ncells;
+    ~Sheet() {
+        if (jit) {
+            std::lock_guard<std::mutex> lock(CompileLock);
+            jit_release_sheet(jit);
+        }
+        layout_free(&layout);
+    }
+};
+typedef std::shared_ptr<const Sheet> SheetPtr;
+
+// Planilhas registradas por SHEET e scripts de EVAL, pelo texto do fonte.
+// Os scripts formam um LRU (o mais recente na frente de ScriptOrder); além
+// de MaxScripts, o menos usado sai do cache.
+static const size_t MaxScripts = 256;
+struct Script {
+    SheetPtr                                  sheet;
+    std::list<const std::string *>::iterator  pos;   // em ScriptOrder
+};
+static std::mutex                              RegistryLock;
+static std::map<std::string, SheetPtr>         Sheets;
+static std::unordered_map<std::string, Script> Scripts;
+static std::list<const std::string *>          ScriptOrder;   // chaves de Scripts
+
+static double micros_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+// EXPORT/IMPORT/SAVE/LOAD em qualquer nível do programa
+static bool uses_files(const Stmt *s) {
+    for (; s; s = s->next) {
+        switch (s->kind) {
+          case STMT_EXPORT: case STMT_IMPORT: case STMT_SAVE: case STMT_LOAD:
+            return true;
+          case STMT_IF:
+            if (uses_files(s->ifs.then_branch)) return true;
+            break;
+          case STMT_WHILE:
+            if (uses_files(s->whiles.body)) return true;
+            break;
+          default:
+            break;
+        }
+    }
+    return false;
+}
+
+// Parse, sema e JIT de 'src'; a AST é descartada logo depois, o módulo
+// gerado fica no motor. Em caso de erro retorna nulo e preenche 'err'.
+static SheetPtr compile_sheet(const std::string &src, std::string &err) {
+    std::lock_guard<std::mutex> lock(CompileLock);
+    FILE *f = src.empty() ? nullptr
+                          : fmemopen(const_cast<char *>(src.data()), src.size(), "r");
+    if (!f) {
+        err = "programa vazio";
+        return nullptr;
+    }
+    yyin = f;
+    yyrestart(f);
+    yylineno     = 1;
+    program_root = nullptr;
+    int bad = yyparse();
+    std::fclose(f);
+    yyin = nullptr;
+
+    std::shared_ptr<Sheet> s;
+    if (bad)
+        err = "erro de sintaxe";
+    else if (analyze_program(program_root) > 0)
+        err = "erro semântico";
+    else if (uses_files(program_root))
+        err = "EXPORT/IMPORT/SAVE/LOAD não são aceitos no --serve";
+    else {
+        s = std::make_shared<Sheet>();
+        layout_copy(&s->layout, sema_layout());
+        s->ncells = layout_ncells(&s->layout);
+        std::string name = "lc_sheet" + std::to_string(NextSheet++);
+        s->jit = jit_compile_sheet(program_root, name.c_str());
+        if (!s->jit) {
+            err = "falha ao compilar";
+            s.reset();
+        }
+    }
+    ast_release();
+    return s;
+}
+
+// ——— respostas ———————————————————————————————————————————————————————————
+static void json_string(std::string &out, const char *s, size_t n) {
+    out += '"';
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)s[i];
+        switch (c) {
+          case '"':  out += "\\\""; break;
+          case '\\': out += "\\\\"; break;
+          case '\n': out += "\\n";  break;
+          case '\t': out += "\\t";  break;
+          case '\r': out += "\\r";  break;
+          default:
+            if (c < 0x20) {
+                char esc[8];
+                std::snprintf(esc, sizeof esc, "\\u%04x", c);
+                out += esc;
+            } else {
+                out += (char)c;
+            }
+        }
+    }
+    out += '"';
+}
+
+static std::string reply_error(const std::string &msg) {
+    std::string r = "{\"ok\":false,\"error\":";
+    json_string(r, msg.data(), msg.size());
+    return r + "}\n";
+}
+
+// ——— execução ————————————————————————————————————————————————————————————
+// Arrays de células de cada worker, reaproveitados entre as requisições
+static thread_local std::vector<double>        Num;
+static thread_local std::vector<const char *>  Text;
+static thread_local std::vector<int64_t>       Ival;
+static thread_local std::vector<unsigned char> Kind;
+static thread_local std::vector<unsigned char> Assigned;
+
+// Roda a planilha com as entradas "CÉLULA=número" de 'inputs' e devolve o
+// TABLE final, capturado num buffer em memória
+static std::string run_sheet(const Sheet &s, const std::vector<std::string> &inputs) {
+    size_t n = s.ncells > 0 ? (size_t)s.ncells : 1;
+    Num.assign(n, 0.0);
+    Text.assign(n, nullptr);
+    Ival.assign(n, 0);
+    Kind.assign(n, V_INT);
+    Assigned.assign(n, 0);
+
+    for (const std::string &in : inputs) {
+        size_t eq = in.find('=');
+        int64_t col, row;
+        if (eq == std::string::npos ||
+            cell_parse(in.substr(0, eq).c_str(), &col, &row) != 0)
+            return reply_error("entrada inválida: " + in);
+        int64_t slot = layout_find(&s.layout, col, row);
+        if (slot < 0)
+            return reply_error("célula fora da planilha: " + in.substr(0, eq));
+        const char *v = in.c_str() + eq + 1;
+        char *end;
+        double x = std::strtod(v, &end);
+        if (end == v || *end)
+            return reply_error("valor inválido: " + in);
+        Num[(size_t)slot]      = x;
+        Kind[(size_t)slot]     = V_FLOAT;
+        Assigned[(size_t)slot] = 1;
+    }
+
+    char  *buf = nullptr;
+    size_t len = 0;
+    FILE *out = open_memstream(&buf, &len);
+    if (!out) return reply_error("sem memória");
+    SheetFn fn = jit_sheet_entry(s.jit);
+    lc_set_table_output(out);
+    auto t0 = std::chrono::steady_clock::now();
+    fn(Num.data(), Text.data(), Ival.data(), Kind.data(), Assigned.data());
+    double us = micros_since(t0);
+    lc_set_table_output(nullptr);
+    std::fclose(out);
+
+    char head[64];
+    std::snprintf(head, sizeof head, "{\"ok\":true,\"us\":%.1f,\"table\":", us);
+    std::string r = head;
+    json_string(r, buf, len);
+    std::free(buf);
+    return r + "}\n";
+}
+
+// ——— requisições —————————————————————————————————————————————————————————
+// Tamanho do corpo de SHEET/EVAL; -1 se não for um número
+static long body_size(const std::string &count) {
+    char *end;
+    long n = std::strtol(count.c_str(), &end, 10);
+    return end == count.c_str() || *end || n < 0 ? -1 : n;
+}
+
+static std::string handle_request(const std::vector<std::string> &w,
+                                  const std::string &body) {
+    if (w[0] == "SHEET") {
+        std::string err;
+        auto t0 = std::chrono::steady_clock::now();
+        SheetPtr s = compile_sheet(body, err);
+        if (!s) return reply_error(err);
+        double us = micros_since(t0);
+        SheetPtr old;   // a versão anterior sai do motor fora da trava
+        {
+            std::lock_guard<std::mutex> lock(RegistryLock);
+            old = std::move(Sheets[w[1]]);
+            Sheets[w[1]] = s;
+        }
+        std::string r = "{\"ok\":true,\"id\":";
+        json_string(r, w[1].data(), w[1].size());
+        char tail[48];
+        std::snprintf(tail, sizeof tail, ",\"compile_us\":%.1f}\n", us);
+        return r + tail;
+    }
+
+    if (w[0] == "RUN") {
+        SheetPtr s;
+        {
+            std::lock_guard<std::mutex> lock(RegistryLock);
+            auto it = Sheets.find(w[1]);
+            if (it != Sheets.end()) s = it->second;
+        }
+        if (!s) return reply_error("planilha desconhecida: " + w[1]);
+        return run_sheet(*s, std::vector<std::string>(w.begin() + 2, w.end()));
+    }
+
+    // EVAL
+    SheetPtr s, evicted;   // o script que sai do cache é liberado fora da trava
+    {
+        std::lock_guard<std::mutex> lock(RegistryLock);
+        auto it = Scripts.find(body);
+        if (it != Scripts.end()) {
+            s = it->second.sheet;
+            ScriptOrder.splice(ScriptOrder.begin(), ScriptOrder, it->second.pos);
+        }
+    }
+    if (!s) {
+        std::string err;
+        if (!(s = compile_sheet(body, err))) return reply_error(err);
+        std::lock_guard<std::mutex> lock(RegistryLock);
+        auto ins = Scripts.emplace(body, Script{ s, ScriptOrder.end() });
+        if (ins.second) {   // senão outro worker compilou o mesmo script antes
+            ScriptOrder.push_front(&ins.first->first);
+            ins.first->second.pos = ScriptOrder.begin();
+            if (Scripts.size() > MaxScripts) {
+                auto last = Scripts.find(*ScriptOrder.back());
+                ScriptOrder.pop_back();
+                evicted = std::move(last->second.sheet);
+                Scripts.erase(last);
+            }
+        }
+    }
+    return run_sheet(*s, {});
+}
+
+// Uma conexão: bytes recebidos ainda não consumidos por uma requisição
+struct Conn {
+    int         fd;
+    std::string in;
+};
+
+// Tira de c.in a próxima requisição completa (linha e, em SHEET/EVAL, o
+// corpo inteiro) e devolve a resposta em 'reply'. Retorna false se ainda
+// faltam bytes.
+static bool next_request(Conn &c, std::string &reply) {
+    size_t nl = c.in.find('\n');
+    if (nl == std::string::npos) return false;
+    std::vector<std::string> w;
+    for (size_t i = 0; i < nl; ) {
+        size_t j = c.in.find_first_of(" \t\r\n", i);
+        if (j > nl) j = nl;
+        if (j > i) w.push_back(c.in.substr(i, j - i));
+        i = j + 1;
+    }
+
+    long n = 0;
+    bool ok = !w.empty() &&
+              ((w[0] == "SHEET" && w.size() == 3 && (n = body_size(w[2])) >= 0) ||
+               (w[0] == "EVAL"  && w.size() == 2 && (n = body_size(w[1])) >= 0) ||
+               (w[0] == "RUN"   && w.size() >= 2));
+    if (!ok) {
+        reply = reply_error(w.empty() ? "requisição vazia"
+                                      : "requisição inválida: " + w[0]);
+        c.in.erase(0, nl + 1);
+        return true;
+    }
+    if (c.in.size() - (nl + 1) < (size_t)n) return false;
+
+    std::string body = c.in.substr(nl + 1, (size_t)n);
+    c.in.erase(0, nl + 1 + (size_t)n);
+    reply = handle_request(w, body);
+    return true;
+}
+
+static void write_all(int fd, const std::string &s) {
+    for (size_t off = 0; off < s.size(); ) {
+        ssize_t k = write(fd, s.data() + off, s.size() - off);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return;   // cliente saiu; o próximo read vê o fim
+        off += (size_t)k;
+    }
+}
+
+// ——— socket e workers ————————————————————————————————————————————————————
+// O thread principal espera com poll() no socket de escuta e nas conexões
+// ociosas; uma conexão com dados vai para a fila e um worker lê, responde as
+// requisições completas e a devolve ao poll (pelo pipe Wake). Conexões
+// ociosas não prendem workers.
+static std::mutex              QueueLock;
+static std::condition_variable QueueReady;
+static std::deque<Conn *>      Ready;      // com dados, esperando um worker
+static std::vector<Conn *>     Returned;   // atendidas, de volta para o poll
+static int                     Wake[2];
+
+static void worker_loop() {
+    char buf[65536];
+    for (;;) {
+        Conn *c;
+        {
+            std::unique_lock<std::mutex> lock(QueueLock);
+            QueueReady.wait(lock, [] { return !Ready.empty(); });
+            c = Ready.front();
+            Ready.pop_front();
+        }
+        ssize_t k;
+        do k = read(c->fd, buf, sizeof buf); while (k < 0 && errno == EINTR);
+        if (k <= 0) {
+            close(c->fd);
+            delete c;
+            continue;
+        }
+        c->in.append(buf, (size_t)k);
+        std::string reply;
+        while (next_request(*c, reply)) write_all(c->fd, reply);
+
+        std::lock_guard<std::mutex> lock(QueueLock);
+        Returned.push_back(c);
+        char b = 0;
+        if (write(Wake[1], &b, 1) < 0) { /* pipe cheio: o poll já vai acordar */ }
+    }
+}
+
+static char SocketPath[sizeof(((sockaddr_un *)nullptr)->sun_path)];
+
+static void on_signal(int) {
+    unlink(SocketPath);
+    _exit(0);
+}
+
+int serve(const char *path, unsigned workers) {
+    if (std::strlen(path) >= sizeof SocketPath) {
+        std::fprintf(stderr, "%s: caminho longo demais para um socket\n", path);
+        return 1;
+    }
+    std::strcpy(SocketPath, path);
+
+    int ls = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path);
+    unlink(path);
+    if (ls < 0 || bind(ls, (sockaddr *)&addr, sizeof addr) != 0 ||
+        listen(ls, 64) != 0 || pipe(Wake) != 0) {
+        std::perror(path);
+        return 1;
+    }
+    fcntl(Wake[1], F_SETFL, O_NONBLOCK);
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    // o LLVM sobe uma vez só, antes da primeira requisição; as entradas do
+    // RUN podem ser fracionárias, então nenhuma célula é compilada como i64;
+    // workers rodam a mesma planilha juntos, então nenhum range é indexado
+    sema_set_int_inference(0);
+    sema_set_range_index(0);
+    init_llvm("LangCellModule");
+
+    if (workers == 0) workers = std::thread::hardware_concurrency();
+    if (workers == 0) workers = 1;
+    for (unsigned i = 0; i < workers; ++i) std::thread(worker_loop).detach();
+    std::fprintf(stderr, "langcell: servindo em %s (%u workers)\n", path, workers);
+
+    std::vector<Conn *> idle;
+    std::vector<pollfd> fds;
+    for (;;) {
+        fds.assign({ { ls, POLLIN, 0 }, { Wake[0], POLLIN, 0 } });
+        for (Conn *c : idle) fds.push_back({ c->fd, POLLIN, 0 });
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            std::perror("poll");
+            unlink(path);
+            return 1;
+        }
+
+        // conexões com dados (ou fechadas) vão para os workers
+        std::vector<Conn *> still;
+        {
+            std::lock_guard<std::mutex> lock(QueueLock);
+            for (size_t i = 0; i < idle.size(); ++i) {
+                if (fds[i + 2].revents) {
+                    Ready.push_back(idle[i]);
+                    QueueReady.notify_one();
+                } else {
+                    still.push_back(idle[i]);
+                }
+            }
+            if (fds[1].revents) {
+                char b[256];
+                if (read(Wake[0], b, sizeof b) < 0) { /* nada a drenar */ }
+                still.insert(still.end(), Returned.begin(), Returned.end());
+                Returned.clear();
+            }
+        }
+        idle.swap(still);
+
+        if (fds[0].revents) {
+            int fd = accept(ls, nullptr, nullptr);
+            if (fd >= 0) idle.push_back(new Conn{ fd, std::string() });
+            else if (errno != EINTR && errno != ECONNABORTED) std::perror("accept");
+        }
+    }
+}
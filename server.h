@@ -0,0 +1,37 @@
+// server.h
+// langcell --serve: processo residente que compila e roda planilhas
+// recebidas por um socket Unix local. LLVM, motor do JIT e código das
+// planilhas já compiladas ficam na memória entre as requisições, então rodar
+// uma planilha em cache custa só a execução do código gerado.
+//
+// Protocolo: cada requisição recebe uma linha JSON de resposta, na ordem
+// em que as requisições chegaram na conexão.
+//
+//   SHEET <id> <n>\n<n bytes de fonte>   compila e registra (ou substitui)
+//                                        a planilha <id>; o código da versão
+//                                        anterior sai do JIT quando os RUN
+//                                        em curso dela terminam
+//   RUN <id> [CÉLULA=número ...]\n       roda a planilha <id>; as entradas
+//                                        são escritas nas células antes do
+//                                        programa, que pode sobrescrevê-las
+//   EVAL <n>\n<n bytes de fonte>         roda um script avulso; o código fica
+//                                        em cache pelo texto do fonte (os
+//                                        256 usados mais recentemente)
+//
+//   {"ok":true,"id":"x","compile_us":812.4}          (SHEET)
+//   {"ok":true,"us":3.1,"table":"A1\t3\nB1\t4\n"}    (RUN, EVAL: o TABLE final)
+//   {"ok":false,"error":"..."}
+//
+// As células de entrada precisam estar no grid da planilha (citadas pelo
+// programa, diretamente ou num range). Programas com EXPORT/IMPORT/SAVE/LOAD
+// são recusados: no servidor o estado entra e sai pelas requisições.
+#ifndef LANGCELL_SERVER_H
+#define LANGCELL_SERVER_H
+
+// Escuta em 'path' (substituindo um socket antigo) e atende as requisições
+// em 'workers' threads (0: uma por núcleo); conexões ociosas não ocupam
+// workers. Chamar depois de set_jit_options/set_opt_level. Só retorna em
+// caso de erro (1); SIGINT/SIGTERM removem o socket e encerram o processo.
+int serve(const char *path, unsigned workers);
+
+#endif // LANGCELL_SERVER_H
@@ -0,0 +1,317 @@
+// snapshot.c
+// SAVE/LOAD (ver snapshot.h). A gravação é sequencial pelo OutBuf de csv.h;
+// a leitura mapeia o arquivo, valida o cabeçalho e copia a coluna numérica
+// para o grid, sem passar por texto.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "snapshot.h"
+#include "runtime.h"
+#include "cells.h"
+#include "csv.h"
+
+#define ALIGN64(x) (((x) + 63) & ~(uint64_t)63)
+
+int snapshot_save(const char *filename, const CellLayout *grid, const double *num,
+                  const int64_t *ival, const char *const *text,
+                  const SnapCell *cells, int64_t n) {
+    int64_t nslots = layout_ncells(grid);
+    int64_t ncs = grid->colspan ? grid->ncolspan : 0;
+    int64_t nrs = grid->rowspan ? grid->nrowspan : 0;
+
+    LcsHeader h;
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, LCS_MAGIC, sizeof h.magic);
+    h.version   = LCS_VERSION;
+    h.endian    = LCS_ENDIAN;
+    h.col0      = grid->col0;
+    h.row0      = grid->row0;
+    h.ncols     = grid->ncols;
+    h.nrows     = grid->nrows;
+    h.ncolspan  = ncs;
+    h.nrowspan  = nrs;
+    h.ncells    = n;
+    h.span_off  = sizeof h;
+    h.cells_off = h.span_off + (uint64_t)(ncs + nrs) * sizeof(LayoutSpan);
+    h.num_off   = ALIGN64(h.cells_off + (uint64_t)n * sizeof(LcsCell));
+    h.text_off  = h.num_off + (uint64_t)nslots * sizeof(double);
+    for (int64_t i = 0; i < n; ++i)
+        if (cells[i].kind == V_TEXT)
+            h.text_size += (text[cells[i].slot] ? strlen(text[cells[i].slot]) : 0) + 1;
+    h.file_size = h.text_off + h.text_size;
+
+    FILE *f = fopen(filename, "wb");
+    if (!f) {
+        perror(filename);
+        return 1;
+    }
+    OutBuf o;
+    out_open(&o, f);
+    out_bytes(&o, (const char *)&h, sizeof h);
+    if (ncs) out_bytes(&o, (const char *)grid->colspan, (size_t)ncs * sizeof(LayoutSpan));
+    if (nrs) out_bytes(&o, (const char *)grid->rowspan, (size_t)nrs * sizeof(LayoutSpan));
+
+    for (int64_t i = 0; i < n; ++i) {
+        LcsCell c;
+        memset(&c, 0, sizeof c);
+        layout_coords(grid, cells[i].slot, &c.col, &c.row);
+        c.kind = (uint32_t)cells[i].kind;
+        if (c.kind == V_INT) c.ival = ival[cells[i].slot];
+        out_bytes(&o, (const char *)&c, sizeof c);
+    }
+    static const char zeros[64];
+    out_bytes(&o, zeros, h.num_off - (h.cells_off + (uint64_t)n * sizeof(LcsCell)));
+    out_bytes(&o, (const char *)num, (size_t)nslots * sizeof(double));
+    for (int64_t i = 0; i < n; ++i) {
+        if (cells[i].kind != V_TEXT) continue;
+        const char *t = text[cells[i].slot] ? text[cells[i].slot] : "";
+        out_bytes(&o, t, strlen(t) + 1);
+    }
+
+    int err = out_close(&o);
+    if (fclose(f) != 0) err = 1;
+    if (err) perror(filename);
+    return err;
+}
+
+// Faixas de um eixo em ordem, sem sobreposição, somando 'total' posições
+static int spans_valid(const LayoutSpan *s, int64_t n, int64_t total) {
+    int64_t at = 0;
+    for (int64_t i = 0; i < n; ++i) {
+        if (s[i].len <= 0 || s[i].at != at ||
+            (i && s[i].first < s[i - 1].first + s[i - 1].len))
+            return 0;
+        at += s[i].len;
+    }
+    return at == total;
+}
+
+// Cabeçalho e seções dentro do arquivo, um texto no bloco de textos para
+// cada célula V_TEXT
+static int snapshot_valid(const LcsHeader *h, const char *data, uint64_t size) {
+    if (size < sizeof *h || memcmp(h->magic, LCS_MAGIC, sizeof h->magic) != 0 ||
+        h->version != LCS_VERSION || h->endian != LCS_ENDIAN)
+        return 0;
+    if (h->ncols < 0 || h->nrows < 0 || h->ncells < 0 ||
+        h->ncolspan < 0 || h->nrowspan < 0 ||
+        (h->nrows && (uint64_t)h->ncols > (size / sizeof(double)) / (uint64_t)h->nrows) ||
+        (uint64_t)h->ncells > size / sizeof(LcsCell) ||
+        (uint64_t)(h->ncolspan + h->nrowspan) > size / sizeof(LayoutSpan))
+        return 0;
+    uint64_t num_size = (uint64_t)(h->ncols * h->nrows) * sizeof(double);
+    uint64_t span_size = (uint64_t)(h->ncolspan + h->nrowspan) * sizeof(LayoutSpan);
+    if (h->span_off > size || h->cells_off > size || h->num_off > size ||
+        h->text_off > size || h->text_size > size)
+        return 0;
+    if (h->file_size != size || h->span_off < sizeof *h ||
+        h->span_off % sizeof(int64_t) != 0 ||
+        h->span_off + span_size > h->cells_off ||
+        h->cells_off % sizeof(int64_t) != 0 ||
+        h->cells_off + (uint64_t)h->ncells * sizeof(LcsCell) > h->num_off ||
+        h->num_off % sizeof(double) != 0 ||
+        h->num_off + num_size > h->text_off ||
+        h->text_off + h->text_size != size)
+        return 0;
+
+    const LayoutSpan *spans = (const LayoutSpan *)(data + h->span_off);
+    if ((h->ncolspan && !spans_valid(spans, h->ncolspan, h->ncols)) ||
+        (h->nrowspan && !spans_valid(spans + h->ncolspan, h->nrowspan, h->nrows)))
+        return 0;
+
+    const LcsCell *cells = (const LcsCell *)(data + h->cells_off);
+    const char *t = data + h->text_off, *end = data + size;
+    for (int64_t i = 0; i < h->ncells; ++i) {
+        if (cells[i].kind > V_TEXT) return 0;
+        if (cells[i].kind == V_TEXT) {
+            const char *z = t < end ? memchr(t, '\0', (size_t)(end - t)) : NULL;
+            if (!z) return 0;
+            t = z + 1;
+        }
+    }
+    return 1;
+}
+
+// Layout gravado no arquivo, com as faixas apontando para o mapeamento
+static void file_layout(const LcsHeader *h, const char *data, CellLayout *F) {
+    const LayoutSpan *spans = (const LayoutSpan *)(data + h->span_off);
+    layout_init(F);
+    F->col0     = h->col0;
+    F->row0     = h->row0;
+    F->ncols    = h->ncols;
+    F->nrows    = h->nrows;
+    F->colspan  = h->ncolspan ? spans : NULL;
+    F->rowspan  = h->nrowspan ? spans + h->ncolspan : NULL;
+    F->ncolspan = h->ncolspan;
+    F->nrowspan = h->nrowspan;
+}
+
+typedef struct {
+    const double *src;
+    double       *num;
+} NumCopy;
+
+static void copy_run(void *ctx, int64_t from, int64_t to, int64_t n) {
+    NumCopy *c = ctx;
+    memcpy(c->num + to, c->src + from, (size_t)n * sizeof *c->num);
+}
+
+int64_t snapshot_load(const char *filename, const CellLayout *grid, double *num,
+                      SnapCellFn on_cell, void *ctx) {
+    int fd = open(filename, O_RDONLY);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) != 0) {
+        perror(filename);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    uint64_t size = (uint64_t)sb.st_size;
+    const char *data = size ? mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0)
+                            : MAP_FAILED;
+    close(fd);
+    const LcsHeader *h = (const LcsHeader *)data;
+    if (data == MAP_FAILED || !snapshot_valid(h, data, size)) {
+        fprintf(stderr, "%s: snapshot inválido\n", filename);
+        if (data != MAP_FAILED) munmap((void *)data, size);
+        return -1;
+    }
+    madvise((void *)data, size, MADV_SEQUENTIAL);
+
+    // uma célula da tabela fora do grid se perderia em silêncio: o LOAD
+    // falha (a sema dimensiona o grid pelos snapshots que já existem na
+    // análise; este foi gravado depois, com células novas)
+    const LcsCell *cells = (const LcsCell *)(data + h->cells_off);
+    for (int64_t i = 0; i < h->ncells; ++i)
+        if (layout_find(grid, cells[i].col, cells[i].row) < 0) {
+            char name[32];
+            cell_format(cells[i].col, cells[i].row, name, sizeof name);
+            fprintf(stderr, "%s: célula %s fora do grid do programa\n",
+                    filename, name);
+            munmap((void *)data, size);
+            return -1;
+        }
+
+    // coluna numérica: interseção dos dois grids, por trechos de coluna (em
+    // column-major as linhas de uma coluna são contíguas nos dois lados)
+    CellLayout F;
+    file_layout(h, data, &F);
+    memset(num, 0, (size_t)layout_ncells(grid) * sizeof *num);
+    NumCopy nc = { (const double *)(data + h->num_off), num };
+    layout_runs(&F, grid, copy_run, &nc);
+
+    const char *t = data + h->text_off;
+    int64_t delivered = 0;
+    for (int64_t i = 0; i < h->ncells; ++i) {
+        const LcsCell *c = &cells[i];
+        const char *ct = NULL;
+        if (c->kind == V_TEXT) {
+            ct = t;
+            t += strlen(t) + 1;
+        }
+        int64_t slot = layout_find(grid, c->col, c->row);
+        if (on_cell) on_cell(ctx, slot, (int)c->kind, c->ival, ct);
+        delivered++;
+    }
+
+    // os textos entregues apontam para o mapeamento; sem textos, ele não
+    // é mais necessário
+    if (!h->text_size) munmap((void *)data, size);
+    return delivered;
+}
+
+// n faixas de um eixo, lidas na posição atual de f, em *out (NULL se n é 0)
+static int read_spans(FILE *f, int64_t n, int64_t total, const LayoutSpan **out) {
+    *out = NULL;
+    if (!n) return 1;
+    LayoutSpan *s = malloc((size_t)n * sizeof *s);
+    if (!s || fread(s, sizeof *s, (size_t)n, f) != (size_t)n || !spans_valid(s, n, total)) {
+        free(s);
+        return 0;
+    }
+    *out = s;
+    return 1;
+}
+
+int snapshot_layout(const char *filename, CellLayout *L) {
+    layout_init(L);
+    FILE *f = fopen(filename, "rb");
+    if (!f) return -1;
+    LcsHeader h;
+    int ok = fread(&h, sizeof h, 1, f) == 1 &&
+             memcmp(h.magic, LCS_MAGIC, sizeof h.magic) == 0 &&
+             h.version == LCS_VERSION && h.endian == LCS_ENDIAN &&
+             h.ncols >= 0 && h.nrows >= 0 &&
+             h.ncolspan >= 0 && h.ncolspan <= h.ncols &&
+             h.nrowspan >= 0 && h.nrowspan <= h.nrows &&
+             fseek(f, (long)h.span_off, SEEK_SET) == 0 &&
+             read_spans(f, h.ncolspan, h.ncols, &L->colspan) &&
+             read_spans(f, h.nrowspan, h.nrows, &L->rowspan);
+    fclose(f);
+    if (!ok) {
+        layout_free(L);
+        return -1;
+    }
+    L->col0     = h.col0;
+    L->row0     = h.row0;
+    L->ncols    = h.ncols;
+    L->nrows    = h.nrows;
+    L->ncolspan = h.ncolspan;
+    L->nrowspan = h.nrowspan;
+    return 0;
+}
+
+// ——— SAVE/LOAD do JIT (runtime.h) —————————————————————————————————————————
+
+int lc_save(const char *filename, const CellLayout *grid, const double *num,
+            const char *const *text, const int64_t *ival,
+            const unsigned char *kind, const unsigned char *assigned) {
+    int64_t nslots = layout_ncells(grid);
+    SnapCell *sc = malloc((size_t)(nslots + 1) * sizeof *sc);
+    if (!sc) {
+        fprintf(stderr, "%s: memória insuficiente\n", filename);
+        exit(1);
+    }
+
+    // células atribuídas, na ordem dos slots (a do TABLE)
+    int64_t k = 0;
+    for (int64_t s = 0; s < nslots; ++s)
+        if (assigned[s]) sc[k++] = (SnapCell){ s, kind[s] };
+
+    int rc = snapshot_save(filename, grid, num, ival, text, sc, k);
+    free(sc);
+    return rc;
+}
+
+typedef struct {
+    const char   **text;
+    int64_t       *ival;
+    unsigned char *kind;
+    unsigned char *assigned;
+} LoadCols;
+
+static void load_cell(void *ctx, int64_t slot, int kind, int64_t ival,
+                      const char *t) {
+    LoadCols *c = ctx;
+    c->assigned[slot] = 1;
+    c->kind[slot] = (unsigned char)kind;
+    c->ival[slot] = ival;
+    if (kind == V_TEXT) c->text[slot] = t;
+}
+
+// Slots fora da tabela do arquivo voltam a V_INT 0, não atribuídos, como
+// no store_load
+int lc_load(const char *filename, const CellLayout *grid, double *num,
+            const char **text, int64_t *ival, unsigned char *kind,
+            unsigned char *assigned) {
+    size_t n = (size_t)layout_ncells(grid);
+    memset(text, 0, n * sizeof *text);
+    memset(ival, 0, n * sizeof *ival);
+    memset(kind, V_INT, n * sizeof *kind);
+    memset(assigned, 0, n * sizeof *assigned);
+    LoadCols c = { text, ival, kind, assigned };
+    return snapshot_load(filename, grid, num, load_cell, &c) < 0;
+}
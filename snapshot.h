@@ -0,0 +1,84 @@
+// snapshot.h
+// SAVE/LOAD: estado completo das células num arquivo binário (.lcs), lido
+// de volta com mmap. Layout do arquivo, versão 3 (ordem de bytes da
+// máquina que gravou):
+//
+//   LcsHeader                       cabeçalho fixo
+//   LayoutSpan[ncolspan + nrowspan] faixas dos eixos compactados do grid
+//                                   (cells.h), colunas e depois linhas
+//   LcsCell[ncells]                 tabela de células (posição, tipo e
+//                                   valor exato das V_INT)
+//   double[ncols * nrows]           coluna numérica do grid, column-major
+//                                   como o num[] do JIT e do ValueStore,
+//                                   alinhada em 64 bytes
+//   char[text_size]                 textos das células V_TEXT, na ordem da
+//                                   tabela, terminados em '\0'
+#ifndef LANGCELL_SNAPSHOT_H
+#define LANGCELL_SNAPSHOT_H
+
+#include <stdint.h>
+#include "cells.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LCS_MAGIC    "LCSNAP\r\n"
+#define LCS_VERSION  3
+#define LCS_ENDIAN   0x01020304u
+
+typedef struct {
+    char     magic[8];                // LCS_MAGIC
+    uint32_t version;                 // LCS_VERSION
+    uint32_t endian;                  // LCS_ENDIAN como gravado
+    int64_t  col0, row0, ncols, nrows;  // grid da coluna numérica
+    int64_t  ncolspan, nrowspan;      // faixas de cada eixo (0: eixo denso)
+    int64_t  ncells;                  // entradas de LcsCell
+    uint64_t span_off, cells_off, num_off, text_off, text_size;
+    uint64_t file_size;
+} LcsHeader;
+
+// Uma célula com valor: a ordem da tabela é a ordem de inserção usada por
+// TABLE/EXPORT. O número fica na coluna numérica, na posição do grid; o
+// de uma V_INT também em ival, sem o arredondamento do double.
+typedef struct {
+    int64_t  row, col;
+    uint32_t kind;                    // ValueKind (cells.h)
+    uint32_t pad;
+    int64_t  ival;                    // valor da V_INT (0 nas demais)
+} LcsCell;
+
+// Célula a gravar: slot no grid e ValueKind
+typedef struct {
+    int64_t slot;
+    int     kind;
+} SnapCell;
+
+// Grava o grid: num[] inteiro, as células de cells[], o ival[slot] das
+// V_INT e os textos (text[slot]) das V_TEXT. Retorna 0 ou 1.
+int snapshot_save(const char *filename, const CellLayout *grid, const double *num,
+                  const int64_t *ival, const char *const *text,
+                  const SnapCell *cells, int64_t n);
+
+// Lê um snapshot para o grid dado. A parte da coluna numérica que cai no
+// grid é copiada para num[] (uma cópia por trecho de coluna), o resto de num[] fica
+// 0; depois on_cell(ctx, slot, kind, ival, texto) é chamada para cada célula da
+// tabela, na ordem gravada. Os textos apontam para dentro do
+// arquivo mapeado, que continua mapeado até o fim do processo. Retorna o
+// número de células da tabela entregues, ou -1 (arquivo ilegível ou
+// inválido, ou com uma célula da tabela fora do grid, sem tocar em num[]).
+typedef void (*SnapCellFn)(void *ctx, int64_t slot, int kind, int64_t ival,
+                           const char *text);
+int64_t snapshot_load(const char *filename, const CellLayout *grid, double *num,
+                      SnapCellFn on_cell, void *ctx);
+
+// Layout do grid gravado no snapshot (com faixas próprias, liberadas por
+// layout_free), sem mapear a coluna numérica. Retorna 0, ou -1 se não for
+// um snapshot.
+int snapshot_layout(const char *filename, CellLayout *L);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_SNAPSHOT_H
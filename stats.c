@@ -0,0 +1,183 @@
+// stats.c
+// Agregações estatísticas (ver stats.h). VAR e STDEV saem de uma passada só
+// pelo algoritmo de Welford (média e soma dos quadrados dos desvios
+// atualizadas a cada valor), que não perde precisão como a fórmula
+// E[x²] - E[x]² quando a média é grande perto do desvio. MEDIAN e PERCENTILE
+// copiam os valores para um buffer da thread e usam seleção em vez de
+// ordenar: introselect, isto é, quickselect com pivô mediana de três e
+// partição em três faixas (repetições não degradam), que ordena a faixa
+// restante por heapsort se passar de 2 log2(n) partições. O(n) esperado,
+// O(n log n) no pior caso.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+
+// Buffer de seleção, por thread (o --parallel agrega em várias ao mesmo
+// tempo); só cresce
+static __thread double  *Scratch    = NULL;
+static __thread int64_t  ScratchCap = 0;
+
+static int64_t count_values(int64_t nargs, const AggArg *args) {
+    int64_t n = 0;
+    for (int64_t a = 0; a < nargs; ++a)
+        if (args[a].rows > 0 && args[a].cols > 0) n += args[a].rows * args[a].cols;
+    return n;
+}
+
+static double product(int64_t nargs, const AggArg *args) {
+    double acc = 1.0;
+    for (int64_t a = 0; a < nargs; ++a) {
+        const AggArg *g = &args[a];
+        for (int64_t c = 0; c < g->cols; ++c) {
+            const double *col = g->ptr + c * g->stride;
+            for (int64_t r = 0; r < g->rows; ++r) acc *= col[r];
+        }
+    }
+    return acc;
+}
+
+// variância amostral (denominador n - 1); 0 com menos de dois valores. Os
+// valores entram deslocados pelo primeiro: a variância não muda, e para
+// dados agrupados longe de zero (1e9 + 0.1, 1e9 + 0.2, ...) a subtração é
+// exata e a média acumulada fica pequena
+static double variance(int64_t nargs, const AggArg *args) {
+    int64_t n     = 0;
+    double  shift = 0.0, mean = 0.0, m2 = 0.0;
+    for (int64_t a = 0; a < nargs; ++a) {
+        const AggArg *g = &args[a];
+        for (int64_t c = 0; c < g->cols; ++c) {
+            const double *col = g->ptr + c * g->stride;
+            for (int64_t r = 0; r < g->rows; ++r) {
+                if (n == 0) shift = col[r];
+                double x = col[r] - shift;
+                double d = x - mean;
+                ++n;
+                mean += d / (double)n;
+                m2   += d * (x - mean);
+            }
+        }
+    }
+    return n > 1 ? m2 / (double)(n - 1) : 0.0;
+}
+
+// copia os valores, na ordem dos argumentos, para o buffer da thread
+static double *gather(int64_t nargs, const AggArg *args, int64_t *n_out) {
+    int64_t n = count_values(nargs, args);
+    if (n > ScratchCap) {
+        free(Scratch);
+        Scratch = malloc((size_t)n * sizeof *Scratch);
+        if (!Scratch) exit(1);
+        ScratchCap = n;
+    }
+    int64_t k = 0;
+    for (int64_t a = 0; a < nargs; ++a) {
+        const AggArg *g = &args[a];
+        if (g->rows <= 0) continue;
+        for (int64_t c = 0; c < g->cols; ++c, k += g->rows)
+            memcpy(Scratch + k, g->ptr + c * g->stride, (size_t)g->rows * sizeof *Scratch);
+    }
+    *n_out = n;
+    return Scratch;
+}
+
+// ——— seleção ——————————————————————————————————————————————————————————————
+
+static inline void swap(double *a, double *b) {
+    double t = *a; *a = *b; *b = t;
+}
+
+static void insertion_sort(double *v, int64_t n) {
+    for (int64_t i = 1; i < n; ++i) {
+        double  x = v[i];
+        int64_t j = i;
+        for (; j > 0 && v[j - 1] > x; --j) v[j] = v[j - 1];
+        v[j] = x;
+    }
+}
+
+static void sift_down(double *v, int64_t i, int64_t n) {
+    for (int64_t c; (c = 2 * i + 1) < n; i = c) {
+        if (c + 1 < n && v[c + 1] > v[c]) ++c;
+        if (!(v[c] > v[i])) break;
+        swap(&v[i], &v[c]);
+    }
+}
+
+static void heap_sort(double *v, int64_t n) {
+    for (int64_t i = n / 2 - 1; i >= 0; --i) sift_down(v, i, n);
+    for (int64_t end = n - 1; end > 0; --end) {
+        swap(&v[0], &v[end]);
+        sift_down(v, 0, end);
+    }
+}
+
+// k-ésimo menor valor de v[0, n) (base 0). Na saída v[k] é esse valor, os
+// anteriores são <= e os seguintes >= a ele. v não pode ter NaN.
+static double select_kth(double *v, int64_t n, int64_t k) {
+    int64_t lo = 0, hi = n - 1;    // faixa que ainda contém a posição k
+    int     depth = 0;
+    for (int64_t m = n; m > 1; m >>= 1) depth += 2;
+
+    while (hi - lo >= 16) {
+        if (depth-- == 0) {
+            heap_sort(v + lo, hi - lo + 1);
+            return v[k];
+        }
+        int64_t mid = lo + (hi - lo) / 2;
+        if (v[mid] < v[lo])  swap(&v[mid], &v[lo]);
+        if (v[hi]  < v[lo])  swap(&v[hi],  &v[lo]);
+        if (v[hi]  < v[mid]) swap(&v[hi],  &v[mid]);
+        double p = v[mid];
+
+        // [lo, lt) < p, [lt, i) == p, (gt, hi] > p
+        int64_t lt = lo, i = lo, gt = hi;
+        while (i <= gt) {
+            if      (v[i] < p) swap(&v[lt++], &v[i++]);
+            else if (v[i] > p) swap(&v[i], &v[gt--]);
+            else               ++i;
+        }
+        if      (k < lt) hi = lt - 1;
+        else if (k > gt) lo = gt + 1;
+        else             return p;
+    }
+    insertion_sort(v + lo, hi - lo + 1);
+    return v[k];
+}
+
+// valor na posição fracionária pos (0 <= pos <= n - 1) de v ordenado, com
+// interpolação linear entre os vizinhos (PERCENTILE/PERCENTILE.INC do Excel)
+static double quantile(double *v, int64_t n, double pos) {
+    int64_t k    = (int64_t)pos;
+    double  frac = pos - (double)k;
+    double  lo   = select_kth(v, n, k);
+    if (frac == 0.0 || k + 1 >= n) return lo;
+    double hi = v[k + 1];          // o sucessor é o menor depois de k
+    for (int64_t i = k + 2; i < n; ++i) if (v[i] < hi) hi = v[i];
+    return lo + frac * (hi - lo);
+}
+
+double stats_agg(int fn, int64_t nargs, const AggArg *args) {
+    switch (fn) {
+      case AGG_COUNT:   return (double)count_values(nargs, args);
+      case AGG_PRODUCT: return count_values(nargs, args) > 0 ? product(nargs, args) : 0.0;
+      case AGG_VAR:     return variance(nargs, args);
+      case AGG_STDEV:   return sqrt(variance(nargs, args));
+      case AGG_MEDIAN:
+      case AGG_PERCENTILE: {
+        int64_t n;
+        double *v = gather(nargs, args, &n);
+        double  k = 0.5;
+        if (fn == AGG_PERCENTILE) {
+            if (n < 2) return 0.0;
+            k = v[--n];
+            if (!(k >= 0.0 && k <= 1.0)) return NAN;
+        }
+        if (n == 0) return 0.0;
+        for (int64_t i = 0; i < n; ++i) if (isnan(v[i])) return NAN;
+        return quantile(v, n, k * (double)(n - 1));
+      }
+    }
+    return 0.0;
+}
@@ -0,0 +1,22 @@
+// stats.h
+// Agregações estatísticas de agg_helper: COUNT, PRODUCT, VAR, STDEV, MEDIAN
+// e PERCENTILE, sobre a mesma lista de blocos AggArg das demais.
+#ifndef LANGCELL_STATS_H
+#define LANGCELL_STATS_H
+
+#include <stdint.h>
+#include "runtime.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// fn é um AggFn de AGG_COUNT em diante. No PERCENTILE o último valor da
+// lista é o k (em [0, 1]; fora disso o resultado é NaN)
+double stats_agg(int fn, int64_t nargs, const AggArg *args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_STATS_H
@@ -0,0 +1,275 @@
+// store.c
+// ValueStore: valores das células para o interpretador e a VM de bytecode.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "store.h"
+#include "runtime.h"
+#include "csv.h"
+#include "snapshot.h"
+
+void store_init(ValueStore *st, const CellLayout *L) {
+    int64_t n = layout_ncells(L);
+    if (n < 0) {            // layout que a sema deveria ter recusado
+        fprintf(stderr, "langcell: grid grande demais\n");
+        exit(1);
+    }
+    if (n == 0) n = 1;      // programa sem células: ponteiros nunca NULL
+    st->layout   = L;
+    st->num      = calloc(n, sizeof *st->num);
+    st->text     = calloc(n, sizeof *st->text);
+    st->ival     = calloc(n, sizeof *st->ival);
+    st->kind     = calloc(n, sizeof *st->kind);     // V_INT 0 em todo slot
+    st->assigned = calloc(n, sizeof *st->assigned);
+    st->order    = malloc(n * sizeof *st->order);
+    st->n_order  = 0;
+    st->rindex   = NULL;
+    st->n_rindex = 0;
+    st->own_text = 0;
+    if (!st->num || !st->text || !st->ival || !st->kind || !st->assigned || !st->order) {
+        fprintf(stderr, "langcell: memória insuficiente para %lld células\n",
+                (long long)n);
+        exit(1);
+    }
+}
+
+// Libera os textos próprios (own_text) de todas as células
+static void free_texts(ValueStore *st) {
+    if (!st->own_text) return;
+    int64_t n = layout_ncells(st->layout);
+    for (int64_t s = 0; s < n; ++s)
+        if (st->kind[s] == V_TEXT) free(st->text[s]);
+}
+
+void store_own_text(ValueStore *st, int64_t slot, Value *v) {
+    char *old = st->kind[slot] == V_TEXT ? st->text[slot] : NULL;
+    if (v->kind == V_TEXT && v->sval) {
+        v->sval = strdup(v->sval);      // antes do free: v pode ser o próprio old
+        if (!v->sval) exit(1);
+    }
+    free(old);
+    st->text[slot] = NULL;
+}
+
+void store_free(ValueStore *st) {
+    free_texts(st);
+    free(st->num);
+    free(st->text);
+    free(st->ival);
+    free(st->kind);
+    free(st->assigned);
+    free(st->order);
+    for (int i = 0; i < st->n_rindex; ++i) rindex_free(st->rindex[i]);
+    free(st->rindex);
+    st->num      = NULL;
+    st->text     = NULL;
+    st->ival     = NULL;
+    st->kind     = NULL;
+    st->assigned = NULL;
+    st->order    = NULL;
+    st->n_order  = 0;
+    st->rindex   = NULL;
+    st->n_rindex = 0;
+    st->own_text = 0;
+}
+
+void store_clear(ValueStore *st) {
+    free_texts(st);
+    int64_t n = layout_ncells(st->layout);
+    if (n == 0) n = 1;
+    memset(st->num,      0, n * sizeof *st->num);
+    memset(st->text,     0, n * sizeof *st->text);
+    memset(st->ival,     0, n * sizeof *st->ival);
+    memset(st->kind,     0, n * sizeof *st->kind);
+    memset(st->assigned, 0, n * sizeof *st->assigned);
+    st->n_order = 0;
+    store_rindex_invalidate(st);
+}
+
+void store_add_rindex(ValueStore *st, RangeIndex *ix) {
+    st->rindex = realloc(st->rindex, (st->n_rindex + 1) * sizeof *st->rindex);
+    if (!st->rindex) exit(1);
+    st->rindex[st->n_rindex++] = ix;
+}
+
+void store_rindex_set(ValueStore *st, int64_t slot) {
+    for (int i = 0; i < st->n_rindex; ++i)
+        rindex_set(st->rindex[i], slot, st->num[slot]);
+}
+
+void store_rindex_invalidate(ValueStore *st) {
+    for (int i = 0; i < st->n_rindex; ++i) rindex_invalidate(st->rindex[i]);
+}
+
+typedef struct {
+    ValueStore       *to;
+    const ValueStore *from;
+} Relayout;
+
+static void relayout_run(void *ctx, int64_t from, int64_t to, int64_t n) {
+    Relayout *r = ctx;
+    memcpy(r->to->num + to,      r->from->num + from,      n * sizeof *r->to->num);
+    memcpy(r->to->text + to,     r->from->text + from,     n * sizeof *r->to->text);
+    memcpy(r->to->ival + to,     r->from->ival + from,     n * sizeof *r->to->ival);
+    memcpy(r->to->kind + to,     r->from->kind + from,     n * sizeof *r->to->kind);
+    memcpy(r->to->assigned + to, r->from->assigned + from, n * sizeof *r->to->assigned);
+}
+
+// Cada trecho de coluna do layout antigo é um trecho contíguo de uma
+// coluna de L
+void store_relayout(ValueStore *st, const CellLayout *L) {
+    const CellLayout *old = st->layout;
+    ValueStore ns;
+    store_init(&ns, L);
+    Relayout r = { &ns, st };
+    layout_runs(old, L, relayout_run, &r);
+    for (int64_t i = 0; i < st->n_order; ++i) {
+        int64_t col, row;
+        layout_coords(old, st->order[i], &col, &row);
+        ns.order[i] = layout_slot(L, col, row);
+    }
+    ns.n_order = st->n_order;
+    ns.own_text = st->own_text;         // os textos passaram para ns
+    st->own_text = 0;
+    store_free(st);
+    *st = ns;
+}
+
+// Linhas "nome<sep>valor" na ordem de inserção, pelo mesmo buffer e
+// formatação de números do lc_table/lc_export do JIT
+static void write_store(OutBuf *o, const ValueStore *st, char sep, int escape) {
+    for (int64_t i = 0; i < st->n_order; ++i) {
+        char name[32];
+        Value v = store_get(st, st->order[i]);
+        layout_name(st->layout, st->order[i], name, sizeof name);
+        out_str(o, name);
+        out_char(o, sep);
+        if (v.kind == V_INT)        out_int(o, v.ival);
+        else if (v.kind == V_FLOAT) out_double(o, v.fval);
+        else if (escape)            csv_escape(o, v.sval);
+        else if (v.sval)            out_str(o, v.sval);
+        out_char(o, '\n');
+    }
+}
+
+void store_table(const ValueStore *st) {
+    OutBuf o;
+    out_open(&o, stdout);
+    write_store(&o, st, '\t', 0);
+    out_close(&o);
+}
+
+int store_export(const ValueStore *st, const char *filename) {
+    FILE *f = fopen(filename, "w");
+    if (!f) { perror("fopen"); return 1; }
+    OutBuf o;
+    out_open(&o, f);
+    write_store(&o, st, ',', 1);
+    int err = out_close(&o);
+    if (fclose(f) != 0) err = 1;
+    if (err) perror(filename);
+    return err;
+}
+
+typedef struct {
+    ValueStore          *st;
+    const unsigned char *pinned;
+} ImportCtx;
+
+static void import_cell(void *ctx, int64_t slot, double v) {
+    ImportCtx *c = ctx;
+    if (c->pinned && c->pinned[slot]) {
+        store_touch(c->st, slot);
+        return;
+    }
+    store_set(c->st, slot, (Value){.kind = V_FLOAT, .fval = v});
+}
+
+int store_import(ValueStore *st, const char *filename, int64_t col,
+                 int64_t row, const unsigned char *pinned) {
+    ImportCtx c = { st, pinned };
+    return import_csv(filename, col, row, st->layout, st->num, NULL, NULL, import_cell, &c) < 0;
+}
+
+// Extensão de um IMPORT: o próprio import_csv, sobre um grid que começa em
+// A0 e cobre 2^31 colunas e linhas, só anota onde cada número cairia
+#define EXTENT_BITS 31
+
+static void extent_cell(void *ctx, int64_t slot, double v) {
+    (void)v;
+    layout_add(ctx, slot >> EXTENT_BITS, slot & (((int64_t)1 << EXTENT_BITS) - 1));
+}
+
+// L passa a cobrir também E
+static void extend(CellLayout *L, const CellLayout *E) {
+    CellLayout out;
+    if (E->ncols == 0 || layout_cover(&out, L, NULL, E) < 0) return;
+    layout_free(L);
+    *L = out;
+}
+
+void store_import_extent(const char *filename, int64_t col, int64_t row,
+                         CellLayout *L) {
+    if (access(filename, R_OK) != 0) return;
+    CellLayout grid, cells;
+    layout_init(&grid);
+    layout_init(&cells);
+    grid.ncols = grid.nrows = (int64_t)1 << EXTENT_BITS;
+    import_csv(filename, col, row, &grid, NULL, NULL, NULL, extent_cell, &cells);
+    extend(L, &cells);
+}
+
+void store_load_extent(const char *filename, CellLayout *L) {
+    CellLayout F;
+    if (snapshot_layout(filename, &F) != 0) return;
+    extend(L, &F);
+    layout_free(&F);
+}
+
+int store_save(const ValueStore *st, const char *filename) {
+    SnapCell *cells = malloc((size_t)(st->n_order + 1) * sizeof *cells);
+    if (!cells) exit(1);
+    for (int64_t i = 0; i < st->n_order; ++i)
+        cells[i] = (SnapCell){ st->order[i], st->kind[st->order[i]] };
+    int rc = snapshot_save(filename, st->layout, st->num, st->ival,
+                           (const char *const *)st->text, cells, st->n_order);
+    free(cells);
+    return rc;
+}
+
+static void load_cell(void *ctx, int64_t slot, int kind, int64_t ival,
+                      const char *text) {
+    ValueStore *st = ctx;
+    store_touch(st, slot);
+    st->kind[slot] = (unsigned char)kind;
+    st->ival[slot] = ival;
+    if (kind == V_TEXT) {
+        st->text[slot] = (char *)text;
+        if (st->own_text && text && !(st->text[slot] = strdup(text))) exit(1);
+    }
+}
+
+int store_load(ValueStore *st, const char *filename,
+               const unsigned char *pinned) {
+    int64_t n = layout_ncells(st->layout);
+
+    // células fixadas pelo recálculo guardam o valor atual
+    int64_t npin = 0;
+    Value  *saved = NULL;
+    if (pinned) {
+        saved = malloc((size_t)(n + 1) * sizeof *saved);
+        if (!saved) exit(1);
+        for (int64_t s = 0; s < n; ++s)
+            if (pinned[s]) saved[npin++] = store_get(st, s);
+    }
+
+    store_clear(st);
+    int rc = snapshot_load(filename, st->layout, st->num, load_cell, st) < 0;
+
+    for (int64_t s = 0, i = 0; i < npin; ++s)
+        if (pinned[s]) store_set(st, s, saved[i++]);
+    free(saved);
+    return rc;
+}
@@ -0,0 +1,142 @@
+// store.h
+// Valores das células para os engines interpretados (AST e bytecode VM):
+// tipo, número e texto por slot do grid, mais a ordem de inserção usada por
+// TABLE/EXPORT.
+#ifndef LANGCELL_STORE_H
+#define LANGCELL_STORE_H
+
+#include <stdint.h>
+#include "cells.h"
+#include "rangeidx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tipo genérico de valor
+typedef struct {
+    ValueKind kind;
+    union {
+        int64_t ival;
+        double  fval;
+        char   *sval;
+    };
+} Value;
+
+// Colunas separadas (SoA) em vez de um Value por slot: num[], ival[] e
+// kind[] têm o mesmo formato do CellStore do JIT, então código gerado pelo
+// LLVM pode ler e escrever direto no store (ver o modo tiered em interp.c)
+typedef struct {
+    const CellLayout *layout;
+    double           *num;       // valor numérico por slot (0 para texto)
+    char            **text;      // valor de texto por slot (V_TEXT)
+    int64_t          *ival;      // valor exato das V_INT (num arredonda)
+    unsigned char    *kind;      // ValueKind por slot (V_INT 0 se nunca atribuído)
+    unsigned char    *assigned;  // slot já recebeu atribuição?
+    int64_t          *order;     // slots na ordem da primeira atribuição
+    int64_t           n_order;
+    RangeIndex      **rindex;    // índices de range atualizados a cada escrita
+    int               n_rindex;
+    int               own_text;  // textos são cópias do store (ver store_own_text)
+} ValueStore;
+
+void store_init(ValueStore *st, const CellLayout *L);
+void store_free(ValueStore *st);
+// Volta todas as células ao estado inicial (V_INT 0, nenhuma atribuída)
+void store_clear(ValueStore *st);
+// Troca o layout por L, que deve conter o atual, mantendo valores e ordem
+// de inserção; st->layout passa a ser L (modo streaming). Os índices de
+// range são descartados.
+void store_relayout(ValueStore *st, const CellLayout *L);
+
+// Com st->own_text (modo streaming, em que a AST de cada statement é
+// liberada) cada célula V_TEXT tem uma cópia própria do texto, liberada
+// quando a célula é sobrescrita, limpa ou o store é liberado. Chamada por
+// store_put antes de gravar: troca v->sval pela cópia.
+void store_own_text(ValueStore *st, int64_t slot, Value *v);
+
+// Índices de range (rangeidx.h): o store passa a ser dono de ix e a mantê-lo
+// a cada store_put; store_rindex_invalidate é para quem escreve em num[]
+// por fora (laços do tier nativo)
+void store_add_rindex(ValueStore *st, RangeIndex *ix);
+void store_rindex_set(ValueStore *st, int64_t slot);
+void store_rindex_invalidate(ValueStore *st);
+
+// Registra a célula na ordem de inserção (primeira atribuição)
+static inline void store_touch(ValueStore *st, int64_t slot) {
+    if (!st->assigned[slot]) {
+        st->assigned[slot]        = 1;
+        st->order[st->n_order++]  = slot;
+    }
+}
+
+// Grava o valor sem mexer na ordem de inserção
+static inline void store_put(ValueStore *st, int64_t slot, Value v) {
+    if (st->own_text) store_own_text(st, slot, &v);
+    st->kind[slot] = (unsigned char)v.kind;
+    switch (v.kind) {
+      case V_INT:   st->ival[slot] = v.ival; st->num[slot] = (double)v.ival; break;
+      case V_FLOAT: st->num[slot] = v.fval; break;
+      case V_TEXT:  st->num[slot] = 0.0; st->text[slot] = v.sval; break;
+    }
+    if (st->n_rindex) store_rindex_set(st, slot);
+}
+
+// Atualiza o valor de uma célula, registrando a ordem de inserção
+static inline void store_set(ValueStore *st, int64_t slot, Value v) {
+    store_touch(st, slot);
+    store_put(st, slot, v);
+}
+
+static inline Value store_get(const ValueStore *st, int64_t slot) {
+    switch ((ValueKind)st->kind[slot]) {
+      case V_FLOAT: return (Value){.kind = V_FLOAT, .fval = st->num[slot]};
+      case V_TEXT:  return (Value){.kind = V_TEXT,  .sval = st->text[slot]};
+      default:      return (Value){.kind = V_INT,   .ival = st->ival[slot]};
+    }
+}
+
+// Leitura ou gravação de uma célula que a sema não tipou como inteira: o
+// V_INT passa a V_FLOAT, arredondado, como o double do JIT
+static inline Value value_float(Value v) {
+    return v.kind == V_INT ? (Value){.kind = V_FLOAT, .fval = (double)v.ival} : v;
+}
+
+static inline double value_num(Value v) {
+    return v.kind == V_FLOAT ? v.fval : v.ival;
+}
+
+// Valor-verdade no estilo do interpretador: floats são truncados para int
+static inline int value_truth(Value v) {
+    return v.kind == V_FLOAT ? (int)v.fval : v.ival != 0;
+}
+
+// TABLE: imprime as células atribuídas, na ordem de inserção
+void store_table(const ValueStore *st);
+// EXPORT: grava "nome,valor" em filename; retorna 0 ou 1 em caso de erro
+int  store_export(const ValueStore *st, const char *filename);
+// IMPORT: números do CSV nas células a partir de (col, row), como V_FLOAT
+// (ver import_csv). Slots com pinned[slot] != 0 só entram na ordem de
+// inserção, sem mudar de valor; pinned pode ser NULL. Retorna 0 ou 1.
+int  store_import(ValueStore *st, const char *filename, int64_t col,
+                  int64_t row, const unsigned char *pinned);
+// SAVE: grava o estado inteiro em snapshot binário (snapshot.h); 0 ou 1
+int  store_save(const ValueStore *st, const char *filename);
+// LOAD: substitui o estado pelo do snapshot (células fora do grid são
+// ignoradas); slots com pinned[slot] != 0 mantêm o valor. Retorna 0 ou 1.
+int  store_load(ValueStore *st, const char *filename,
+                const unsigned char *pinned);
+
+// Modo streaming: estendem L (que passa a ter faixas próprias, liberadas
+// por layout_free) para cobrir as células que um IMPORT em (col, row) ou um
+// LOAD escreveriam, antes de o statement rodar. Arquivo ilegível não
+// estende nada (o erro sai na execução).
+void store_import_extent(const char *filename, int64_t col, int64_t row,
+                         CellLayout *L);
+void store_load_extent(const char *filename, CellLayout *L);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_STORE_H
@@ -0,0 +1,559 @@
+// vm.c
+// Compilador AST → bytecode de registradores e a VM que o executa.
+//
+// Cada instrução tem um destino 'a', dois fontes 'b'/'c' e um operando
+// imediato (constante, slot de célula, descritor ou offset de salto).
+// Os registradores são alocados como pilha: o resultado de uma expressão vai
+// para 'dst' e as subexpressões usam dst+1, dst+2, ...
+// Operações aritméticas têm variantes tipadas (_FF) usadas quando o
+// compilador sabe que os dois operandos são V_FLOAT, o que dispensa o teste
+// de tag; as demais convertem como o interpretador (+, - e * entre dois
+// V_INT dão V_INT, ou V_FLOAT se o resultado não cabe em 64 bits).
+// Aritmética e comparações com literal à direita (A1 + 1, C1 > 0) usam as
+// variantes _K, que levam o literal na própria instrução (c = 1 se ele é
+// inteiro) e economizam um LOAD e um dispatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm.h"
+#include "sema.h"
+#include "store.h"
+#include "runtime.h"
+
+typedef enum {
+    BC_HALT,
+    BC_LOADI,      // a ← int imediato
+    BC_LOADF,      // a ← double imediato
+    BC_LOADS,      // a ← texto imediato
+    BC_LOADC,      // a ← células[k] (b: célula não inteira, ver value_float)
+    BC_STOREC,     // células[k] ← a (b: idem)
+    BC_NEG,        // a ← -b
+    BC_NOT,        // a ← NOT b
+    BC_ADD, BC_SUB, BC_MUL, BC_DIV,              // a ← b op c (genérico)
+    BC_ADD_FF, BC_SUB_FF, BC_MUL_FF, BC_DIV_FF,  // idem, b e c V_FLOAT
+    BC_ADD_K, BC_SUB_K, BC_MUL_K, BC_DIV_K,      // a ← b op f (imediato, c: inteiro)
+    BC_GT, BC_LT, BC_GE, BC_LE, BC_EQ, BC_NE,
+    BC_GT_K, BC_LT_K, BC_GE_K, BC_LE_K, BC_EQ_K, BC_NE_K,
+    BC_AND, BC_OR,
+    BC_JMP,        // ip += k
+    BC_JMPF,       // se a é falso: ip += k
+    BC_AGG_RANGE,  // a ← agregação b sobre um único range (descritor k)
+    BC_AGG,        // a ← agregação b sobre o descritor k (ranges + regs)
+    BC_TABLE,
+    BC_EXPORT,     // k = nome do arquivo
+    BC_IMPORT,     // stmt = IMPORT (arquivo e célula de destino)
+    BC_SAVE,       // s = arquivo do snapshot
+    BC_LOAD,       // s = arquivo do snapshot
+    BC_COUNT
+} Opcode;
+
+typedef struct {
+    uint16_t op;
+    uint16_t a, b, c;
+    union {
+        int64_t  k;
+        double   f;
+        char    *s;
+        const Stmt *stmt;
+    };
+} Instr;
+
+// Argumento de uma agregação: range do grid ou registrador
+typedef struct {
+    int     is_range;
+    int64_t slot, rows, cols;   // range
+    int     reg;                // escalar
+} AggItem;
+
+typedef struct {
+    int      nitems;
+    AggItem *items;
+    int64_t  count;             // total de valores (ranges + escalares)
+    int      indexed;           // range único com RangeIndex (sema)
+} AggDesc;
+
+struct VmProgram {
+    Instr   *code;
+    int      n_code, cap_code;
+    AggDesc *descs;
+    int      n_descs, cap_descs;
+    int      n_regs;
+    int64_t  max_count;         // maior agregação, para o buffer de trabalho
+};
+
+// Tipo estático conhecido de um registrador
+typedef enum { K_INT, K_FLOAT, K_TEXT, K_ANY } StaticKind;
+
+// ——— emissão ——————————————————————————————————————————————————————————————
+
+static int emit(VmProgram *p, Opcode op, int a, int b, int c, int64_t k) {
+    if (p->n_code == p->cap_code) {
+        p->cap_code = p->cap_code ? p->cap_code * 2 : 256;
+        p->code = realloc(p->code, p->cap_code * sizeof *p->code);
+        if (!p->code) exit(1);
+    }
+    Instr *in = &p->code[p->n_code];
+    in->op = (uint16_t)op;
+    in->a  = (uint16_t)a;
+    in->b  = (uint16_t)b;
+    in->c  = (uint16_t)c;
+    in->k  = k;
+    return p->n_code++;
+}
+
+// offset relativo à instrução seguinte ao salto
+static void patch_jump(VmProgram *p, int at, int target) {
+    p->code[at].k = target - (at + 1);
+}
+
+static void use_reg(VmProgram *p, int r) {
+    if (r >= 65535) {
+        fprintf(stderr, "Erro: expressão profunda demais para a VM\n");
+        exit(1);
+    }
+    if (r + 1 > p->n_regs) p->n_regs = r + 1;
+}
+
+static int add_desc(VmProgram *p, AggDesc d) {
+    if (p->n_descs == p->cap_descs) {
+        p->cap_descs = p->cap_descs ? p->cap_descs * 2 : 16;
+        p->descs = realloc(p->descs, p->cap_descs * sizeof *p->descs);
+        if (!p->descs) exit(1);
+    }
+    if (d.count > p->max_count) p->max_count = d.count;
+    p->descs[p->n_descs] = d;
+    return p->n_descs++;
+}
+
+// ——— compilação de expressões ———————————————————————————————————————————
+
+// Tipo de l op r para +, - e *: double se algum lado certamente não é
+// V_INT; com os dois V_INT o resultado pode estourar para double, então
+// não se sabe
+static StaticKind arith_kind(StaticKind l, StaticKind r) {
+    if (l == K_FLOAT || l == K_TEXT || r == K_FLOAT || r == K_TEXT)
+        return K_FLOAT;
+    return K_ANY;
+}
+
+static StaticKind compile_expr(VmProgram *p, Expr *e, int dst);
+
+static StaticKind compile_call(VmProgram *p, Expr *e, int dst) {
+    int agg = e->call.fn;
+    if (agg < 0) {
+        emit(p, BC_LOADI, dst, 0, 0, 0);
+        return K_INT;
+    }
+
+    AggDesc d = { 0, NULL, 0, 0 };
+    for (Expr *arg = e->call.args; arg; arg = arg->next) d.nitems++;
+    d.items = calloc(d.nitems ? d.nitems : 1, sizeof *d.items);
+    if (!d.items) exit(1);
+
+    // escalares vão para dst, dst+1, ...; o resultado sobrescreve dst
+    int i = 0, reg = dst;
+    for (Expr *arg = e->call.args; arg; arg = arg->next, ++i) {
+        if (arg->kind == EXPR_RANGE) {
+            d.items[i].is_range = 1;
+            d.items[i].slot     = arg->range.slot;
+            d.items[i].rows     = arg->range.rows;
+            d.items[i].cols     = arg->range.cols;
+            d.count += arg->range.rows * arg->range.cols;
+            d.indexed = arg->range.indexed;
+        } else {
+            use_reg(p, reg);
+            compile_expr(p, arg, reg);
+            d.items[i].reg = reg++;
+            d.count++;
+        }
+    }
+    use_reg(p, dst);
+    int k = add_desc(p, d);
+    if (d.nitems == 1 && d.items[0].is_range)
+        emit(p, BC_AGG_RANGE, dst, agg, 0, k);
+    else
+        emit(p, BC_AGG, dst, agg, 0, k);
+    return K_FLOAT;
+}
+
+static StaticKind compile_expr(VmProgram *p, Expr *e, int dst) {
+    use_reg(p, dst);
+    switch (e->kind) {
+      case EXPR_INT:
+        emit(p, BC_LOADI, dst, 0, 0, e->ival);
+        return K_INT;
+      case EXPR_FLOAT: {
+        int at = emit(p, BC_LOADF, dst, 0, 0, 0);
+        p->code[at].f = e->fval;
+        return K_FLOAT;
+      }
+      case EXPR_TEXT: {
+        int at = emit(p, BC_LOADS, dst, 0, 0, 0);
+        p->code[at].s = e->sval;
+        return K_TEXT;
+      }
+      case EXPR_CELL:
+        emit(p, BC_LOADC, dst, e->type != TYPE_INT, 0, e->slot);
+        return K_ANY;
+      case EXPR_UNARY: {
+        StaticKind k = compile_expr(p, e->un.sub, dst);
+        if (e->un.op == OP_NEG) {
+            emit(p, BC_NEG, dst, dst, 0, 0);
+            return k;
+        }
+        emit(p, BC_NOT, dst, dst, 0, 0);
+        return K_INT;
+      }
+      case EXPR_BINARY: {
+        Expr *rhs = e->bin.right;
+        if ((rhs->kind == EXPR_INT || rhs->kind == EXPR_FLOAT) &&
+            e->bin.op != OP_AND && e->bin.op != OP_OR) {
+            StaticKind l = compile_expr(p, e->bin.left, dst);
+            Opcode op;
+            switch (e->bin.op) {
+              case OP_ADD: op = BC_ADD_K; break;
+              case OP_SUB: op = BC_SUB_K; break;
+              case OP_MUL: op = BC_MUL_K; break;
+              case OP_DIV: op = BC_DIV_K; break;
+              case OP_GT:  op = BC_GT_K;  break;
+              case OP_LT:  op = BC_LT_K;  break;
+              case OP_GE:  op = BC_GE_K;  break;
+              case OP_LE:  op = BC_LE_K;  break;
+              case OP_EQ:  op = BC_EQ_K;  break;
+              default:     op = BC_NE_K;  break;
+            }
+            int at = emit(p, op, dst, dst, rhs->kind == EXPR_INT, 0);
+            p->code[at].f = rhs->kind == EXPR_INT ? (double)rhs->ival : rhs->fval;
+            if (op == BC_DIV_K) return K_FLOAT;
+            if (op > BC_DIV_K)  return K_INT;
+            return arith_kind(l, rhs->kind == EXPR_INT ? K_INT : K_FLOAT);
+        }
+        StaticKind l = compile_expr(p, e->bin.left,  dst);
+        StaticKind r = compile_expr(p, e->bin.right, dst + 1);
+        int ff = (l == K_FLOAT && r == K_FLOAT);
+        Opcode op;
+        switch (e->bin.op) {
+          case OP_ADD: op = ff ? BC_ADD_FF : BC_ADD; break;
+          case OP_SUB: op = ff ? BC_SUB_FF : BC_SUB; break;
+          case OP_MUL: op = ff ? BC_MUL_FF : BC_MUL; break;
+          case OP_DIV: op = ff ? BC_DIV_FF : BC_DIV; break;
+          case OP_GT:  op = BC_GT;  break;
+          case OP_LT:  op = BC_LT;  break;
+          case OP_GE:  op = BC_GE;  break;
+          case OP_LE:  op = BC_LE;  break;
+          case OP_EQ:  op = BC_EQ;  break;
+          case OP_NE:  op = BC_NE;  break;
+          case OP_AND: op = BC_AND; break;
+          default:     op = BC_OR;  break;
+        }
+        emit(p, op, dst, dst, dst + 1, 0);
+        if (op == BC_DIV || op == BC_DIV_FF) return K_FLOAT;
+        if (op > BC_DIV_FF)                  return K_INT;
+        return arith_kind(l, r);
+      }
+      case EXPR_CALL:
+        return compile_call(p, e, dst);
+      case EXPR_RANGE:
+        // isolado, vale 0 (como no interpretador)
+        emit(p, BC_LOADI, dst, 0, 0, 0);
+        return K_INT;
+    }
+    return K_ANY;
+}
+
+// ——— compilação de statements ————————————————————————————————————————————
+
+static void compile_stmts(VmProgram *p, Stmt *s) {
+    for (; s; s = s->next) {
+        switch (s->kind) {
+          case STMT_ASSIGN:
+            compile_expr(p, s->assign.expr, 0);
+            emit(p, BC_STOREC, 0, s->assign.type != TYPE_INT, 0, s->assign.slot);
+            break;
+          case STMT_IF: {
+            compile_expr(p, s->ifs.cond, 0);
+            int jf = emit(p, BC_JMPF, 0, 0, 0, 0);
+            compile_stmts(p, s->ifs.then_branch);
+            patch_jump(p, jf, p->n_code);
+            break;
+          }
+          case STMT_WHILE: {
+            int top = p->n_code;
+            compile_expr(p, s->whiles.cond, 0);
+            int jf = emit(p, BC_JMPF, 0, 0, 0, 0);
+            compile_stmts(p, s->whiles.body);
+            int jb = emit(p, BC_JMP, 0, 0, 0, 0);
+            patch_jump(p, jb, top);
+            patch_jump(p, jf, p->n_code);
+            break;
+          }
+          case STMT_TABLE:
+            emit(p, BC_TABLE, 0, 0, 0, 0);
+            break;
+          case STMT_EXPORT: {
+            int at = emit(p, BC_EXPORT, 0, 0, 0, 0);
+            p->code[at].s = s->exp.filename;
+            break;
+          }
+          case STMT_IMPORT: {
+            int at = emit(p, BC_IMPORT, 0, 0, 0, 0);
+            p->code[at].stmt = s;
+            break;
+          }
+          case STMT_SAVE:
+          case STMT_LOAD: {
+            int at = emit(p, s->kind == STMT_SAVE ? BC_SAVE : BC_LOAD, 0, 0, 0, 0);
+            p->code[at].s = s->exp.filename;
+            break;
+          }
+        }
+    }
+}
+
+VmProgram *vm_compile(Stmt *program) {
+    VmProgram *p = calloc(1, sizeof *p);
+    if (!p) exit(1);
+    p->n_regs = 1;
+    compile_stmts(p, program);
+    emit(p, BC_HALT, 0, 0, 0, 0);
+    return p;
+}
+
+void vm_free(VmProgram *p) {
+    if (!p) return;
+    for (int i = 0; i < p->n_descs; ++i) free(p->descs[i].items);
+    free(p->descs);
+    free(p->code);
+    free(p);
+}
+
+// ——— execução ————————————————————————————————————————————————————————————
+
+// copia os valores de um range do grid para buf, coluna a coluna
+static int64_t gather_range(const ValueStore *st, const AggItem *it, double *buf) {
+    int64_t k = 0;
+    for (int64_t c = 0; c < it->cols; ++c) {
+        const double *col = st->num + it->slot + c * st->layout->nrows;
+        for (int64_t r = 0; r < it->rows; ++r) buf[k++] = col[r];
+    }
+    return k;
+}
+
+#define NUM(v) value_num(v)
+
+int vm_run(VmProgram *p) {
+    ValueStore st;
+    store_init(&st, sema_layout());
+    Value  *R   = calloc(p->n_regs, sizeof *R);
+    double *buf = malloc((p->max_count > 0 ? p->max_count : 1) * sizeof *buf);
+    // índices dos descritores marcados; o store os mantém e libera
+    RangeIndex **ix = calloc(p->n_descs ? p->n_descs : 1, sizeof *ix);
+    if (!R || !buf || !ix) exit(1);
+    for (int i = 0; i < p->n_descs; ++i) {
+        const AggItem *it = &p->descs[i].items[0];
+        if (!p->descs[i].indexed || p->descs[i].nitems != 1) continue;
+        ix[i] = rindex_new(it->slot, it->rows, it->cols, st.layout->nrows);
+        store_add_rindex(&st, ix[i]);
+    }
+    int rc = 0;
+
+    const Instr *ip = p->code;
+
+#if defined(__GNUC__)
+    // dispatch "threaded": cada handler salta direto para o próximo
+    static void *labels[BC_COUNT] = {
+        [BC_HALT] = &&L_HALT,     [BC_LOADI] = &&L_LOADI,
+        [BC_LOADF] = &&L_LOADF,   [BC_LOADS] = &&L_LOADS,
+        [BC_LOADC] = &&L_LOADC,   [BC_STOREC] = &&L_STOREC,
+        [BC_NEG] = &&L_NEG,       [BC_NOT] = &&L_NOT,
+        [BC_ADD] = &&L_ADD,       [BC_SUB] = &&L_SUB,
+        [BC_MUL] = &&L_MUL,       [BC_DIV] = &&L_DIV,
+        [BC_ADD_FF] = &&L_ADD_FF, [BC_SUB_FF] = &&L_SUB_FF,
+        [BC_MUL_FF] = &&L_MUL_FF, [BC_DIV_FF] = &&L_DIV_FF,
+        [BC_ADD_K] = &&L_ADD_K,   [BC_SUB_K] = &&L_SUB_K,
+        [BC_MUL_K] = &&L_MUL_K,   [BC_DIV_K] = &&L_DIV_K,
+        [BC_GT] = &&L_GT, [BC_LT] = &&L_LT, [BC_GE] = &&L_GE,
+        [BC_LE] = &&L_LE, [BC_EQ] = &&L_EQ, [BC_NE] = &&L_NE,
+        [BC_GT_K] = &&L_GT_K, [BC_LT_K] = &&L_LT_K, [BC_GE_K] = &&L_GE_K,
+        [BC_LE_K] = &&L_LE_K, [BC_EQ_K] = &&L_EQ_K, [BC_NE_K] = &&L_NE_K,
+        [BC_AND] = &&L_AND,       [BC_OR] = &&L_OR,
+        [BC_JMP] = &&L_JMP,       [BC_JMPF] = &&L_JMPF,
+        [BC_AGG_RANGE] = &&L_AGG_RANGE, [BC_AGG] = &&L_AGG,
+        [BC_TABLE] = &&L_TABLE,   [BC_EXPORT] = &&L_EXPORT,
+        [BC_IMPORT] = &&L_IMPORT, [BC_SAVE] = &&L_SAVE,
+        [BC_LOAD] = &&L_LOAD,
+    };
+#define CASE(op)  L_##op:
+#define NEXT()    do { ++ip; goto *labels[ip->op]; } while (0)
+#define JUMP(off) do { ip += 1 + (off); goto *labels[ip->op]; } while (0)
+    goto *labels[ip->op];
+#else
+#define CASE(op)  case BC_##op:
+#define NEXT()    do { ++ip; goto dispatch; } while (0)
+#define JUMP(off) do { ip += 1 + (off); goto dispatch; } while (0)
+dispatch:
+    switch (ip->op) {
+#endif
+
+    CASE(LOADI)  R[ip->a] = (Value){.kind = V_INT,   .ival = ip->k};      NEXT();
+    CASE(LOADF)  R[ip->a] = (Value){.kind = V_FLOAT, .fval = ip->f};      NEXT();
+    CASE(LOADS)  R[ip->a] = (Value){.kind = V_TEXT,  .sval = ip->s};      NEXT();
+    CASE(LOADC) {
+        Value v = store_get(&st, ip->k);
+        R[ip->a] = ip->b ? value_float(v) : v;
+        NEXT();
+    }
+    CASE(STOREC)
+        store_set(&st, ip->k, ip->b ? value_float(R[ip->a]) : R[ip->a]);
+        NEXT();
+
+    CASE(NEG) {
+        Value v = R[ip->b];
+        if (v.kind == V_FLOAT) v.fval = -v.fval;
+        else if (v.kind == V_INT && v.ival == INT64_MIN)
+            v = (Value){.kind = V_FLOAT, .fval = -(double)v.ival};
+        else                   v.ival = -v.ival;
+        R[ip->a] = v;
+        NEXT();
+    }
+    CASE(NOT)
+        R[ip->a] = (Value){.kind = V_INT, .ival = !value_truth(R[ip->b])};
+        NEXT();
+
+// inteiros: V_INT enquanto o resultado cabe em 64 bits; o estouro cai na
+// conta em double, como no interpretador
+#define ARITH(OP, op, checked)                                                  \
+    CASE(OP) {                                                                  \
+        int64_t v;                                                              \
+        if (R[ip->b].kind == V_INT && R[ip->c].kind == V_INT &&                 \
+            !checked(R[ip->b].ival, R[ip->c].ival, &v))                         \
+            R[ip->a] = (Value){.kind = V_INT, .ival = v};                       \
+        else                                                                    \
+            R[ip->a] = (Value){.kind = V_FLOAT,                                 \
+                               .fval = NUM(R[ip->b]) op NUM(R[ip->c])};         \
+        NEXT();                                                                 \
+    }                                                                           \
+    CASE(OP##_FF)                                                               \
+        R[ip->a] = (Value){.kind = V_FLOAT,                                     \
+                           .fval = R[ip->b].fval op R[ip->c].fval};             \
+        NEXT();                                                                 \
+    CASE(OP##_K) {                                                              \
+        int64_t v;                                                              \
+        if (ip->c && R[ip->b].kind == V_INT &&                                  \
+            !checked(R[ip->b].ival, (int64_t)ip->f, &v))                        \
+            R[ip->a] = (Value){.kind = V_INT, .ival = v};                       \
+        else                                                                    \
+            R[ip->a] = (Value){.kind = V_FLOAT,                                 \
+                               .fval = NUM(R[ip->b]) op ip->f};                 \
+        NEXT();                                                                 \
+    }
+    ARITH(ADD, +, __builtin_add_overflow)
+    ARITH(SUB, -, __builtin_sub_overflow)
+    ARITH(MUL, *, __builtin_mul_overflow)
+
+    CASE(DIV)
+        R[ip->a] = (Value){.kind = V_FLOAT,
+                           .fval = NUM(R[ip->b]) / NUM(R[ip->c])};
+        NEXT();
+    CASE(DIV_FF)
+        R[ip->a] = (Value){.kind = V_FLOAT, .fval = R[ip->b].fval / R[ip->c].fval};
+        NEXT();
+    CASE(DIV_K)
+        R[ip->a] = (Value){.kind = V_FLOAT, .fval = NUM(R[ip->b]) / ip->f};
+        NEXT();
+
+// comparações entre dois V_INT são exatas, as demais em double
+#define CMP(OP, op)                                                          \
+    CASE(OP)                                                                 \
+        R[ip->a] = (Value){.kind = V_INT,                                    \
+                           .ival = R[ip->b].kind == V_INT &&                 \
+                                   R[ip->c].kind == V_INT                    \
+                                     ? R[ip->b].ival op R[ip->c].ival        \
+                                     : NUM(R[ip->b]) op NUM(R[ip->c])};      \
+        NEXT();                                                              \
+    CASE(OP##_K)                                                             \
+        R[ip->a] = (Value){.kind = V_INT,                                    \
+                           .ival = ip->c && R[ip->b].kind == V_INT           \
+                                     ? R[ip->b].ival op (int64_t)ip->f       \
+                                     : NUM(R[ip->b]) op ip->f};              \
+        NEXT();
+    CMP(GT, >)
+    CMP(LT, <)
+    CMP(GE, >=)
+    CMP(LE, <=)
+    CMP(EQ, ==)
+    CMP(NE, !=)
+
+    CASE(AND)
+        R[ip->a] = (Value){.kind = V_INT,
+                           .ival = (int)NUM(R[ip->b]) && (int)NUM(R[ip->c])};
+        NEXT();
+    CASE(OR)
+        R[ip->a] = (Value){.kind = V_INT,
+                           .ival = (int)NUM(R[ip->b]) || (int)NUM(R[ip->c])};
+        NEXT();
+
+    CASE(JMP)  JUMP(ip->k);
+    CASE(JMPF)
+        if (!value_truth(R[ip->a])) JUMP(ip->k);
+        NEXT();
+
+    CASE(AGG_RANGE) {
+        if (ix[ip->k]) {
+            R[ip->a] = (Value){.kind = V_FLOAT,
+                               .fval = rindex_query(ix[ip->k], ip->b, st.num)};
+            NEXT();
+        }
+        const AggDesc *d = &p->descs[ip->k];
+        int64_t n = gather_range(&st, &d->items[0], buf);
+        AggArg all = { buf, n, 1, n };
+        R[ip->a] = (Value){.kind = V_FLOAT, .fval = agg_helper(ip->b, 1, &all)};
+        NEXT();
+    }
+    CASE(AGG) {
+        const AggDesc *d = &p->descs[ip->k];
+        int64_t n = 0;
+        for (int i = 0; i < d->nitems; ++i) {
+            const AggItem *it = &d->items[i];
+            if (it->is_range) n += gather_range(&st, it, buf + n);
+            else              buf[n++] = NUM(R[it->reg]);
+        }
+        AggArg all = { buf, n, 1, n };
+        R[ip->a] = (Value){.kind = V_FLOAT, .fval = agg_helper(ip->b, 1, &all)};
+        NEXT();
+    }
+
+    CASE(TABLE)
+        store_table(&st);
+        NEXT();
+    CASE(EXPORT)
+        if (store_export(&st, ip->s)) { rc = 1; goto done; }
+        NEXT();
+    CASE(IMPORT)
+        if (store_import(&st, ip->stmt->imp.filename, ip->stmt->imp.col,
+                         ip->stmt->imp.row, NULL)) { rc = 1; goto done; }
+        NEXT();
+    CASE(SAVE)
+        if (store_save(&st, ip->s)) { rc = 1; goto done; }
+        NEXT();
+    CASE(LOAD)
+        if (store_load(&st, ip->s, NULL)) { rc = 1; goto done; }
+        NEXT();
+
+    CASE(HALT)
+        goto done;
+
+#if !defined(__GNUC__)
+    default:
+        goto done;
+    }
+#endif
+
+done:
+    free(ix);
+    free(buf);
+    free(R);
+    store_free(&st);
+    return rc;
+}
@@ -0,0 +1,26 @@
+// vm.h
+// Terceiro engine de execução: o AST é traduzido para um bytecode linear de
+// registradores e executado por uma VM com dispatch "threaded" (computed
+// goto). Semântica idêntica à do interpretador (interp.c), sem o custo de
+// inicializar o LLVM.
+#ifndef LANGCELL_VM_H
+#define LANGCELL_VM_H
+
+#include "ast.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct VmProgram VmProgram;
+
+// Traduz o programa para bytecode; requer analyze_program(program) antes
+VmProgram *vm_compile(Stmt *program);
+int        vm_run(VmProgram *p);
+void       vm_free(VmProgram *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANGCELL_VM_H